@@ -81,6 +81,7 @@ CaptureSettings::operator QVariant() const
   opts["SaveAllInitials"] = Options.SaveAllInitials;
   opts["CaptureAllCmdLists"] = Options.CaptureAllCmdLists;
   opts["DebugOutputMute"] = Options.DebugOutputMute;
+  opts["TrackMapWrites"] = Options.TrackMapWrites;
   ret["Options"] = opts;
 
   return ret;
@@ -117,6 +118,7 @@ CaptureSettings::CaptureSettings(const QVariant &v)
   Options.SaveAllInitials = opts["SaveAllInitials"].toBool();
   Options.CaptureAllCmdLists = opts["CaptureAllCmdLists"].toBool();
   Options.DebugOutputMute = opts["DebugOutputMute"].toBool();
+  Options.TrackMapWrites = opts["TrackMapWrites"].toBool();
 }
 
 QString ConfigFilePath(const QString &filename)
@@ -191,6 +191,20 @@ typedef enum {
   // 0 - API debugging is displayed as normal
   eRENDERDOC_Option_DebugOutputMute = 11,
 
+  // Track CPU writes to persistently mapped memory at page granularity, by write-protecting the
+  // mapped pages and catching the first write to each. Only pages written by the application are
+  // then compared and saved, instead of the whole mapped range on every submission.
+  //
+  // Note that writes made by the kernel rather than the application, e.g. read() directly into a
+  // mapped pointer, aren't caught by the fault handler and the system call fails with EFAULT. Don't
+  // enable this for applications that do that.
+  //
+  // Default - disabled
+  //
+  // 1 - Mapped pages are write-protected and writes are tracked where the platform supports it
+  // 0 - Mapped memory is compared against a shadow copy on every submission
+  eRENDERDOC_Option_TrackMapWrites = 12,
+
 } RENDERDOC_CaptureOption;
 
 // Sets an option that controls how RenderDoc behaves on capture.
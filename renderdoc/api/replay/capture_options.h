@@ -178,4 +178,20 @@ Default - enabled
 ``False`` - API debugging is displayed as normal.
 )");
   bool32 DebugOutputMute;
+
+  DOCUMENT(R"(Track CPU writes to persistently mapped memory at page granularity.
+
+Default - disabled
+
+``True`` - mapped pages are write-protected and the first write to each page is caught, so only
+pages written by the application are compared and saved. Platforms or memory that don't support
+changing page protection fall back to the default behaviour.
+
+.. note:: Writes made by the kernel rather than the application, such as ``read()`` directly into
+  a mapped pointer, can't be caught and the system call fails with ``EFAULT``. Leave this disabled
+  for applications that do that.
+
+``False`` - persistently mapped memory is compared against a shadow copy on every submission.
+)");
+  bool32 TrackMapWrites;
 };
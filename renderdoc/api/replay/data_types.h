@@ -267,6 +267,40 @@ struct DebugMessage
 
 DECLARE_REFLECTION_STRUCT(DebugMessage);
 
+DOCUMENT(R"(Accumulated statistics for one type of chunk in a capture, gathered while loading or
+replaying it.
+
+Statistics are only gathered when the ``replay.chunkTimings`` config setting is enabled before the
+capture is opened.
+)");
+struct ChunkProfile
+{
+  DOCUMENT("The name of this type of chunk.");
+  rdctype::str name;
+
+  DOCUMENT("The API-specific identifier for this type of chunk.");
+  uint32_t chunkID;
+
+  DOCUMENT(R"(``True`` if these statistics were gathered while loading the capture, ``False`` if
+they were gathered while replaying it.
+)");
+  bool32 loading;
+
+  DOCUMENT("The number of chunks of this type that were processed.");
+  uint32_t count;
+
+  DOCUMENT("The total size in bytes of the serialised data in these chunks.");
+  uint64_t totalBytes;
+
+  DOCUMENT("The total time in milliseconds spent deserialising these chunks' parameters.");
+  double decodeTime;
+
+  DOCUMENT("The total time in milliseconds spent executing these chunks after deserialisation.");
+  double executeTime;
+};
+
+DECLARE_REFLECTION_STRUCT(ChunkProfile);
+
 DOCUMENT(R"(The type of bucketing method for recording statistics.
 
 .. data:: Linear
@@ -962,6 +996,29 @@ struct CounterResult
 
 DECLARE_REFLECTION_STRUCT(CounterResult);
 
+DOCUMENT(R"(Statistics for an event's GPU duration, gathered over repeated replays by
+:meth:`ReplayController.BenchmarkEventDurations`.
+)");
+struct EventDurationStats
+{
+  DOCUMENT("The :data:`EID <APIEvent.eventID>` that was timed.");
+  uint32_t eventID;
+
+  DOCUMENT("The number of timed replays the statistics were calculated from.");
+  uint32_t samples;
+
+  DOCUMENT("The median duration in seconds.");
+  double median;
+
+  DOCUMENT("The minimum duration in seconds.");
+  double minimum;
+
+  DOCUMENT("The median absolute deviation from the median duration, in seconds.");
+  double medianAbsDeviation;
+};
+
+DECLARE_REFLECTION_STRUCT(EventDurationStats);
+
 DOCUMENT("The contents of an RGBA pixel.");
 union PixelValue
 {
@@ -597,6 +597,24 @@ See :meth:`BuildTargetShader`.
 )");
   virtual rdctype::array<CounterResult> FetchCounters(const rdctype::array<GPUCounter> &counters) = 0;
 
+  DOCUMENT(R"(Time events on the GPU over several replays to get stable figures, as a single replay
+can vary a lot from clock changes, caches and first-use costs.
+
+The replay is repeated ``warmupPasses`` times without measuring, then ``passes`` times with each
+event's :data:`GPUCounter.EventGPUDuration` recorded.
+
+:param int warmupPasses: The number of replays to discard before measuring.
+:param int passes: The number of replays to measure.
+:param int isolateEventID: If non-zero, only this event is timed. Before each measurement the
+  replay sets up the event's state without executing it, and then only the event itself is timed.
+  If the implementation can't isolate events, the list is empty.
+:return: The statistics for each event that was timed.
+:rtype: ``list`` of :class:`EventDurationStats`
+)");
+  virtual rdctype::array<EventDurationStats> BenchmarkEventDurations(uint32_t warmupPasses,
+                                                                     uint32_t passes,
+                                                                     uint32_t isolateEventID) = 0;
+
   DOCUMENT(R"(Retrieve a list of which counters are available in the current capture analysis
 implementation.
 
@@ -648,6 +666,17 @@ newly generated messages will be returned after that.
 )");
   virtual rdctype::array<DebugMessage> GetDebugMessages() = 0;
 
+  DOCUMENT(R"(Retrieve the per chunk-type statistics gathered while loading and replaying the
+capture, sorted with the most expensive chunk types first.
+
+This is empty unless the ``replay.chunkTimings`` config setting was enabled before the capture was
+opened.
+
+:return: The list of the :class:`ChunkProfile` statistics.
+:rtype: ``list`` of :class:`ChunkProfile`
+)");
+  virtual rdctype::array<ChunkProfile> GetChunkProfile() = 0;
+
   DOCUMENT(R"(Retrieve the history of modifications to the selected pixel on the selected texture.
 
 :param ResourceId texture: The texture to search for modifications.
@@ -717,6 +746,30 @@ newly generated messages will be returned after that.
 )");
   virtual rdctype::array<EventUsage> GetUsage(ResourceId id) = 0;
 
+  DOCUMENT(R"(Retrieve the uses of a given resource within a range of events. This is cheaper than
+filtering the results of :meth:`GetUsage` when a resource is used many times.
+
+:param ResourceId id: The id of the texture or buffer resource to be queried.
+:param int minEventID: The first :data:`EID <APIEvent.eventID>` to include.
+:param int maxEventID: The last :data:`EID <APIEvent.eventID>` to include.
+:param bool writesOnly: ``True`` if only uses that could modify the resource should be returned.
+:return: The list of usages of the resource in the range, sorted by event.
+:rtype: ``list`` of :class:`EventUsage`
+)");
+  virtual rdctype::array<EventUsage> GetUsageInRange(ResourceId id, uint32_t minEventID,
+                                                     uint32_t maxEventID, bool writesOnly) = 0;
+
+  DOCUMENT(R"(Retrieve the last use of a given resource that could have modified it, at or before
+a given event.
+
+:param ResourceId id: The id of the texture or buffer resource to be queried.
+:param int eventID: The :data:`EID <APIEvent.eventID>` to search back from.
+:return: The writing usage, or a usage with an :data:`EID <EventUsage.eventID>` of 0 if the resource
+  isn't written at or before ``eventID``.
+:rtype: EventUsage
+)");
+  virtual EventUsage GetLastWrite(ResourceId id, uint32_t eventID) = 0;
+
   DOCUMENT(R"(Retrieve the contents of a constant block by reading from memory or their source
 otherwise.
 
@@ -1371,6 +1424,9 @@ DOCUMENT("Internal function for triggering exception handler.");
 extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_TriggerExceptionHandler(void *exceptionPtrs,
                                                                              bool32 crashed);
 
+DOCUMENT("Internal function for running self-tests, returns the number that failed.");
+extern "C" RENDERDOC_API uint32_t RENDERDOC_CC RENDERDOC_RunSelfTests(const char *filter);
+
 DOCUMENT(R"(Sets the location for the diagnostic log output, shared by captured programs and the
 analysis program.
 
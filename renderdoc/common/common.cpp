@@ -166,7 +166,7 @@ bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &
     // if we haven't even found a start, check in these bytes
     if(diffStart > bufSize)
     {
-      offs = bufSize;
+      offs = alignedSize;
 
       for(size_t by = 0; by < numBytes; by++)
       {
@@ -223,6 +223,55 @@ bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &
   return diffStart < bufSize;
 }
 
+bool FindDiffRanges(void *a, void *b, size_t bufSize,
+                    std::vector<std::pair<size_t, size_t> > &ranges)
+{
+  ranges.clear();
+
+  byte *abyte = (byte *)a;
+  byte *bbyte = (byte *)b;
+
+  const size_t numPages = (bufSize + DiffPageSize - 1) / DiffPageSize;
+
+  size_t page = 0;
+  while(page < numPages)
+  {
+    size_t offs = page * DiffPageSize;
+    size_t len = RDCMIN(DiffPageSize, bufSize - offs);
+
+    if(memcmp(abyte + offs, bbyte + offs, len) == 0)
+    {
+      page++;
+      continue;
+    }
+
+    // extend over the whole run of dirty pages
+    size_t firstPage = page;
+    page++;
+    while(page < numPages)
+    {
+      offs = page * DiffPageSize;
+      len = RDCMIN(DiffPageSize, bufSize - offs);
+
+      if(memcmp(abyte + offs, bbyte + offs, len) == 0)
+        break;
+
+      page++;
+    }
+
+    // trim the run down to the exact differing bytes. Page offsets keep the 16-byte alignment
+    // FindDiffRange requires.
+    size_t runStart = firstPage * DiffPageSize;
+    size_t runSize = RDCMIN(page * DiffPageSize, bufSize) - runStart;
+
+    size_t diffStart = 0, diffEnd = 0;
+    if(FindDiffRange(abyte + runStart, bbyte + runStart, runSize, diffStart, diffEnd))
+      ranges.push_back(std::make_pair(runStart + diffStart, runStart + diffEnd));
+  }
+
+  return !ranges.empty();
+}
+
 uint32_t CalcNumMips(int w, int h, int d)
 {
   int mipLevels = 1;
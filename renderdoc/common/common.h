@@ -152,10 +152,28 @@ inline T AlignUpPtr(T x, A a)
   return (T)AlignUp<uintptr_t>((uintptr_t)x, (uintptr_t)a);
 }
 
+template <typename T>
+inline T AlignDown(T x, T a)
+{
+  return x & (~(a - 1));
+}
+
+template <typename T, typename A>
+inline T AlignDownPtr(T x, A a)
+{
+  return (T)AlignDown<uintptr_t>((uintptr_t)x, (uintptr_t)a);
+}
+
 #define MAKE_FOURCC(a, b, c, d) \
   (((uint32_t)(d) << 24) | ((uint32_t)(c) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(a))
 
 bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd);
+// similar to FindDiffRange, but compares page by page and returns each run of differing pages
+// trimmed to the exact differing bytes, as [start, end) pairs. Scattered small writes across a
+// large buffer then give several small ranges instead of one range spanning all of them.
+static const size_t DiffPageSize = 4096;
+bool FindDiffRanges(void *a, void *b, size_t bufSize,
+                    std::vector<std::pair<size_t, size_t> > &ranges);
 uint32_t CalcNumMips(int Width, int Height, int Depth);
 
 uint32_t Log2Floor(uint32_t value);
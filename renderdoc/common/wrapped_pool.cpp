@@ -0,0 +1,150 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "wrapped_pool.h"
+#include "core/core.h"
+#include "os/os_specific.h"
+
+// a deliberately tiny pool, so the stress test below has to add many additional pools and move
+// slots between them.
+struct PoolTestItem
+{
+  uint32_t owner;
+  uint32_t seq;
+
+  ALLOCATE_WITH_WRAPPED_POOL(PoolTestItem, 16);
+};
+
+WRAPPED_POOL_INST(PoolTestItem);
+
+struct PoolStressThread
+{
+  uint32_t id;
+  uint32_t iterations;
+  volatile int32_t *failures;
+};
+
+static void PoolStressEntry(void *param)
+{
+  PoolStressThread *thread = (PoolStressThread *)param;
+
+  const uint32_t MaxLive = 64;
+  PoolTestItem *live[MaxLive] = {};
+  uint32_t numLive = 0;
+
+  uint32_t rand = thread->id * 2654435761U + 1;
+
+  for(uint32_t i = 0; i < thread->iterations; i++)
+  {
+    rand = rand * 1664525U + 1013904223U;
+
+    // grow and shrink the live set in alternating bursts so pools repeatedly fill up and drain
+    uint32_t allocChance = ((i / 1000) % 2) ? 70 : 30;
+    bool alloc = numLive == 0 || (numLive < MaxLive && (rand >> 16) % 100 < allocChance);
+
+    if(alloc)
+    {
+      PoolTestItem *item = new PoolTestItem;
+      item->owner = thread->id;
+      item->seq = i;
+      live[numLive++] = item;
+    }
+    else
+    {
+      uint32_t idx = (rand >> 8) % numLive;
+      PoolTestItem *item = live[idx];
+
+      // if the slot had been handed out to anyone else in the meantime, they would have stamped
+      // it with their own id
+      if(item->owner != thread->id || !PoolTestItem::IsAlloc(item))
+        Atomic::Inc32(thread->failures);
+
+      delete item;
+      live[idx] = live[--numLive];
+    }
+  }
+
+  for(uint32_t i = 0; i < numLive; i++)
+  {
+    if(live[i]->owner != thread->id)
+      Atomic::Inc32(thread->failures);
+    delete live[i];
+  }
+}
+
+static bool SelfTest()
+{
+  const uint32_t NumThreads = 8;
+
+  volatile int32_t failures = 0;
+
+  PoolStressThread threads[NumThreads];
+  Threading::ThreadHandle handles[NumThreads];
+
+  for(uint32_t i = 0; i < NumThreads; i++)
+  {
+    threads[i].id = i + 1;
+    threads[i].iterations = 200000;
+    threads[i].failures = &failures;
+
+    handles[i] = Threading::CreateThread(&PoolStressEntry, &threads[i]);
+  }
+
+  for(uint32_t i = 0; i < NumThreads; i++)
+  {
+    Threading::JoinThread(handles[i]);
+    Threading::CloseThread(handles[i]);
+  }
+
+  if(failures != 0)
+  {
+    RDCERR("%d pool slots were handed out while still allocated", failures);
+    return false;
+  }
+
+  // every slot has been freed, so a full pool's worth of allocations must all be distinct and
+  // recognised by the pool
+  PoolTestItem *items[PoolTestItem::PoolType::AllocCount * 4];
+  bool ret = true;
+
+  for(size_t i = 0; i < ARRAY_COUNT(items); i++)
+  {
+    items[i] = new PoolTestItem;
+    items[i]->owner = uint32_t(i);
+  }
+
+  for(size_t i = 0; i < ARRAY_COUNT(items); i++)
+  {
+    if(items[i]->owner != uint32_t(i) || !PoolTestItem::IsAlloc(items[i]))
+      ret = false;
+    delete items[i];
+  }
+
+  if(!ret)
+    RDCERR("Pool slots were handed out twice after the stress test");
+
+  return ret;
+}
+
+static SelfTestRegistration WrappingPoolTest("common.wrappedpool", &SelfTest);
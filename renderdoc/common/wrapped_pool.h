@@ -49,26 +49,35 @@ public:
 };
 
 // allocate each class in its own pool so we can identify the type by the pointer
+//
+// Allocation and deallocation are lock-free:
+// - each pool keeps its free slots in an intrusive lock-free stack.
+// - pools that have free slots are kept on a lock-free stack, so when the pool we last allocated
+//   from fills up we can go straight to one with space instead of scanning.
+// The lock is only taken on the rare path when every pool is full and a new additional pool must
+// be created.
 template <typename WrapType, int PoolCount = 8192, int MaxPoolByteSize = 1024 * 1024, bool DebugClear = true>
 class WrappingPool
 {
 public:
   void *Allocate()
   {
-    SCOPED_LOCK(m_Lock);
+    // try the pool we last allocated from. Index 0 is the immediate pool, then 1..N map to
+    // additional pools
+    void *ret = GetPool(m_CurrentPool)->Allocate();
+    if(ret != NULL)
+      return ret;
 
-    // try and allocate from immediate pool
-    void *ret = m_ImmediatePool.Allocate();
+    ret = AllocateFromAvailable();
     if(ret != NULL)
       return ret;
 
-    // fall back to additional pools, if there are any
-    for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-    {
-      ret = m_AdditionalPools[i]->Allocate();
-      if(ret != NULL)
-        return ret;
-    }
+    SCOPED_LOCK(m_Lock);
+
+    // another thread may have added a pool or freed slots while we were waiting on the lock
+    ret = AllocateFromAvailable();
+    if(ret != NULL)
+      return ret;
 
 // warn when we need to allocate an additional pool
 #if ENABLED(INCLUDE_TYPE_NAMES)
@@ -77,69 +86,63 @@ public:
     RDCWARN("Ran out of free slots in pool 0x%p!", &m_ImmediatePool.items[0]);
 #endif
 
-    // allocate a new additional pool and use that to allocate from
-    m_AdditionalPools.push_back(new ItemPool());
+    int32_t idx = m_NumAdditionalPools;
 
-#if ENABLED(INCLUDE_TYPE_NAMES)
-    RDCDEBUG("WrappingPool[%d]<%s>: %p -> %p", (uint32_t)m_AdditionalPools.size() - 1,
-             GetTypeName<WrapType>::Name(), &m_AdditionalPools.back()->items[0],
-             &m_AdditionalPools.back()->items[AllocCount - 1]);
-#endif
+    if(ChunkIndex(idx) >= (uint32_t)MaxChunks)
+    {
+      RDCFATAL("Exhausted all additional pools");
+      return NULL;
+    }
 
-    return m_AdditionalPools.back()->Allocate();
-  }
+    ItemPool **&chunk = m_PoolChunks[ChunkIndex(idx)];
 
-  bool IsAlloc(const void *p)
-  {
-    // we can check the immediate pool without locking
-    if(m_ImmediatePool.IsAlloc(p))
-      return true;
+    if(chunk == NULL)
+      chunk = new ItemPool *[ChunkSize(ChunkIndex(idx))];
 
-    // if we have additional pools, lock and check them.
-    // TODO: Check for additional pools in a lock-free manner,
-    // to prevent the cost of locking if there are no more pools.
-    {
-      SCOPED_LOCK(m_Lock);
+    // allocate a new additional pool and use that to allocate from. We allocate our item before
+    // publishing the pool so we can't be starved by other threads.
+    ItemPool *pool = new ItemPool();
+    ret = pool->Allocate();
 
-      for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-        if(m_AdditionalPools[i]->IsAlloc(p))
-          return true;
-    }
+    chunk[ChunkOffset(idx)] = pool;
+    Atomic::Inc32(&m_NumAdditionalPools);
+    m_CurrentPool = idx + 1;
+
+    MarkAvailable(idx + 1);
+
+#if ENABLED(INCLUDE_TYPE_NAMES)
+    RDCDEBUG("WrappingPool[%d]<%s>: %p -> %p", idx, GetTypeName<WrapType>::Name(),
+             &pool->items[0], &pool->items[AllocCount - 1]);
+#endif
 
-    return false;
+    return ret;
   }
 
+  bool IsAlloc(const void *p) { return FindPool(p) >= 0; }
   void Deallocate(void *p)
   {
-    SCOPED_LOCK(m_Lock);
+    int32_t idx = FindPool(p);
 
-    // try immediate pool
-    if(m_ImmediatePool.IsAlloc(p))
-    {
-      m_ImmediatePool.Deallocate(p);
-      return;
-    }
-    else if(!m_AdditionalPools.empty())
+    if(idx < 0)
     {
-      // fall back and try additional pools
-      for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-      {
-        if(m_AdditionalPools[i]->IsAlloc(p))
-        {
-          m_AdditionalPools[i]->Deallocate(p);
-          return;
-        }
-      }
-    }
-
 // this is an error - deleting an object that we don't recognise
 #if ENABLED(INCLUDE_TYPE_NAMES)
-    RDCERR("Resource being deleted through wrong pool - 0x%p not a member of %s", p,
-           GetTypeName<WrapType>::Name());
+      RDCERR("Resource being deleted through wrong pool - 0x%p not a member of %s", p,
+             GetTypeName<WrapType>::Name());
 #else
-    RDCERR("Resource being deleted through wrong pool - 0x%p not a member of 0x%p", p,
-           &m_ImmediatePool.items[0]);
+      RDCERR("Resource being deleted through wrong pool - 0x%p not a member of 0x%p", p,
+             &m_ImmediatePool.items[0]);
 #endif
+      return;
+    }
+
+#if ENABLED(RDOC_DEVEL)
+    memset(p, 0xfe, DebugClear ? AllocByteSize : 0);
+#endif
+
+    // if the pool was full it now has a free slot, so make it available to allocate from again
+    if(GetPool(idx)->Deallocate(p))
+      MarkAvailable(idx);
   }
 
   static const size_t AllocCount = PoolCount;
@@ -148,7 +151,14 @@ public:
 
 private:
   WrappingPool()
+      : m_NumAdditionalPools(0),
+        m_CurrentPool(0),
+        m_AvailableHead(ItemPool::MakeHead(0, -1))
   {
+    RDCEraseEl(m_PoolChunks);
+
+    MarkAvailable(0);
+
 #if ENABLED(INCLUDE_TYPE_NAMES)
     // hack - print in kB because float printing relies on statics that might not be initialised
     // yet in loading order. Ugly :(
@@ -159,93 +169,208 @@ private:
   }
   ~WrappingPool()
   {
-    for(size_t i = 0; i < m_AdditionalPools.size(); i++)
-      delete m_AdditionalPools[i];
+    for(int32_t i = 0; i < m_NumAdditionalPools; i++)
+      delete GetPool(i + 1);
+
+    for(int32_t c = 0; c < MaxChunks; c++)
+      delete[] m_PoolChunks[c];
 
-    m_AdditionalPools.clear();
+    m_NumAdditionalPools = 0;
   }
 
   Threading::CriticalSection m_Lock;
 
   struct ItemPool
   {
-    ItemPool()
+    ItemPool() : nextAvailable(-1), available(0)
     {
-      lastAllocIdx = 0;
-      RDCEraseEl(allocated);
+      // chain every slot into the free list in order, so we allocate contiguously from the start
+      for(int32_t i = 0; i < PoolCount; i++)
+        nextFree[i] = i + 1;
+      nextFree[PoolCount - 1] = -1;
+
+      freeHead = MakeHead(0, 0);
 
       items = (WrapType *)(new uint8_t[AllocCount * AllocByteSize]);
     }
     ~ItemPool() { delete[](uint8_t *) items; }
     void *Allocate()
     {
-      int lastAlloc = lastAllocIdx;
-
-      if(allocated[lastAlloc])
+      for(;;)
       {
-        int end = lastAlloc;
-
-        do
-        {
-          lastAlloc = (lastAlloc + 1) % PoolCount;
-        } while(allocated[lastAlloc] && lastAlloc != end);
+        int64_t head = freeHead;
+        int32_t idx = HeadIndex(head);
 
-        if(allocated[lastAlloc])
-        {
+        if(idx < 0)
           return NULL;
-        }
-      }
 
-      void *ret = (void *)&items[lastAlloc];
-      allocated[lastAlloc] = true;
+        // nextFree[idx] may be stale if another thread pops idx first, but then the tag in the
+        // head will have changed and the exchange below fails, so we never use a stale value.
+        int64_t newHead = MakeHead(HeadTag(head) + 1, nextFree[idx]);
+
+        if(Atomic::CmpExch64(&freeHead, head, newHead) == head)
+        {
+          void *ret = (void *)&items[idx];
 
 #if ENABLED(RDOC_DEVEL)
-      memset(ret, 0xb0, AllocByteSize);
+          memset(ret, 0xb0, AllocByteSize);
 #endif
 
-      lastAllocIdx = lastAlloc;
-
-      return ret;
+          return ret;
+        }
+      }
     }
 
-    void Deallocate(void *p)
+    // returns true if the pool was full before this slot was freed
+    bool Deallocate(void *p)
     {
       RDCASSERT(IsAlloc(p));
 
-#if ENABLED(RDOC_DEVEL)
-      if(!IsAlloc(p))
-      {
-        RDCERR("Resource being deleted through wrong pool - 0x%p not a memory of 0x%p", p, &items[0]);
-        return;
-      }
-#endif
+      int32_t idx = int32_t((WrapType *)p - &items[0]);
 
-      size_t idx = (WrapType *)p - &items[0];
+      // push onto the free list. Freed slots are reused first, which handles repeated new/free
+      // well by reallocating the same element.
+      for(;;)
+      {
+        int64_t head = freeHead;
+        nextFree[idx] = HeadIndex(head);
 
-      allocated[idx] = false;
+        int64_t newHead = MakeHead(HeadTag(head) + 1, idx);
 
-#if ENABLED(RDOC_DEVEL)
-      memset(p, 0xfe, DebugClear ? AllocByteSize : 0);
-#endif
+        if(Atomic::CmpExch64(&freeHead, head, newHead) == head)
+          return HeadIndex(head) < 0;
+      }
     }
 
+    bool HasFree() const { return HeadIndex(freeHead) >= 0; }
     bool IsAlloc(const void *p) const { return p >= &items[0] && p < &items[PoolCount]; }
+    // free list heads pack the index of the first entry in the low 32 bits, and a tag in the
+    // high 32 bits that's incremented on every change to avoid ABA problems.
+    static int64_t MakeHead(uint32_t tag, int32_t idx)
+    {
+      return int64_t((uint64_t(tag) << 32) | uint64_t(uint32_t(idx)));
+    }
+    static int32_t HeadIndex(int64_t head) { return int32_t(uint64_t(head) & 0xffffffff); }
+    static uint32_t HeadTag(int64_t head) { return uint32_t(uint64_t(head) >> 32); }
+    // keep the head first so the 64-bit exchange has the best chance of natural alignment
+    volatile int64_t freeHead;
+
     WrapType *items;
 
-    // could possibly make this uint32s and check via bitmasks, but
-    // we'll see if it shows up in profiling
-    bool allocated[PoolCount];
+    // link in the wrapping pool's stack of pools with free slots, and whether we're on it
+    volatile int32_t nextAvailable;
+    volatile int32_t available;
 
-    // store the last allocations index. Good place to start from and we
-    // go through the pool in a ring. Good performance when the pool is empty
-    // or contiguously allocated, poorer performance when the pool gets filled up.
-    // It also has the bonus of handling repeated new/free well by reallocating the
-    // same element.
-    int lastAllocIdx;
+    volatile int32_t nextFree[PoolCount];
   };
 
+  // push a pool onto the stack of pools with free slots, unless it's already there
+  void MarkAvailable(int32_t idx)
+  {
+    ItemPool *pool = GetPool(idx);
+
+    if(Atomic::CmpExch32(&pool->available, 0, 1) != 0)
+      return;
+
+    for(;;)
+    {
+      int64_t head = m_AvailableHead;
+      pool->nextAvailable = ItemPool::HeadIndex(head);
+
+      int64_t newHead = ItemPool::MakeHead(ItemPool::HeadTag(head) + 1, idx);
+
+      if(Atomic::CmpExch64(&m_AvailableHead, head, newHead) == head)
+        return;
+    }
+  }
+
+  // pop pools off the available stack until one can satisfy the allocation
+  void *AllocateFromAvailable()
+  {
+    for(;;)
+    {
+      int64_t head = m_AvailableHead;
+      int32_t idx = ItemPool::HeadIndex(head);
+
+      if(idx < 0)
+        return NULL;
+
+      ItemPool *pool = GetPool(idx);
+
+      int64_t newHead = ItemPool::MakeHead(ItemPool::HeadTag(head) + 1, pool->nextAvailable);
+
+      if(Atomic::CmpExch64(&m_AvailableHead, head, newHead) != head)
+        continue;
+
+      Atomic::CmpExch32(&pool->available, 1, 0);
+
+      void *ret = pool->Allocate();
+
+      // a slot may have been freed into the pool while it was off the stack, or it may still
+      // have more space after our allocation. Either way put it back so it isn't forgotten.
+      if(pool->HasFree())
+        MarkAvailable(idx);
+
+      if(ret != NULL)
+      {
+        m_CurrentPool = idx;
+        return ret;
+      }
+    }
+  }
+
+  int32_t FindPool(const void *p)
+  {
+    // pools are only ever added, never removed, so this can be checked without locking
+    if(m_ImmediatePool.IsAlloc(p))
+      return 0;
+
+    int32_t numPools = m_NumAdditionalPools;
+    for(int32_t i = 0; i < numPools; i++)
+      if(GetPool(i + 1)->IsAlloc(p))
+        return i + 1;
+
+    return -1;
+  }
+
+  // additional pools are stored in chunks that double in size, so the table can grow without
+  // ever moving a pool pointer that another thread could be reading.
+  static const uint32_t FirstChunkShift = 6;
+  static const int32_t MaxChunks = 24;
+
+  static uint32_t ChunkIndex(int32_t idx)
+  {
+    uint32_t v = uint32_t(idx) + (1U << FirstChunkShift);
+    return (31 - Bits::CountLeadingZeroes(v)) - FirstChunkShift;
+  }
+  static uint32_t ChunkSize(uint32_t chunk) { return 1U << (chunk + FirstChunkShift); }
+  static uint32_t ChunkOffset(int32_t idx)
+  {
+    uint32_t v = uint32_t(idx) + (1U << FirstChunkShift);
+    return v - ChunkSize(ChunkIndex(idx));
+  }
+
+  ItemPool *GetPool(int32_t idx)
+  {
+    if(idx == 0)
+      return &m_ImmediatePool;
+
+    idx--;
+    return m_PoolChunks[ChunkIndex(idx)][ChunkOffset(idx)];
+  }
+
   ItemPool m_ImmediatePool;
-  std::vector<ItemPool *> m_AdditionalPools;
+
+  // a pool pointer (and its chunk) is always written before the count is incremented to include
+  // it.
+  ItemPool **m_PoolChunks[MaxChunks];
+  volatile int32_t m_NumAdditionalPools;
+
+  // index of the pool (0 = immediate) that we last allocated from
+  volatile int32_t m_CurrentPool;
+
+  // stack of pools that have, or recently had, free slots
+  volatile int64_t m_AvailableHead;
 
   friend typename FriendMaker<WrapType>::Type;
 };
@@ -888,6 +888,39 @@ void RenderDoc::RegisterRemoteProvider(RDCDriver driver, const char *name,
   m_RemoteDriverProviders[driver] = provider;
 }
 
+void RenderDoc::RegisterSelfTest(const char *name, SelfTestFunction test)
+{
+  if(m_SelfTests.find(name) != m_SelfTests.end())
+    RDCERR("Re-registering self-test %s", name);
+
+  m_SelfTests[name] = test;
+}
+
+uint32_t RenderDoc::RunSelfTests(const char *filter)
+{
+  uint32_t failures = 0;
+
+  for(auto it = m_SelfTests.begin(); it != m_SelfTests.end(); ++it)
+  {
+    if(filter && filter[0] && strstr(it->first.c_str(), filter) == NULL)
+      continue;
+
+    RDCLOG("Running self-test %s", it->first.c_str());
+
+    if(it->second())
+    {
+      RDCLOG("Self-test %s passed", it->first.c_str());
+    }
+    else
+    {
+      RDCERR("Self-test %s failed", it->first.c_str());
+      failures++;
+    }
+  }
+
+  return failures;
+}
+
 ReplayStatus RenderDoc::CreateReplayDriver(RDCDriver driverType, const char *logfile,
                                            IReplayDriver **driver)
 {
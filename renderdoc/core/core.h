@@ -184,6 +184,10 @@ typedef bool (*VulkanLayerCheck)(VulkanLayerFlags &flags, std::vector<std::strin
                                  std::vector<std::string> &otherJSONs);
 typedef void (*VulkanLayerInstall)(bool systemLevel);
 
+// internal self-tests and micro-benchmarks, run on demand through RENDERDOC_RunSelfTests and never
+// on any capture or replay path. Returns false if the test failed.
+typedef bool (*SelfTestFunction)();
+
 typedef void (*ShutdownFunction)();
 
 // this class mediates everything and owns any 'global' resources such as the crash handler.
@@ -253,6 +257,9 @@ public:
   void RegisterReplayProvider(RDCDriver driver, const char *name, ReplayDriverProvider provider);
   void RegisterRemoteProvider(RDCDriver driver, const char *name, RemoteDriverProvider provider);
 
+  void RegisterSelfTest(const char *name, SelfTestFunction test);
+  uint32_t RunSelfTests(const char *filter);
+
   void SetVulkanLayerCheck(VulkanLayerCheck callback) { m_VulkanCheck = callback; }
   void SetVulkanLayerInstall(VulkanLayerInstall callback) { m_VulkanInstall = callback; }
   bool NeedVulkanLayerRegistration(VulkanLayerFlags &flags, std::vector<std::string> &myJSONs,
@@ -383,6 +390,8 @@ private:
   map<RDCDriver, ReplayDriverProvider> m_ReplayDriverProviders;
   map<RDCDriver, RemoteDriverProvider> m_RemoteDriverProviders;
 
+  map<string, SelfTestFunction> m_SelfTests;
+
   VulkanLayerCheck m_VulkanCheck;
   VulkanLayerInstall m_VulkanInstall;
 
@@ -452,3 +461,11 @@ struct DriverRegistration
     RenderDoc::Inst().RegisterRemoteProvider(driver, name, provider);
   }
 };
+
+struct SelfTestRegistration
+{
+  SelfTestRegistration(const char *name, SelfTestFunction test)
+  {
+    RenderDoc::Inst().RegisterSelfTest(name, test);
+  }
+};
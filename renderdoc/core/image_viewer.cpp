@@ -154,6 +154,7 @@ public:
   }
   vector<ResourceId> GetBuffers() { return vector<ResourceId>(); }
   vector<DebugMessage> GetDebugMessages() { return vector<DebugMessage>(); }
+  vector<ChunkProfile> GetChunkProfile() { return vector<ChunkProfile>(); }
   BufferDescription GetBuffer(ResourceId id)
   {
     BufferDescription ret;
@@ -179,6 +180,7 @@ public:
   {
     return vector<CounterResult>();
   }
+  double GetIsolatedDuration(uint32_t eventID) { return -1.0; }
   void FillCBufferVariables(ResourceId shader, string entryPoint, uint32_t cbufSlot,
                             vector<ShaderVariable> &outvars, const vector<byte> &data)
   {
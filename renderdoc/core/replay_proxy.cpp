@@ -1301,6 +1301,20 @@ void Serialiser::Serialise(const char *name, DebugMessage &el)
   SIZE_CHECK(40);
 }
 
+template <>
+void Serialiser::Serialise(const char *name, ChunkProfile &el)
+{
+  Serialise("", el.name);
+  Serialise("", el.chunkID);
+  Serialise("", el.loading);
+  Serialise("", el.count);
+  Serialise("", el.totalBytes);
+  Serialise("", el.decodeTime);
+  Serialise("", el.executeTime);
+
+  SIZE_CHECK(56);
+}
+
 template <>
 void Serialiser::Serialise(const char *name, APIEvent &el)
 {
@@ -2149,6 +2163,7 @@ bool ReplayProxy::Tick(int type, Serialiser *incomingPacket)
     case eReplayProxy_GetBuffer: GetBuffer(ResourceId()); break;
     case eReplayProxy_GetShader: GetShader(ResourceId(), ""); break;
     case eReplayProxy_GetDebugMessages: GetDebugMessages(); break;
+    case eReplayProxy_GetChunkProfile: GetChunkProfile(); break;
     case eReplayProxy_SavePipelineState: SavePipelineState(); break;
     case eReplayProxy_GetUsage: GetUsage(ResourceId()); break;
     case eReplayProxy_GetLiveID: GetLiveID(ResourceId()); break;
@@ -2165,6 +2180,7 @@ bool ReplayProxy::Tick(int type, Serialiser *incomingPacket)
       FetchCounters(counters);
       break;
     }
+    case eReplayProxy_GetIsolatedDuration: GetIsolatedDuration(0); break;
     case eReplayProxy_EnumerateCounters: EnumerateCounters(); break;
     case eReplayProxy_DescribeCounter:
     {
@@ -2312,6 +2328,25 @@ vector<DebugMessage> ReplayProxy::GetDebugMessages()
   return ret;
 }
 
+vector<ChunkProfile> ReplayProxy::GetChunkProfile()
+{
+  vector<ChunkProfile> ret;
+
+  if(m_RemoteServer)
+  {
+    ret = m_Remote->GetChunkProfile();
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_GetChunkProfile))
+      return ret;
+  }
+
+  m_FromReplaySerialiser->Serialise("", ret);
+
+  return ret;
+}
+
 TextureDescription ReplayProxy::GetTexture(ResourceId id)
 {
   TextureDescription ret = {};
@@ -2394,10 +2429,15 @@ void ReplayProxy::SavePipelineState()
     m_VulkanPipelineState = VKPipe::State();
   }
 
-  m_FromReplaySerialiser->Serialise("", m_D3D11PipelineState);
-  m_FromReplaySerialiser->Serialise("", m_D3D12PipelineState);
-  m_FromReplaySerialiser->Serialise("", m_GLPipelineState);
-  m_FromReplaySerialiser->Serialise("", m_VulkanPipelineState);
+  // the other APIs' states are always empty, so only send the capture's
+  if(m_APIProps.pipelineType == GraphicsAPI::D3D11)
+    m_FromReplaySerialiser->Serialise("", m_D3D11PipelineState);
+  else if(m_APIProps.pipelineType == GraphicsAPI::D3D12)
+    m_FromReplaySerialiser->Serialise("", m_D3D12PipelineState);
+  else if(m_APIProps.pipelineType == GraphicsAPI::OpenGL)
+    m_FromReplaySerialiser->Serialise("", m_GLPipelineState);
+  else if(m_APIProps.pipelineType == GraphicsAPI::Vulkan)
+    m_FromReplaySerialiser->Serialise("", m_VulkanPipelineState);
 }
 
 void ReplayProxy::ReplayLog(uint32_t endEventID, ReplayLogType replayType)
@@ -2561,6 +2601,27 @@ vector<CounterResult> ReplayProxy::FetchCounters(const vector<GPUCounter> &count
   return ret;
 }
 
+double ReplayProxy::GetIsolatedDuration(uint32_t eventID)
+{
+  double ret = -1.0;
+
+  m_ToReplaySerialiser->Serialise("", eventID);
+
+  if(m_RemoteServer)
+  {
+    ret = m_Remote->GetIsolatedDuration(eventID);
+  }
+  else
+  {
+    if(!SendReplayCommand(eReplayProxy_GetIsolatedDuration))
+      return ret;
+  }
+
+  m_FromReplaySerialiser->Serialise("", ret);
+
+  return ret;
+}
+
 vector<GPUCounter> ReplayProxy::EnumerateCounters()
 {
   vector<GPUCounter> ret;
@@ -85,6 +85,9 @@ enum ReplayProxyPacket
   eReplayProxy_GetAPIProperties,
 
   eReplayProxy_PixelHistory,
+
+  eReplayProxy_GetChunkProfile,
+  eReplayProxy_GetIsolatedDuration,
 };
 
 // This class implements IReplayDriver and StackResolver. On the local machine where the UI
@@ -395,6 +398,7 @@ public:
   APIProperties GetAPIProperties();
 
   vector<DebugMessage> GetDebugMessages();
+  vector<ChunkProfile> GetChunkProfile();
 
   void SavePipelineState();
   D3D11Pipe::State GetD3D11PipelineState() { return m_D3D11PipelineState; }
@@ -415,6 +419,7 @@ public:
   vector<GPUCounter> EnumerateCounters();
   void DescribeCounter(GPUCounter counterID, CounterDescription &desc);
   vector<CounterResult> FetchCounters(const vector<GPUCounter> &counterID);
+  double GetIsolatedDuration(uint32_t eventID);
 
   void FillCBufferVariables(ResourceId shader, string entryPoint, uint32_t cbufSlot,
                             vector<ShaderVariable> &outvars, const vector<byte> &data);
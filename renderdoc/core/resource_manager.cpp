@@ -80,7 +80,7 @@ void ResourceRecord::Delete(ResourceRecordHandler *mgr)
     for(auto it = m_FrameRefs.begin(); it != m_FrameRefs.end(); ++it)
     {
       if(it->second == eFrameRef_Write || it->second == eFrameRef_ReadAndWrite ||
-         it->second == eFrameRef_ReadBeforeWrite)
+         it->second == eFrameRef_ReadBeforeWrite || it->second == eFrameRef_CompleteWrite)
       {
         // lost a write to this resource, must mark it as gpu dirty.
         mgr->MarkPendingDirty(it->first);
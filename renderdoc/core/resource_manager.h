@@ -51,6 +51,11 @@ enum FrameRefType
   eFrameRef_ReadOnly,
   eFrameRef_ReadAndWrite,
   eFrameRef_ReadBeforeWrite,
+
+  // Input and state - the whole resource is overwritten without its previous contents being
+  // read, e.g. by a full clear. If this is the first reference in the frame then the resource's
+  // initial contents are never used
+  eFrameRef_CompleteWrite,
 };
 
 // verbose prints with IDs of each dirty resource and whether it was prepared,
@@ -250,6 +255,12 @@ struct ResourceRecord
     for(auto it = m_FrameRefs.begin(); it != m_FrameRefs.end(); ++it)
       ids.insert(it->first);
   }
+  void AddCompleteWriteIDs(std::set<ResourceId> &ids)
+  {
+    for(auto it = m_FrameRefs.begin(); it != m_FrameRefs.end(); ++it)
+      if(it->second == eFrameRef_CompleteWrite)
+        ids.insert(it->first);
+  }
 
   uint64_t Length;
 
@@ -365,6 +376,9 @@ public:
 
   InitialContentData GetInitialContents(ResourceId id);
   void SetInitialContents(ResourceId id, InitialContentData contents);
+
+  // list the original IDs of every resource with initial contents
+  void GetInitialContentsIDs(std::vector<ResourceId> &ids);
   void SetInitialChunk(ResourceId id, Chunk *chunk);
 
   // generate chunks for initial contents and insert.
@@ -383,10 +397,17 @@ public:
   // That means this resource should be included in the final serialise out
   inline void MarkResourceFrameReferenced(ResourceId id, FrameRefType refType);
 
+  // check if this resource was referenced at all in the frame
+  bool IsFrameReferenced(ResourceId id);
+
   // check if this resource was read before being written to - can be used to detect if
   // initial states are necessary
   bool ReadBeforeWrite(ResourceId id);
 
+  // check if this resource was completely overwritten before anything read it - if so its
+  // initial state is never used
+  bool OverwrittenBeforeRead(ResourceId id);
+
   ///////////////////////////////////////////
   // Replay-side methods
 
@@ -414,6 +435,11 @@ public:
   // Apply the initial contents for the resources that need them, used at the start of a frame
   void ApplyInitialContents();
 
+  // when enabled, ApplyInitialContents only restores resources that have been marked as written
+  // by replay since the last time it was called. Everything else still holds its initial contents
+  void SetReplayWriteTracking(bool enabled);
+  void MarkReplayWritten(ResourceId liveid);
+
   // Resource wrapping, allows for querying and adding/removing of wrapper layers around resources
   bool AddWrapper(WrappedResourceType wrap, RealResourceType real);
   bool HasWrapper(RealResourceType real);
@@ -478,6 +504,10 @@ protected:
   // used during replay - maps back and forth from original id to live id and vice-versa
   map<ResourceId, ResourceId> m_OriginalIDs, m_LiveIDs;
 
+  // used during replay - live IDs of resources written since initial contents were last applied
+  set<ResourceId> m_ReplayWritten;
+  bool m_TrackReplayWrites;
+
   // used during replay - holds resources allocated and the original id that they represent
   // for a) in-frame creations and b) pre-frame creations respectively.
   map<ResourceId, WrappedResourceType> m_InframeResourceMap, m_LiveResourceMap;
@@ -500,6 +530,8 @@ ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ResourceMana
   m_pSerialiser = ser;
 
   m_InFrame = false;
+
+  m_TrackReplayWrites = false;
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -575,10 +607,13 @@ bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkRef
     {
       if(refType == eFrameRef_Read || refType == eFrameRef_ReadOnly)
         refs[id] = eFrameRef_ReadOnly;
+      else if(refType == eFrameRef_CompleteWrite)
+        refs[id] = eFrameRef_CompleteWrite;
       else
         refs[id] = eFrameRef_ReadAndWrite;
     }
-    else if(refs[id] == eFrameRef_ReadOnly && refType == eFrameRef_Write)
+    else if(refs[id] == eFrameRef_ReadOnly &&
+            (refType == eFrameRef_Write || refType == eFrameRef_CompleteWrite))
     {
       refs[id] = eFrameRef_ReadBeforeWrite;
     }
@@ -607,6 +642,13 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkRes
   }
 }
 
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::IsFrameReferenced(
+    ResourceId id)
+{
+  return m_FrameReferencedResources.find(id) != m_FrameReferencedResources.end();
+}
+
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ReadBeforeWrite(ResourceId id)
 {
@@ -617,6 +659,17 @@ bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ReadBef
   return false;
 }
 
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+bool ResourceManager<WrappedResourceType, RealResourceType, RecordType>::OverwrittenBeforeRead(
+    ResourceId id)
+{
+  auto it = m_FrameReferencedResources.find(id);
+  if(it != m_FrameReferencedResources.end())
+    return it->second == eFrameRef_CompleteWrite;
+
+  return false;
+}
+
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkDirtyResource(ResourceId res)
 {
@@ -730,6 +783,18 @@ typename ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Ini
   return InitialContentData();
 }
 
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::GetInitialContentsIDs(
+    std::vector<ResourceId> &ids)
+{
+  SCOPED_LOCK(m_Lock);
+
+  ids.reserve(ids.size() + m_InitialContents.size());
+
+  for(auto it = m_InitialContents.begin(); it != m_InitialContents.end(); ++it)
+    ids.push_back(it->first);
+}
+
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
 void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::Serialise_InitialContentsNeeded()
 {
@@ -845,12 +910,33 @@ void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::ApplyIn
     {
       WrappedResourceType live = GetLiveResource(id);
 
+      // nothing has written this since it was last restored
+      if(m_TrackReplayWrites && m_ReplayWritten.find(GetID(live)) == m_ReplayWritten.end())
+        continue;
+
       numContents++;
 
       Apply_InitialState(live, it->second);
     }
   }
   RDCDEBUG("Applied %d", numContents);
+
+  m_ReplayWritten.clear();
+}
+
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::SetReplayWriteTracking(
+    bool enabled)
+{
+  m_TrackReplayWrites = enabled;
+  m_ReplayWritten.clear();
+}
+
+template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
+void ResourceManager<WrappedResourceType, RealResourceType, RecordType>::MarkReplayWritten(
+    ResourceId liveid)
+{
+  m_ReplayWritten.insert(liveid);
 }
 
 template <typename WrappedResourceType, typename RealResourceType, typename RecordType>
@@ -53,6 +53,7 @@ public:
   TextureDescription GetTexture(ResourceId id);
 
   vector<DebugMessage> GetDebugMessages();
+  vector<ChunkProfile> GetChunkProfile() { return vector<ChunkProfile>(); }
 
   ShaderReflection *GetShader(ResourceId shader, string entryPoint);
 
@@ -115,6 +116,7 @@ public:
   vector<GPUCounter> EnumerateCounters();
   void DescribeCounter(GPUCounter counterID, CounterDescription &desc);
   vector<CounterResult> FetchCounters(const vector<GPUCounter> &counters);
+  double GetIsolatedDuration(uint32_t eventID) { return -1.0; }
 
   ResourceId CreateProxyTexture(const TextureDescription &templateTex);
   void SetProxyTextureData(ResourceId texid, uint32_t arrayIdx, uint32_t mip, byte *data,
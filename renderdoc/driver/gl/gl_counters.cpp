@@ -36,6 +36,14 @@ void GLReplay::PostContextInitCounters()
 
 void GLReplay::PreContextShutdownCounters()
 {
+  MakeCurrentReplayContext(&m_ReplayCtx);
+
+  for(auto q : indices<GPUCounter>())
+  {
+    if(!m_CounterQueries[q].empty())
+      m_pDriver->glDeleteQueries((GLsizei)m_CounterQueries[q].size(), &m_CounterQueries[q][0]);
+    m_CounterQueries[q].clear();
+  }
 }
 
 void GLReplay::PostContextShutdownCounters()
@@ -182,6 +190,8 @@ struct GLCounterContext
   uint32_t eventStart;
   vector<GPUQueries> queries;
   int reuseIdx;
+  // next unused query object in GLReplay::m_CounterQueries for each counter
+  size_t nextQuery[ENUM_ARRAY_SIZE(GPUCounter)];
 };
 
 GLenum glCounters[] = {
@@ -229,9 +239,18 @@ void GLReplay::FillTimers(GLCounterContext &ctx, const DrawcallTreeNode &drawnod
 
         for(uint32_t c = 0; c < counters.size(); c++)
         {
-          m_pDriver->glGenQueries(1, &queries->obj[(uint32_t)counters[c]]);
-          if(m_pDriver->glGetError())
-            queries->obj[(uint32_t)counters[c]] = 0;
+          uint32_t q = (uint32_t)counters[c];
+          vector<GLuint> &pool = m_CounterQueries[q];
+
+          // grow the pool in batches rather than generating a query per draw
+          if(ctx.nextQuery[q] >= pool.size())
+          {
+            size_t prevSize = pool.size();
+            pool.resize(RDCMAX(prevSize * 2, (size_t)64));
+            m_pDriver->glGenQueries(GLsizei(pool.size() - prevSize), &pool[prevSize]);
+          }
+
+          queries->obj[q] = pool[ctx.nextQuery[q]++];
         }
       }
       else
@@ -248,10 +267,7 @@ void GLReplay::FillTimers(GLCounterContext &ctx, const DrawcallTreeNode &drawnod
       {
         m_pDriver->glBeginQuery(glCounters[q], queries->obj[q]);
         if(m_pDriver->glGetError())
-        {
-          m_pDriver->glDeleteQueries(1, &queries->obj[q]);
           queries->obj[q] = 0;
-        }
       }
 
     m_pDriver->ReplayLog(ctx.eventStart, d.eventID, eReplay_OnlyDraw);
@@ -277,6 +293,7 @@ vector<CounterResult> GLReplay::FetchCounters(const vector<GPUCounter> &counters
   MakeCurrentReplayContext(&m_ReplayCtx);
 
   GLCounterContext ctx;
+  RDCEraseEl(ctx.nextQuery);
 
   for(int loop = 0; loop < 1; loop++)
   {
@@ -326,10 +343,53 @@ vector<CounterResult> GLReplay::FetchCounters(const vector<GPUCounter> &counters
     m_pDriver->glBindBuffer(eGL_QUERY_BUFFER, prevbind);
   }
 
-  for(size_t i = 0; i < ctx.queries.size(); i++)
-    for(uint32_t c = 0; c < counters.size(); c++)
-      if(ctx.queries[i].obj[(uint32_t)counters[c]])
-        m_pDriver->glDeleteQueries(1, &ctx.queries[i].obj[(uint32_t)counters[c]]);
+  return ret;
+}
+
+double GLReplay::GetIsolatedDuration(uint32_t eventID)
+{
+  MakeCurrentReplayContext(&m_ReplayCtx);
+
+  vector<GLuint> &pool = m_CounterQueries[(uint32_t)GPUCounter::EventGPUDuration];
+
+  if(pool.empty())
+  {
+    pool.resize(64);
+    m_pDriver->glGenQueries(GLsizei(pool.size()), &pool[0]);
+  }
+
+  GLuint query = pool[0];
+
+  m_pDriver->SetFetchCounters(true);
+
+  m_pDriver->ReplayLog(0, eventID, eReplay_WithoutDraw);
+
+  m_pDriver->glBeginQuery(eGL_TIME_ELAPSED, query);
+  if(m_pDriver->glGetError())
+  {
+    m_pDriver->SetFetchCounters(false);
+    return -1.0;
+  }
+
+  m_pDriver->ReplayLog(0, eventID, eReplay_OnlyDraw);
+
+  m_pDriver->glEndQuery(eGL_TIME_ELAPSED);
+
+  m_pDriver->SetFetchCounters(false);
+
+  GLuint prevbind = 0;
+  m_pDriver->glGetIntegerv(eGL_QUERY_BUFFER_BINDING, (GLint *)&prevbind);
+  m_pDriver->glBindBuffer(eGL_QUERY_BUFFER, 0);
+
+  GLuint64 data = 0;
+  m_pDriver->glGetQueryObjectui64v(query, eGL_QUERY_RESULT, &data);
+
+  double ret = double(data) / 1000000000.0;
+
+  if(m_pDriver->glGetError())
+    ret = -1.0;
+
+  m_pDriver->glBindBuffer(eGL_QUERY_BUFFER, prevbind);
 
   return ret;
 }
@@ -790,6 +790,8 @@ WrappedOpenGL::WrappedOpenGL(const char *logfile, const GLHookSet &funcs, GLPlat
 
   m_Replay.SetDriver(this);
 
+  m_CurrentCtxTLSSlot = Threading::AllocateTLSSlot();
+
   m_FrameCounter = 0;
   m_NoCtxFrames = 0;
   m_FailedFrame = 0;
@@ -1098,18 +1100,51 @@ WrappedOpenGL::~WrappedOpenGL()
 
   SAFE_DELETE(m_ResourceManager);
 
+  for(size_t i = 0; i < m_ThreadContexts.size(); i++)
+    delete m_ThreadContexts[i];
+
   if(RenderDoc::Inst().GetCrashHandler())
     RenderDoc::Inst().GetCrashHandler()->UnregisterMemoryRegion(this);
 }
 
 void *WrappedOpenGL::GetCtx()
 {
-  return (void *)m_ActiveContexts[Threading::GetCurrentID()].ctx;
+  ThreadContext *threadctx = (ThreadContext *)Threading::GetTLSValue(m_CurrentCtxTLSSlot);
+  return threadctx ? threadctx->ctx : NULL;
 }
 
 WrappedOpenGL::ContextData &WrappedOpenGL::GetCtxData()
 {
-  return m_ContextData[GetCtx()];
+  ThreadContext *threadctx = (ThreadContext *)Threading::GetTLSValue(m_CurrentCtxTLSSlot);
+
+  if(threadctx == NULL)
+    return m_ContextData[NULL];
+
+  // the data is cleared if the context was deleted while still current here
+  if(threadctx->data == NULL)
+    threadctx->data = &m_ContextData[threadctx->ctx];
+
+  return *threadctx->data;
+}
+
+void WrappedOpenGL::SetActiveContext(const GLWindowingData &winData)
+{
+  m_ActiveContexts[Threading::GetCurrentID()] = winData;
+
+  ThreadContext *threadctx = (ThreadContext *)Threading::GetTLSValue(m_CurrentCtxTLSSlot);
+
+  if(threadctx == NULL)
+  {
+    threadctx = new ThreadContext();
+    Threading::SetTLSValue(m_CurrentCtxTLSSlot, (void *)threadctx);
+
+    SCOPED_LOCK(m_ThreadContextsLock);
+    m_ThreadContexts.push_back(threadctx);
+  }
+
+  // map entries are stable until erased in DeleteContext, so the pointer can be cached
+  threadctx->ctx = (void *)winData.ctx;
+  threadctx->data = &m_ContextData[threadctx->ctx];
 }
 
 // defined in gl_<platform>_hooks.cpp
@@ -1151,6 +1186,13 @@ void WrappedOpenGL::DeleteContext(void *contextHandle)
     }
   }
 
+  {
+    SCOPED_LOCK(m_ThreadContextsLock);
+    for(size_t i = 0; i < m_ThreadContexts.size(); i++)
+      if(m_ThreadContexts[i]->ctx == contextHandle)
+        m_ThreadContexts[i]->data = NULL;
+  }
+
   m_ContextData.erase(contextHandle);
 }
 
@@ -1384,7 +1426,7 @@ void WrappedOpenGL::RegisterContext(GLWindowingData winData, void *shareContext,
 
 void WrappedOpenGL::ActivateContext(GLWindowingData winData)
 {
-  m_ActiveContexts[Threading::GetCurrentID()] = winData;
+  SetActiveContext(winData);
   if(winData.ctx)
   {
     for(auto it = m_LastContexts.begin(); it != m_LastContexts.end(); ++it)
@@ -2514,7 +2556,7 @@ void WrappedOpenGL::MakeValidContextCurrent(GLWindowingData &prevctx, void *favo
              Threading::GetCurrentID());
     }
 
-    m_ActiveContexts[Threading::GetCurrentID()] = prevctx;
+    SetActiveContext(prevctx);
     m_Platform.MakeContextCurrent(prevctx);
   }
 }
@@ -2562,6 +2604,7 @@ void WrappedOpenGL::StartFrameCapture(void *dev, void *wnd)
   m_Real.glBindVertexArray(prevVAO);
 
   GetResourceManager()->PrepareInitialContents();
+  GetResourceManager()->FenceTextureReadbacks();
 
   FreeCaptureData();
 
@@ -2571,7 +2614,7 @@ void WrappedOpenGL::StartFrameCapture(void *dev, void *wnd)
   if(switchctx.ctx != prevctx.ctx)
   {
     m_Platform.MakeContextCurrent(prevctx);
-    m_ActiveContexts[Threading::GetCurrentID()] = prevctx;
+    SetActiveContext(prevctx);
   }
 
   RDCLOG("Starting capture, frame %u", m_FrameCounter);
@@ -2645,6 +2688,8 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
 
     GetResourceManager()->InsertInitialContentsChunks(m_pFileSerialiser);
 
+    GetResourceManager()->ReleaseTextureReadbacks();
+
     RDCDEBUG("Creating Capture Scope");
 
     {
@@ -2688,7 +2733,7 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
     if(switchctx.ctx != prevctx.ctx)
     {
       m_Platform.MakeContextCurrent(prevctx);
-      m_ActiveContexts[Threading::GetCurrentID()] = prevctx;
+      SetActiveContext(prevctx);
     }
 
     return true;
@@ -2732,6 +2777,8 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
 
     GetResourceManager()->ClearReferencedResources();
 
+    GetResourceManager()->ReleaseTextureReadbacks();
+
     // if it's a capture triggered from application code, immediately
     // give up as it's not reasonable to expect applications to detect and retry.
     // otherwise we can retry in case the next frame works.
@@ -2754,6 +2801,7 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
     {
       GetResourceManager()->MarkResourceFrameReferenced(m_DeviceResourceID, eFrameRef_Write);
       GetResourceManager()->PrepareInitialContents();
+      GetResourceManager()->FenceTextureReadbacks();
 
       AttemptCapture();
       BeginCaptureFrame();
@@ -2762,7 +2810,7 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
     if(switchctx.ctx != prevctx.ctx)
     {
       m_Platform.MakeContextCurrent(prevctx);
-      m_ActiveContexts[Threading::GetCurrentID()] = prevctx;
+      SetActiveContext(prevctx);
     }
 
     return false;
@@ -3241,6 +3289,8 @@ void WrappedOpenGL::ReadLogInitialisation()
 
   m_pSerialiser->SetDebugText(true);
 
+  m_ChunkProfiler.Init(m_pSerialiser);
+
   m_pSerialiser->Rewind();
 
   int chunkIdx = 0;
@@ -3263,6 +3313,8 @@ void WrappedOpenGL::ReadLogInitialisation()
 
     uint64_t offset = m_pSerialiser->GetOffset();
 
+    m_ChunkProfiler.BeginChunk(m_pSerialiser);
+
     GLChunkType context = (GLChunkType)m_pSerialiser->PushContext(NULL, NULL, 1, false);
 
     if(context == CAPTURE_SCOPE)
@@ -3277,6 +3329,8 @@ void WrappedOpenGL::ReadLogInitialisation()
 
     m_pSerialiser->PopContext(context);
 
+    m_ChunkProfiler.EndChunk(m_pSerialiser, context, true);
+
     RenderDoc::Inst().SetProgress(FileInitialRead, float(offset) / float(m_pSerialiser->GetSize()));
 
     if(context == CAPTURE_SCOPE)
@@ -3857,10 +3911,14 @@ void WrappedOpenGL::ContextReplayLog(LogState readType, uint32_t startEventID, u
 
     uint64_t offset = m_pSerialiser->GetOffset();
 
+    m_ChunkProfiler.BeginChunk(m_pSerialiser);
+
     GLChunkType chunktype = (GLChunkType)m_pSerialiser->PushContext(NULL, NULL, 1, false);
 
     ContextProcessChunk(offset, chunktype);
 
+    m_ChunkProfiler.EndChunk(m_pSerialiser, chunktype, m_State == READING);
+
     RenderDoc::Inst().SetProgress(FrameEventsRead,
                                   float(offset - startOffset) / float(m_pSerialiser->GetSize()));
 
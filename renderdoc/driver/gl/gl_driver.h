@@ -125,6 +125,10 @@ private:
   void Serialise_DebugMessages();
   vector<DebugMessage> GetDebugMessages();
 
+  // per chunk-type load and replay statistics
+  ChunkProfiler m_ChunkProfiler;
+  vector<ChunkProfile> GetChunkProfile() { return m_ChunkProfiler.GetProfile(&GetChunkName); }
+
   GLDEBUGPROC m_RealDebugFunc;
   const void *m_RealDebugFuncParam;
   string m_DebugMsgContext;
@@ -205,6 +209,12 @@ private:
   set<GLResourceRecord *> m_CoherentMaps;
   set<GLResourceRecord *> m_PersistentMaps;
 
+  // scratch storage for the modified ranges found when flushing persistent maps, and the pages
+  // written since the last flush when tracking map writes
+  vector<std::pair<size_t, size_t> > m_MapDiffRanges;
+  vector<std::pair<size_t, size_t> > m_MapDirtyPages;
+  vector<std::pair<size_t, size_t> > m_MapPageDiffRanges;
+
   // this function iterates over all the maps, checking for any changes between
   // the shadow pointers, and propogates that to 'real' GL
   void PersistentMapMemoryBarrier(const set<GLResourceRecord *> &maps);
@@ -469,6 +479,21 @@ private:
 
   map<void *, ContextData> m_ContextData;
 
+  // cached per-thread pointer to the current context and its data, so that
+  // GetCtx()/GetCtxData() on every hooked call don't need to look up the
+  // thread ID in m_ActiveContexts and then the context in m_ContextData.
+  struct ThreadContext
+  {
+    void *ctx;
+    ContextData *data;
+  };
+
+  uint64_t m_CurrentCtxTLSSlot;
+  Threading::CriticalSection m_ThreadContextsLock;
+  vector<ThreadContext *> m_ThreadContexts;
+
+  void SetActiveContext(const GLWindowingData &winData);
+
   ContextData &GetCtxData();
   GLuint GetUniformProgram();
 
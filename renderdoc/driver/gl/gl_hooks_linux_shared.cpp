@@ -24,7 +24,9 @@
 
 #include <dlfcn.h>
 #include <stdio.h>
+#include <algorithm>
 #include "common/threading.h"
+#include "common/timing.h"
 #include "driver/gl/gl_common.h"
 #include "driver/gl/gl_driver.h"
 #include "driver/gl/gl_hookset.h"
@@ -34,6 +36,12 @@
 
 GLHookSet GL;
 WrappedOpenGL *m_GLDriver;
+
+// every hooked entry point takes this lock, even while not capturing. The wrappers still update
+// shared state in WRITING_IDLE - resource records, dirty tracking, the texture and buffer maps
+// and the persistent/coherent map sets - and the lock is also what makes the transition into and
+// out of a capture atomic with respect to calls on other threads. Only the per-call context
+// lookups could be moved out from under it, see WrappedOpenGL::ThreadContext.
 Threading::CriticalSection glLock;
 void *libGLdlsymHandle =
     RTLD_NEXT;    // default to RTLD_NEXT, but overwritten if app calls dlopen() on real libGL
@@ -43,44 +51,57 @@ Threading::CriticalSection &GetGLLock()
   return glLock;
 }
 
-#define HookInit(function)                               \
-  if(!strcmp(func, STRINGIZE(function)))                 \
-  {                                                      \
-    GL.function = (CONCAT(function, _hooktype))realFunc; \
-    return (void *)&CONCAT(function, _renderdoc_hooked); \
+// Function pointer requests are resolved through a table built from the hookset definitions,
+// sorted by name so each lookup is a binary search instead of a chain of strcmp()s over every
+// function we know about. The real function pointer is written with memcpy since the slot could
+// be any function pointer type.
+struct HookLookupEntry
+{
+  const char *name;
+  void *realSlot;
+  void *hook;
+  // aliases only set the real function pointer if it hasn't been set by the canonical name
+  bool alias;
+};
+
+struct HookLookupLess
+{
+  bool operator()(const HookLookupEntry &a, const HookLookupEntry &b) const
+  {
+    return strcmp(a.name, b.name) < 0;
   }
+  bool operator()(const HookLookupEntry &a, const char *b) const { return strcmp(a.name, b) < 0; }
+};
 
-#define HookExtension(funcPtrType, function)             \
-  if(!strcmp(func, STRINGIZE(function)))                 \
-  {                                                      \
-    GL.function = (funcPtrType)realFunc;                 \
-    return (void *)&CONCAT(function, _renderdoc_hooked); \
+#define HookInit(function)                                                                      \
+  {                                                                                             \
+    HookLookupEntry e = {STRINGIZE(function), (void *)&GL.function,                             \
+                         (void *)&CONCAT(function, _renderdoc_hooked), false};                  \
+    hooks.push_back(e);                                                                         \
   }
 
-#define HookExtensionAlias(funcPtrType, function, alias) \
-  if(!strcmp(func, STRINGIZE(alias)))                    \
-  {                                                      \
-    if(GL.function == NULL)                              \
-      GL.function = (funcPtrType)realFunc;               \
-    return (void *)&CONCAT(function, _renderdoc_hooked); \
+#define HookExtension(funcPtrType, function)                                                    \
+  {                                                                                             \
+    HookLookupEntry e = {STRINGIZE(function), (void *)&GL.function,                             \
+                         (void *)&CONCAT(function, _renderdoc_hooked), false};                  \
+    hooks.push_back(e);                                                                         \
   }
 
-#if 0    // debug print for each unsupported function requested (but not used)
-#define HandleUnsupported(funcPtrType, function)                                           \
-  if(lowername == STRINGIZE(function))                                                     \
-  {                                                                                        \
-    CONCAT(unsupported_real_, function) = (CONCAT(function, _hooktype))realFunc;           \
-    RDCDEBUG("Requesting function pointer for unsupported function " STRINGIZE(function)); \
-    return (void *)&CONCAT(function, _renderdoc_hooked);                                   \
+#define HookExtensionAlias(funcPtrType, function, alias)                                        \
+  {                                                                                             \
+    HookLookupEntry e = {STRINGIZE(alias), (void *)&GL.function,                                \
+                         (void *)&CONCAT(function, _renderdoc_hooked), true};                   \
+    hooks.push_back(e);                                                                         \
   }
-#else
-#define HandleUnsupported(funcPtrType, function)                                 \
-  if(lowername == STRINGIZE(function))                                           \
-  {                                                                              \
-    CONCAT(unsupported_real_, function) = (CONCAT(function, _hooktype))realFunc; \
-    return (void *)&CONCAT(function, _renderdoc_hooked);                         \
+
+// at the moment the unsupported functions are all lowercase (as their name is generated from the
+// typedef name), so they're kept in a separate table that's searched with the lowercased name.
+#define HandleUnsupported(funcPtrType, function)                                                \
+  {                                                                                             \
+    HookLookupEntry e = {STRINGIZE(function), (void *)&CONCAT(unsupported_real_, function),     \
+                         (void *)&CONCAT(function, _renderdoc_hooked), false};                  \
+    unsupported.push_back(e);                                                                   \
   }
-#endif
 
 /*
   in bash:
@@ -676,20 +697,119 @@ DefineGLExtensionHooks();
 
 DefineUnsupportedDummies();
 
-void *SharedLookupFuncPtr(const char *func, void *realFunc)
+struct HookLookupTable
 {
-  DLLExportHooks();
-  HookCheckGLExtensions();
+  HookLookupTable()
+  {
+    DLLExportHooks();
+    HookCheckGLExtensions();
+
+    CheckUnsupported();
+
+    // stable so that if a name is listed twice the first definition wins, as it did when
+    // checking each in turn
+    std::stable_sort(hooks.begin(), hooks.end(), HookLookupLess());
+    std::stable_sort(unsupported.begin(), unsupported.end(), HookLookupLess());
+  }
+
+  static const HookLookupEntry *Find(const vector<HookLookupEntry> &table, const char *name)
+  {
+    auto it = std::lower_bound(table.begin(), table.end(), name, HookLookupLess());
 
-  // at the moment the unsupported functions are all lowercase (as their name is generated from the
-  // typedef name).
-  string lowername = strlower(string(func));
+    if(it != table.end() && !strcmp(it->name, name))
+      return &*it;
 
-  CheckUnsupported();
+    return NULL;
+  }
+
+  vector<HookLookupEntry> hooks;
+  vector<HookLookupEntry> unsupported;
+};
+
+static const HookLookupTable &GetHookLookupTable()
+{
+  static HookLookupTable table;
+  return table;
+}
+
+static const HookLookupEntry *FindHookEntry(const char *func)
+{
+  const HookLookupTable &table = GetHookLookupTable();
+
+  const HookLookupEntry *entry = HookLookupTable::Find(table.hooks, func);
+
+  if(entry == NULL)
+  {
+    string lowername = strlower(string(func));
+
+    entry = HookLookupTable::Find(table.unsupported, lowername.c_str());
+  }
+
+  return entry;
+}
+
+// resolves every function name we know about many times, the same way the application's
+// GetProcAddress calls are resolved, and logs the average cost of a lookup.
+static bool HookLookupSelfTest()
+{
+  const HookLookupTable &table = GetHookLookupTable();
+
+  vector<const char *> names;
+  for(size_t i = 0; i < table.hooks.size(); i++)
+    names.push_back(table.hooks[i].name);
+  for(size_t i = 0; i < table.unsupported.size(); i++)
+    names.push_back(table.unsupported[i].name);
+
+  const int iterations = 1000;
+
+  size_t found = 0;
+
+  PerformanceTimer timer;
+
+  for(int it = 0; it < iterations; it++)
+    for(size_t i = 0; i < names.size(); i++)
+      if(FindHookEntry(names[i]) != NULL)
+        found++;
+
+  double ms = timer.GetMilliseconds();
+  double lookups = double(names.size()) * double(iterations);
+
+  RDCLOG("GL hook lookup: %llu names x %d iterations in %.3f ms, %.1f ns per lookup",
+         (uint64_t)names.size(), iterations, ms, (ms * 1000000.0) / RDCMAX(lookups, 1.0));
+
+  if(found != names.size() * iterations)
+  {
+    RDCERR("%llu of %.0f lookups failed", uint64_t(lookups) - (uint64_t)found, lookups);
+    return false;
+  }
+
+  return true;
+}
+
+static SelfTestRegistration GLHookLookupTest("gl.hooklookup", &HookLookupSelfTest);
+
+void *SharedLookupFuncPtr(const char *func, void *realFunc)
+{
+  const HookLookupEntry *entry = FindHookEntry(func);
 
   // for any other function, if it's not a core or extension function we know about,
   // just return NULL
-  return NULL;
+  if(entry == NULL)
+    return NULL;
+
+  if(entry->alias)
+  {
+    void *cur = NULL;
+    memcpy(&cur, entry->realSlot, sizeof(cur));
+    if(cur == NULL)
+      memcpy(entry->realSlot, &realFunc, sizeof(realFunc));
+  }
+  else
+  {
+    memcpy(entry->realSlot, &realFunc, sizeof(realFunc));
+  }
+
+  return entry->hook;
 }
 
 bool SharedPopulateHooks(void *(*lookupFunc)(const char *))
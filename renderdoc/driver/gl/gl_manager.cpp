@@ -887,6 +887,12 @@ void GLResourceManager::PrepareTextureInitialContents(ResourceId liveid, Resourc
 
       gl.glTextureParameterivEXT(res.name, details.curType, eGL_TEXTURE_MAX_LEVEL,
                                  (GLint *)&state->maxLevel);
+
+      // on capture, kick off the readback of the copy now so it's ready by the time we serialise.
+      // Multisampled textures aren't serialised and GLES has no glGetTexImage, so those use the
+      // texture directly as before
+      if(m_State >= WRITING && !ms && !IsGLES)
+        ReadbackTextureContents(liveid, origid, tex);
     }
 
     SetInitialContents(origid, InitialContentData(TextureRes(res.Context, tex), 0, (byte *)state));
@@ -909,6 +915,248 @@ void GLResourceManager::PrepareTextureInitialContents(ResourceId liveid, Resourc
   }
 }
 
+// pack buffers for texture readback are allocated in chunks of this size, unless a single texture
+// is larger
+static const size_t PackBufferSize = 64 * 1024 * 1024;
+
+void GLResourceManager::ReadbackTextureContents(ResourceId liveid, ResourceId origid, GLuint tex)
+{
+  const GLHookSet &gl = m_GL->GetInternalHookset();
+
+  WrappedOpenGL::TextureData &details = m_GL->m_Textures[liveid];
+
+  GLenum t = details.curType;
+
+  int mips = GetNumMips(gl, t, tex, details.width, details.height, details.depth);
+
+  bool isCompressed = IsCompressedFormat(details.internalFormat);
+
+  GLenum fmt = eGL_NONE, type = eGL_NONE;
+  if(!isCompressed)
+  {
+    fmt = GetBaseFormat(details.internalFormat);
+    type = GetDataType(details.internalFormat);
+  }
+
+  GLenum targets[] = {
+      eGL_TEXTURE_CUBE_MAP_POSITIVE_X, eGL_TEXTURE_CUBE_MAP_NEGATIVE_X,
+      eGL_TEXTURE_CUBE_MAP_POSITIVE_Y, eGL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
+      eGL_TEXTURE_CUBE_MAP_POSITIVE_Z, eGL_TEXTURE_CUBE_MAP_NEGATIVE_Z,
+  };
+
+  int count = ARRAY_COUNT(targets);
+
+  if(t != eGL_TEXTURE_CUBE_MAP)
+  {
+    targets[0] = t;
+    count = 1;
+  }
+
+  bool arrayed = (t == eGL_TEXTURE_CUBE_MAP_ARRAY || t == eGL_TEXTURE_1D_ARRAY ||
+                  t == eGL_TEXTURE_2D_ARRAY);
+
+  // the first pass calculates the total size, the second issues the reads into the pack buffer.
+  // Subresources must be visited in the same order and with the same sizes that
+  // Serialise_InitialState consumes them.
+  TextureReadback readback = {};
+  PackBuffer *pb = NULL;
+
+  GLuint ppb = 0, prevtex = 0;
+  PixelPackState pack;
+
+  for(int pass = 0; pass < 2; pass++)
+  {
+    size_t offs = 0;
+
+    GLint w = details.width;
+    GLint h = details.height;
+    GLint d = details.depth;
+
+    for(int i = 0; i < mips; i++)
+    {
+      if(!isCompressed)
+      {
+        w = RDCMAX(details.width >> i, 1);
+        h = RDCMAX(details.height >> i, 1);
+        d = RDCMAX(details.depth >> i, 1);
+      }
+
+      if(arrayed)
+        d = details.depth;
+
+      size_t size = isCompressed ? GetCompressedByteSize(w, h, d, details.internalFormat)
+                                 : GetByteSize(w, h, d, fmt, type);
+
+      for(int trg = 0; trg < count; trg++)
+      {
+        offs = AlignUp16(offs);
+
+        if(pass == 1)
+        {
+          void *dst = (void *)(uintptr_t)(readback.offset + offs);
+
+          if(isCompressed)
+            gl.glGetCompressedTextureImageEXT(tex, targets[trg], i, dst);
+          else
+            gl.glGetTexImage(targets[trg], i, fmt, type, dst);
+        }
+
+        offs += size;
+      }
+
+      if(isCompressed)
+      {
+        if(w > 0)
+          w = RDCMAX(1, w >> 1);
+        if(h > 0)
+          h = RDCMAX(1, h >> 1);
+        if(d > 0)
+          d = RDCMAX(1, d >> 1);
+      }
+    }
+
+    if(pass == 0)
+    {
+      readback.size = offs;
+
+      // find space in the pool, moving on to the next buffer if this one is full
+      while(m_CurPackBuffer < m_PackBuffers.size())
+      {
+        PackBuffer &b = m_PackBuffers[m_CurPackBuffer];
+        if(b.used + readback.size <= b.size)
+        {
+          pb = &b;
+          break;
+        }
+        m_CurPackBuffer++;
+      }
+
+      if(pb == NULL)
+      {
+        PackBuffer b = {};
+        b.size = RDCMAX(readback.size, PackBufferSize);
+
+        gl.glGenBuffers(1, &b.buf);
+        gl.glNamedBufferDataEXT(b.buf, (GLsizeiptr)b.size, NULL, eGL_STREAM_READ);
+
+        m_CurPackBuffer = m_PackBuffers.size();
+        m_PackBuffers.push_back(b);
+        pb = &m_PackBuffers.back();
+      }
+
+      readback.buffer = m_CurPackBuffer;
+      readback.offset = pb->used;
+
+      pb->used = AlignUp16(pb->used + readback.size);
+
+      gl.glGetIntegerv(eGL_PIXEL_PACK_BUFFER_BINDING, (GLint *)&ppb);
+      gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, pb->buf);
+
+      pack.Fetch(&gl, false);
+      ResetPixelPackState(gl, false, 1);
+
+      gl.glGetIntegerv(TextureBinding(t), (GLint *)&prevtex);
+      gl.glBindTexture(t, tex);
+    }
+  }
+
+  gl.glBindTexture(t, prevtex);
+
+  gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, ppb);
+
+  pack.Apply(&gl, false);
+
+  m_TextureReadbacks[origid] = readback;
+}
+
+byte *GLResourceManager::MapTextureReadback(ResourceId origid, size_t &size)
+{
+  auto it = m_TextureReadbacks.find(origid);
+
+  if(it == m_TextureReadbacks.end())
+    return NULL;
+
+  const GLHookSet &gl = m_GL->GetInternalHookset();
+
+  // the first time any readback is needed, wait for them all then map every buffer at once
+  if(!m_PackMapped)
+  {
+    if(m_PackFence)
+    {
+      GLenum status = eGL_TIMEOUT_EXPIRED;
+      while(status == eGL_TIMEOUT_EXPIRED)
+        status = gl.glClientWaitSync(m_PackFence, eGL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL);
+    }
+
+    for(size_t i = 0; i < m_PackBuffers.size(); i++)
+    {
+      PackBuffer &b = m_PackBuffers[i];
+
+      if(b.used > 0)
+        b.data = (byte *)gl.glMapNamedBufferRangeEXT(b.buf, 0, (GLsizeiptr)b.used,
+                                                     eGL_MAP_READ_BIT);
+
+      if(b.used > 0 && b.data == NULL)
+        RDCERR("Couldn't map texture initial contents readback buffer");
+    }
+
+    m_PackMapped = true;
+  }
+
+  byte *data = m_PackBuffers[it->second.buffer].data;
+
+  if(data == NULL)
+    return NULL;
+
+  size = it->second.size;
+
+  return data + it->second.offset;
+}
+
+void GLResourceManager::FenceTextureReadbacks()
+{
+  if(m_TextureReadbacks.empty() || m_PackFence)
+    return;
+
+  const GLHookSet &gl = m_GL->GetInternalHookset();
+
+  m_PackFence = gl.glFenceSync(eGL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  // make sure the readbacks are submitted, as we may serialise on a different context
+  gl.glFlush();
+}
+
+void GLResourceManager::ReleaseTextureReadbacks()
+{
+  const GLHookSet &gl = m_GL->GetInternalHookset();
+
+  if(m_PackFence)
+    gl.glDeleteSync(m_PackFence);
+  m_PackFence = NULL;
+
+  // keep the first buffer around for next time, any others are only needed for larger captures
+  for(size_t i = 0; i < m_PackBuffers.size(); i++)
+  {
+    PackBuffer &b = m_PackBuffers[i];
+
+    if(b.data)
+      gl.glUnmapNamedBufferEXT(b.buf);
+
+    b.data = NULL;
+    b.used = 0;
+
+    if(i > 0)
+      gl.glDeleteBuffers(1, &b.buf);
+  }
+
+  if(m_PackBuffers.size() > 1)
+    m_PackBuffers.resize(1);
+
+  m_CurPackBuffer = 0;
+  m_PackMapped = false;
+  m_TextureReadbacks.clear();
+}
+
 bool GLResourceManager::Force_InitialState(GLResource res, bool prepare)
 {
   if(res.Namespace != eResBuffer && res.Namespace != eResTexture)
@@ -1127,6 +1375,11 @@ bool GLResourceManager::Serialise_InitialState(ResourceId resid, GLResource res)
 
         SERIALISE_ELEMENT(bool, isCompressed, IsCompressedFormat(details.internalFormat));
 
+        // if the contents were read back asynchronously, serialise straight from the mapped pack
+        // buffer. This walks the subresources in the same order as ReadbackTextureContents
+        size_t readbackSize = 0, readbackOffs = 0;
+        byte *readback = MapTextureReadback(Id, readbackSize);
+
         if(details.curType == eGL_TEXTURE_BUFFER || details.view)
         {
           // no contents to copy for texture buffer (it's copied under the buffer)
@@ -1162,6 +1415,17 @@ bool GLResourceManager::Serialise_InitialState(ResourceId resid, GLResource res)
             {
               size_t size = GetCompressedByteSize(w, h, d, details.internalFormat);
 
+              if(readback)
+              {
+                readbackOffs = AlignUp16(readbackOffs);
+
+                byte *buf = readback + readbackOffs;
+                m_pSerialiser->SerialiseBuffer("image", buf, size);
+
+                readbackOffs += size;
+                continue;
+              }
+
               byte *buf = new byte[size];
 
               gl.glGetCompressedTextureImageEXT(tex, targets[trg], i, buf);
@@ -1190,7 +1454,7 @@ bool GLResourceManager::Serialise_InitialState(ResourceId resid, GLResource res)
 
           size_t size = GetByteSize(details.width, details.height, details.depth, fmt, type);
 
-          byte *buf = new byte[size];
+          byte *buf = readback ? NULL : new byte[size];
 
           GLenum binding = TextureBinding(t);
 
@@ -1227,6 +1491,17 @@ bool GLResourceManager::Serialise_InitialState(ResourceId resid, GLResource res)
 
             for(int trg = 0; trg < count; trg++)
             {
+              if(readback)
+              {
+                readbackOffs = AlignUp16(readbackOffs);
+
+                byte *rbbuf = readback + readbackOffs;
+                m_pSerialiser->SerialiseBuffer("image", rbbuf, size);
+
+                readbackOffs += size;
+                continue;
+              }
+
               // we avoid glGetTextureImageEXT as it seems buggy for cubemap faces
               gl.glGetTexImage(targets[trg], i, fmt, type, buf);
 
@@ -1239,6 +1514,9 @@ bool GLResourceManager::Serialise_InitialState(ResourceId resid, GLResource res)
           SAFE_DELETE_ARRAY(buf);
         }
 
+        if(readback)
+          RDCASSERTEQUAL(readbackOffs, readbackSize);
+
         gl.glBindBuffer(eGL_PIXEL_PACK_BUFFER, ppb);
 
         pack.Apply(&gl, false);
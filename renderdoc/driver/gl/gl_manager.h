@@ -34,7 +34,12 @@ class GLResourceManager : public ResourceManager<GLResource, GLResource, GLResou
 {
 public:
   GLResourceManager(LogState state, Serialiser *ser, WrappedOpenGL *gl)
-      : ResourceManager(state, ser), m_GL(gl), m_SyncName(1)
+      : ResourceManager(state, ser),
+        m_GL(gl),
+        m_SyncName(1),
+        m_CurPackBuffer(0),
+        m_PackFence(NULL),
+        m_PackMapped(false)
   {
   }
   ~GLResourceManager() {}
@@ -212,6 +217,11 @@ public:
   bool Prepare_InitialState(GLResource res, byte *blob);
   bool Serialise_InitialState(ResourceId resid, GLResource res);
 
+  // called once all initial contents are prepared, to fence the pending texture readbacks
+  void FenceTextureReadbacks();
+  // called once initial contents are serialised, returns pixel pack buffers to the pool
+  void ReleaseTextureReadbacks();
+
 private:
   bool SerialisableResource(ResourceId id, GLResourceRecord *record);
 
@@ -222,6 +232,33 @@ private:
 
   void PrepareTextureInitialContents(ResourceId liveid, ResourceId origid, GLResource res);
 
+  // texture initial contents are read back asynchronously into pooled pixel pack buffers as soon
+  // as they're prepared. The buffers are then mapped in bulk the first time one is serialised, so
+  // there's no pipeline drain per texture.
+  struct PackBuffer
+  {
+    GLuint buf;
+    size_t size;
+    size_t used;
+    byte *data;
+  };
+
+  struct TextureReadback
+  {
+    size_t buffer;
+    size_t offset;
+    size_t size;
+  };
+
+  void ReadbackTextureContents(ResourceId liveid, ResourceId origid, GLuint tex);
+  byte *MapTextureReadback(ResourceId origid, size_t &size);
+
+  vector<PackBuffer> m_PackBuffers;
+  size_t m_CurPackBuffer;
+  GLsync m_PackFence;
+  bool m_PackMapped;
+  map<ResourceId, TextureReadback> m_TextureReadbacks;
+
   void Create_InitialState(ResourceId id, GLResource live, bool hasData);
   void Apply_InitialState(GLResource live, InitialContentData initial);
 
@@ -835,6 +835,11 @@ vector<DebugMessage> GLReplay::GetDebugMessages()
   return m_pDriver->GetDebugMessages();
 }
 
+vector<ChunkProfile> GLReplay::GetChunkProfile()
+{
+  return m_pDriver->GetChunkProfile();
+}
+
 ShaderReflection *GLReplay::GetShader(ResourceId shader, string entryPoint)
 {
   auto &shaderDetails = m_pDriver->m_Shaders[shader];
@@ -102,6 +102,7 @@ public:
   ShaderReflection *GetShader(ResourceId shader, string entryPoint);
 
   vector<DebugMessage> GetDebugMessages();
+  vector<ChunkProfile> GetChunkProfile();
 
   vector<EventUsage> GetUsage(ResourceId id);
 
@@ -164,6 +165,7 @@ public:
   vector<GPUCounter> EnumerateCounters();
   void DescribeCounter(GPUCounter counterID, CounterDescription &desc);
   vector<CounterResult> FetchCounters(const vector<GPUCounter> &counters);
+  double GetIsolatedDuration(uint32_t eventID);
 
   void RenderMesh(uint32_t eventID, const vector<MeshFormat> &secondaryDraws, const MeshDisplay &cfg);
 
@@ -383,6 +385,10 @@ private:
   void FillTimers(GLCounterContext &ctx, const DrawcallTreeNode &drawnode,
                   const vector<GPUCounter> &counters);
 
+  // query objects for each counter, kept between FetchCounters calls. Each is only ever used with
+  // its counter's target, as a query object can't change target once it's been begun.
+  vector<GLuint> m_CounterQueries[ENUM_ARRAY_SIZE(GPUCounter)];
+
   GLuint CreateShaderProgram(const vector<string> &vs, const vector<string> &fs,
                              const vector<string> &gs);
   GLuint CreateShaderProgram(const vector<string> &vs, const vector<string> &fs);
@@ -229,6 +229,10 @@ struct GLResourceRecord : public ResourceRecord
 
     byte *persistentPtr;
     int64_t persistentMaps;    // counter indicating how many coherent maps are 'live'
+
+    // if the TrackMapWrites option is enabled, tracks which pages of the shadow storage have been
+    // written while the buffer is persistently mapped.
+    WriteWatch::Region *writeWatch;
   } Map;
 
   template <typename ChunkFilter>
@@ -278,7 +282,11 @@ struct GLResourceRecord : public ResourceRecord
   {
     if(ShadowPtr[0] == NULL)
     {
-      ShadowPtr[0] = Serialiser::AllocAlignedBuffer(size + sizeof(markerValue));
+      // the first shadow is what persistent maps hand to the application, and it might be
+      // write-watched, so it gets whole pages to itself to avoid protecting anything else.
+      const size_t pageSize = WriteWatch::GetPageSize();
+      ShadowPtr[0] =
+          Serialiser::AllocAlignedBuffer(AlignUp(size + sizeof(markerValue), pageSize), pageSize);
       ShadowPtr[1] = Serialiser::AllocAlignedBuffer(size + sizeof(markerValue));
 
       memcpy(ShadowPtr[0] + size, markerValue, sizeof(markerValue));
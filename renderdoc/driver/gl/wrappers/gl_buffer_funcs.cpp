@@ -1901,6 +1901,12 @@ void *WrappedOpenGL::glMapNamedBufferRangeEXT(GLuint buffer, GLintptr offset, GL
 
         record->Map.ptr = ptr = record->GetShadowPtr(0) + offset;
         record->Map.status = GLResourceRecord::Mapped_Write;
+
+        // watch the whole shadow buffer, since any persistent map can write anywhere in it. Every
+        // page starts dirty so the first memory barrier still compares everything.
+        if(record->Map.writeWatch == NULL && RenderDoc::Inst().GetCaptureOptions().TrackMapWrites)
+          record->Map.writeWatch =
+              WriteWatch::Begin(record->GetShadowPtr(0), (size_t)record->Length);
       }
       else if(m_State == WRITING_CAPFRAME)
       {
@@ -2293,6 +2299,9 @@ GLboolean WrappedOpenGL::glUnmapNamedBufferEXT(GLuint buffer)
         m_PersistentMaps.erase(record);
         if(record->Map.access & GL_MAP_COHERENT_BIT)
           m_CoherentMaps.erase(record);
+
+        WriteWatch::End(record->Map.writeWatch);
+        record->Map.writeWatch = NULL;
       }
     }
 
@@ -2497,11 +2506,38 @@ void WrappedOpenGL::PersistentMapMemoryBarrier(const set<GLResourceRecord *> &ma
 
     RDCASSERT(record && record->Map.persistentPtr);
 
-    size_t diffStart = 0, diffEnd = 0;
-    bool found = FindDiffRange(record->GetShadowPtr(0), record->GetShadowPtr(1),
-                               (size_t)record->Length, diffStart, diffEnd);
-    if(found)
+    // find each run of modified pages rather than one range from the first to the last
+    // difference, so scattered small writes to a large buffer don't flush everything in between.
+    // If we're tracking writes, only the pages written since the last barrier need comparing.
+    if(record->Map.writeWatch)
     {
+      WriteWatch::GetDirtyRanges(record->Map.writeWatch, m_MapDirtyPages);
+
+      m_MapDiffRanges.clear();
+
+      for(size_t p = 0; p < m_MapDirtyPages.size(); p++)
+      {
+        size_t pageStart = m_MapDirtyPages[p].first;
+
+        FindDiffRanges(record->GetShadowPtr(0) + pageStart, record->GetShadowPtr(1) + pageStart,
+                       m_MapDirtyPages[p].second, m_MapPageDiffRanges);
+
+        for(size_t r = 0; r < m_MapPageDiffRanges.size(); r++)
+          m_MapDiffRanges.push_back(std::make_pair(pageStart + m_MapPageDiffRanges[r].first,
+                                                   pageStart + m_MapPageDiffRanges[r].second));
+      }
+    }
+    else
+    {
+      FindDiffRanges(record->GetShadowPtr(0), record->GetShadowPtr(1), (size_t)record->Length,
+                     m_MapDiffRanges);
+    }
+
+    for(size_t r = 0; r < m_MapDiffRanges.size(); r++)
+    {
+      size_t diffStart = m_MapDiffRanges[r].first;
+      size_t diffEnd = m_MapDiffRanges[r].second;
+
       // update the modified region in the 'comparison' shadow buffer for next check
       memcpy(record->GetShadowPtr(1) + diffStart, record->GetShadowPtr(0) + diffStart,
              diffEnd - diffStart);
@@ -4393,6 +4429,10 @@ void WrappedOpenGL::glDeleteBuffers(GLsizei n, const GLuint *buffers)
           m_Real.glUnmapNamedBufferEXT(res.name);
         }
 
+        // stop watching before the shadow storage is freed, so its pages are writeable again
+        WriteWatch::End(record->Map.writeWatch);
+        record->Map.writeWatch = NULL;
+
         // free any shadow storage
         record->FreeShadowStorage();
       }
@@ -0,0 +1,775 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "vk_core.h"
+
+// replay cost is estimated in events, with this many bytes of serialised chunk data (which is
+// mostly memory uploads) counting as one more event.
+static const uint64_t CheckpointBytesPerEvent = 4 * 1024;
+
+static VkImageAspectFlags FormatAspects(VkFormat fmt)
+{
+  if(IsStencilOnlyFormat(fmt))
+    return VK_IMAGE_ASPECT_STENCIL_BIT;
+  else if(IsDepthOnlyFormat(fmt))
+    return VK_IMAGE_ASPECT_DEPTH_BIT;
+  else if(IsDepthAndStencilFormat(fmt))
+    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+
+  return VK_IMAGE_ASPECT_COLOR_BIT;
+}
+
+// one region per mip, covering every layer
+static void GetWholeImageCopies(const VulkanCreationInfo::Image &info, vector<VkImageCopy> &regions)
+{
+  VkExtent3D extent = info.extent;
+
+  for(int m = 0; m < info.mipLevels; m++)
+  {
+    VkImageCopy region = {
+        {FormatAspects(info.format), (uint32_t)m, 0, (uint32_t)info.arrayLayers},
+        {0, 0, 0},
+        {FormatAspects(info.format), (uint32_t)m, 0, (uint32_t)info.arrayLayers},
+        {0, 0, 0},
+        extent,
+    };
+
+    regions.push_back(region);
+
+    extent.width = RDCMAX(extent.width >> 1, 1U);
+    extent.height = RDCMAX(extent.height >> 1, 1U);
+    extent.depth = RDCMAX(extent.depth >> 1, 1U);
+  }
+}
+
+static bool SameLayouts(const ImageLayouts &a, const ImageLayouts &b)
+{
+  if(a.subresourceStates.size() != b.subresourceStates.size())
+    return false;
+
+  for(size_t i = 0; i < a.subresourceStates.size(); i++)
+  {
+    const VkImageSubresourceRange &ra = a.subresourceStates[i].subresourceRange;
+    const VkImageSubresourceRange &rb = b.subresourceStates[i].subresourceRange;
+
+    if(a.subresourceStates[i].newLayout != b.subresourceStates[i].newLayout ||
+       ra.aspectMask != rb.aspectMask || ra.baseMipLevel != rb.baseMipLevel ||
+       ra.levelCount != rb.levelCount || ra.baseArrayLayer != rb.baseArrayLayer ||
+       ra.layerCount != rb.layerCount)
+      return false;
+  }
+
+  return true;
+}
+
+void WrappedVulkan::AddCheckpointCandidate(const vector<ResourceId> &cmdIds)
+{
+  CheckpointCandidate candidate;
+  candidate.eventID = m_RootEventID;
+  // filled in once the rest of the submit's chunk has been read
+  candidate.fileOffset = 0;
+  candidate.recordStart = m_CurChunkOffset;
+
+  for(size_t c = 0; c < cmdIds.size(); c++)
+  {
+    BakedCmdBufferInfo &cmdBufInfo = m_BakedCmdBufferInfo[cmdIds[c]];
+
+    candidate.recordStart = RDCMIN(candidate.recordStart, cmdBufInfo.beginOffset);
+
+    if(cmdBufInfo.draw == NULL)
+      continue;
+
+    // secondaries executed from this command buffer are recorded separately
+    for(size_t e = 0; e < cmdBufInfo.draw->executedCmds.size(); e++)
+    {
+      ResourceId secondary = cmdBufInfo.draw->executedCmds[e];
+      candidate.recordStart =
+          RDCMIN(candidate.recordStart, m_BakedCmdBufferInfo[secondary].beginOffset);
+    }
+  }
+
+  m_CheckpointCandidates.push_back(candidate);
+}
+
+void WrappedVulkan::PrepareCheckpoints()
+{
+  vector<CheckpointCandidate> candidates;
+  candidates.swap(m_CheckpointCandidates);
+
+  int budgetMB = atoi(RenderDoc::Inst().GetConfigSetting("replay.checkpointBudgetMB").c_str());
+
+  if(budgetMB <= 0 || candidates.empty())
+    return;
+
+  // a checkpoint can only be resumed from if every command buffer submitted after it also began
+  // recording after it, since we skip straight past any earlier recording.
+  vector<CheckpointCandidate> valid;
+
+  uint64_t laterRecordStart = ~0ULL;
+  for(size_t i = candidates.size(); i-- > 0;)
+  {
+    if(candidates[i].fileOffset <= laterRecordStart)
+      valid.insert(valid.begin(), candidates[i]);
+
+    laterRecordStart = RDCMIN(laterRecordStart, candidates[i].recordStart);
+  }
+
+  if(valid.empty())
+    return;
+
+  VkDevice d = GetDev();
+
+  vector<ResourceId> ids;
+  GetResourceManager()->GetInitialContentsIDs(ids);
+
+  // images are only snapshotted if something in the frame could write to them
+  std::set<ResourceId> writtenImages;
+
+  for(auto it = m_CreationInfo.m_Framebuffer.begin(); it != m_CreationInfo.m_Framebuffer.end();
+      ++it)
+  {
+    for(size_t a = 0; a < it->second.attachments.size(); a++)
+      writtenImages.insert(m_CreationInfo.m_ImageView[it->second.attachments[a].view].image);
+  }
+
+  for(auto it = m_ResourceUses.begin(); it != m_ResourceUses.end(); ++it)
+  {
+    for(size_t u = 0; u < it->second.size(); u++)
+    {
+      if(IsWriteUsage(it->second[u].usage))
+      {
+        writtenImages.insert(it->first);
+        break;
+      }
+    }
+  }
+
+  // ranges of each memory object to save, by live ID, as offset and size
+  map<ResourceId, vector<pair<VkDeviceSize, VkDeviceSize> > > memRanges = m_FrameHostWrites;
+
+  VkDeviceSize snapshotSize = 0;
+  const VkDeviceSize granularity = GetDeviceProps().limits.bufferImageGranularity;
+
+  for(size_t i = 0; i < ids.size(); i++)
+  {
+    if(!GetResourceManager()->HasLiveResource(ids[i]))
+      continue;
+
+    WrappedVkRes *res = GetResourceManager()->GetLiveResource(ids[i]);
+    ResourceId liveid = GetResourceManager()->GetLiveID(ids[i]);
+    VkResourceType type = IdentifyTypeByPtr(res);
+
+    VulkanResourceManager::InitialContentData initial =
+        GetResourceManager()->GetInitialContents(ids[i]);
+
+    if((type == eResBuffer || type == eResImage) && initial.num == eInitialContents_Sparse)
+    {
+      RDCLOG("Not using replay checkpoints, capture contains sparse resources");
+      m_CheckpointImages.clear();
+      m_CheckpointDescSets.clear();
+      return;
+    }
+
+    if(type == eResDescriptorSet)
+    {
+      m_CheckpointDescSets.push_back(liveid);
+    }
+    else if(type == eResImage)
+    {
+      if(writtenImages.find(liveid) == writtenImages.end())
+        continue;
+
+      VkMemoryRequirements mrq = {0};
+      ObjDisp(d)->GetImageMemoryRequirements(Unwrap(d), ToHandle<VkImage>(res), &mrq);
+
+      snapshotSize = AlignUp(snapshotSize, RDCMAX(mrq.alignment, granularity)) + mrq.size;
+
+      m_CheckpointImages.push_back(liveid);
+    }
+    else if(type == eResDeviceMemory && initial.resource)
+    {
+      if(initial.blob)
+      {
+        VkBufferCopy *regions = (VkBufferCopy *)initial.blob;
+        for(uint32_t r = 0; r < initial.num; r++)
+          memRanges[liveid].push_back(std::make_pair(regions[r].dstOffset, regions[r].size));
+      }
+      else
+      {
+        memRanges[liveid].push_back(std::make_pair(VkDeviceSize(0), VkDeviceSize(initial.num)));
+      }
+    }
+  }
+
+  // merge overlapping ranges and pack them one after another into the snapshot buffer
+  for(auto it = memRanges.begin(); it != memRanges.end(); ++it)
+  {
+    vector<pair<VkDeviceSize, VkDeviceSize> > &ranges = it->second;
+
+    std::sort(ranges.begin(), ranges.end());
+
+    vector<VkBufferCopy> regions;
+    VkDeviceSize packed = 0;
+
+    for(size_t r = 0; r < ranges.size(); r++)
+    {
+      VkDeviceSize end = ranges[r].first + ranges[r].second;
+
+      if(!regions.empty() && ranges[r].first <= regions.back().dstOffset + regions.back().size)
+      {
+        VkBufferCopy &last = regions.back();
+
+        if(end > last.dstOffset + last.size)
+        {
+          packed += end - (last.dstOffset + last.size);
+          last.size = end - last.dstOffset;
+        }
+
+        continue;
+      }
+
+      VkBufferCopy region = {packed, ranges[r].first, ranges[r].second};
+      regions.push_back(region);
+      packed += ranges[r].second;
+    }
+
+    if(regions.empty())
+      continue;
+
+    m_CheckpointMemRegions[it->first] = std::make_pair(regions, packed);
+
+    snapshotSize = AlignUp(snapshotSize, granularity) + packed;
+  }
+
+  uint64_t budget = uint64_t(budgetMB) * 1024 * 1024;
+
+  size_t count = valid.size();
+  if(snapshotSize > 0)
+    count = RDCMIN(count, size_t(budget / snapshotSize));
+
+  if(count == 0)
+  {
+    RDCLOG("Not using replay checkpoints, %llu MB snapshot is over the %d MB budget",
+           snapshotSize / (1024 * 1024), budgetMB);
+    m_CheckpointImages.clear();
+    m_CheckpointDescSets.clear();
+    m_CheckpointMemRegions.clear();
+    return;
+  }
+
+  // space the checkpoints evenly by the estimated cost of replaying from the start of the frame,
+  // so that a seek never replays much more than one interval's worth
+  const uint64_t frameStart = m_FrameRecord.frameInfo.fileOffset;
+
+  uint64_t totalCost =
+      GetMaxEID() + (m_pSerialiser->GetSize() - frameStart) / CheckpointBytesPerEvent;
+  uint64_t spacing = RDCMAX(totalCost / (count + 1), (uint64_t)1);
+  uint64_t nextCost = spacing;
+
+  for(size_t i = 0; i < valid.size() && m_Checkpoints.size() < count; i++)
+  {
+    uint64_t cost = valid[i].eventID + (valid[i].fileOffset - frameStart) / CheckpointBytesPerEvent;
+
+    if(cost < nextCost)
+      continue;
+
+    ReplayCheckpoint checkpoint;
+    checkpoint.eventID = valid[i].eventID;
+    checkpoint.fileOffset = valid[i].fileOffset;
+    m_Checkpoints.push_back(checkpoint);
+
+    nextCost = cost + spacing;
+  }
+
+  RDCLOG("Using %u replay checkpoints of %llu MB each", (uint32_t)m_Checkpoints.size(),
+         snapshotSize / (1024 * 1024));
+}
+
+WrappedVulkan::ReplayCheckpoint *WrappedVulkan::FindCheckpoint(uint32_t eventID)
+{
+  ReplayCheckpoint *ret = NULL;
+
+  for(size_t i = 0; i < m_Checkpoints.size() && m_Checkpoints[i].eventID <= eventID; i++)
+    ret = &m_Checkpoints[i];
+
+  return ret;
+}
+
+void WrappedVulkan::CreateCheckpoint(ReplayCheckpoint &checkpoint)
+{
+  VkDevice d = GetDev();
+  VkResult vkr = VK_SUCCESS;
+
+  const VkDeviceSize granularity = GetDeviceProps().limits.bufferImageGranularity;
+
+  // create everything first so it can all go in one allocation
+  vector<VkBuffer> bufs;
+  vector<VkImage> ims;
+  vector<VkDeviceSize> offsets;
+  VkDeviceSize allocSize = 0;
+  uint32_t memoryTypeBits = ~0U;
+
+  for(auto it = m_CheckpointMemRegions.begin(); it != m_CheckpointMemRegions.end(); ++it)
+  {
+    VkBufferCreateInfo bufInfo = {
+        VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        NULL,
+        0,
+        it->second.second,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+    };
+
+    VkBuffer buf = VK_NULL_HANDLE;
+
+    vkr = ObjDisp(d)->CreateBuffer(Unwrap(d), &bufInfo, NULL, &buf);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    GetResourceManager()->WrapResource(Unwrap(d), buf);
+
+    VkMemoryRequirements mrq = {0};
+    ObjDisp(d)->GetBufferMemoryRequirements(Unwrap(d), Unwrap(buf), &mrq);
+
+    allocSize = AlignUp(allocSize, RDCMAX(mrq.alignment, granularity));
+    offsets.push_back(allocSize);
+    allocSize += mrq.size;
+    memoryTypeBits &= mrq.memoryTypeBits;
+
+    bufs.push_back(buf);
+  }
+
+  for(size_t i = 0; i < m_CheckpointImages.size(); i++)
+  {
+    const VulkanCreationInfo::Image &info = m_CreationInfo.m_Image[m_CheckpointImages[i]];
+
+    VkImageCreateInfo imInfo = {
+        VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        NULL,
+        0,
+        info.type,
+        info.format,
+        info.extent,
+        (uint32_t)info.mipLevels,
+        (uint32_t)info.arrayLayers,
+        info.samples,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        VK_SHARING_MODE_EXCLUSIVE,
+        0,
+        NULL,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    VkImage im = VK_NULL_HANDLE;
+
+    vkr = ObjDisp(d)->CreateImage(Unwrap(d), &imInfo, NULL, &im);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    GetResourceManager()->WrapResource(Unwrap(d), im);
+
+    VkMemoryRequirements mrq = {0};
+    ObjDisp(d)->GetImageMemoryRequirements(Unwrap(d), Unwrap(im), &mrq);
+
+    allocSize = AlignUp(allocSize, RDCMAX(mrq.alignment, granularity));
+    offsets.push_back(allocSize);
+    allocSize += mrq.size;
+    memoryTypeBits &= mrq.memoryTypeBits;
+
+    ims.push_back(im);
+  }
+
+  VkDeviceMemory mem = VK_NULL_HANDLE;
+
+  if(allocSize > 0)
+  {
+    vkr = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+    if(memoryTypeBits != 0)
+    {
+      VkMemoryAllocateInfo allocInfo = {
+          VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, allocSize,
+          GetGPULocalMemoryIndex(memoryTypeBits),
+      };
+
+      vkr = ObjDisp(d)->AllocateMemory(Unwrap(d), &allocInfo, NULL, &mem);
+    }
+
+    if(vkr != VK_SUCCESS)
+    {
+      RDCWARN("Couldn't allocate %llu bytes for replay checkpoint, disabling checkpoints",
+              allocSize);
+
+      for(size_t i = 0; i < bufs.size(); i++)
+      {
+        ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(bufs[i]), NULL);
+        GetResourceManager()->ReleaseWrappedResource(bufs[i]);
+      }
+
+      for(size_t i = 0; i < ims.size(); i++)
+      {
+        ObjDisp(d)->DestroyImage(Unwrap(d), Unwrap(ims[i]), NULL);
+        GetResourceManager()->ReleaseWrappedResource(ims[i]);
+      }
+
+      FreeCheckpoints();
+      m_Checkpoints.clear();
+      m_CreatingCheckpoints = false;
+      m_ResumeCheckpoint = NULL;
+      return;
+    }
+
+    GetResourceManager()->WrapResource(Unwrap(d), mem);
+
+    checkpoint.mems.push_back(mem);
+
+    size_t o = 0;
+
+    for(size_t i = 0; i < bufs.size(); i++, o++)
+    {
+      vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), Unwrap(bufs[i]), Unwrap(mem), offsets[o]);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    }
+
+    for(size_t i = 0; i < ims.size(); i++, o++)
+    {
+      vkr = ObjDisp(d)->BindImageMemory(Unwrap(d), Unwrap(ims[i]), Unwrap(mem), offsets[o]);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    }
+  }
+
+  // the submit's work has to have finished before we can copy out what it wrote
+  ObjDisp(d)->DeviceWaitIdle(Unwrap(d));
+
+  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+  VkCommandBuffer cmd = GetNextCmd();
+
+  vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  VkMemoryBarrier memBarrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL, VK_ACCESS_ALL_WRITE_BITS, VK_ACCESS_TRANSFER_READ_BIT,
+  };
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  {
+    size_t i = 0;
+    for(auto it = m_CheckpointMemRegions.begin(); it != m_CheckpointMemRegions.end(); ++it, i++)
+    {
+      const vector<VkBufferCopy> &regions = it->second.first;
+
+      // the regions are stored for restoring, so copy out in the opposite direction
+      vector<VkBufferCopy> save = regions;
+      for(size_t r = 0; r < save.size(); r++)
+        std::swap(save[r].srcOffset, save[r].dstOffset);
+
+      VkBuffer memBuf = m_CreationInfo.m_Memory[it->first].wholeMemBuf;
+
+      ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(memBuf), Unwrap(bufs[i]),
+                                  (uint32_t)save.size(), &save[0]);
+
+      byte *blob = Serialiser::AllocAlignedBuffer(sizeof(VkBufferCopy) * regions.size());
+      memcpy(blob, &regions[0], sizeof(VkBufferCopy) * regions.size());
+
+      checkpoint.contents[it->first] = VulkanResourceManager::InitialContentData(
+          GetWrapped(bufs[i]), (uint32_t)regions.size(), blob);
+    }
+  }
+
+  for(size_t i = 0; i < m_CheckpointImages.size(); i++)
+  {
+    ResourceId liveid = m_CheckpointImages[i];
+    VkImage live = Unwrap(GetResourceManager()->GetCurrentHandle<VkImage>(liveid));
+    ImageLayouts &layouts = m_ImageLayouts[liveid];
+
+    VkImageMemoryBarrier barrier = {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        NULL,
+        VK_ACCESS_ALL_WRITE_BITS,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        live,
+        {0, 0, 1, 0, 1}};
+
+    for(size_t si = 0; si < layouts.subresourceStates.size(); si++)
+    {
+      barrier.subresourceRange = layouts.subresourceStates[si].subresourceRange;
+      barrier.oldLayout = layouts.subresourceStates[si].newLayout;
+      DoPipelineBarrier(cmd, 1, &barrier);
+    }
+
+    VkImageMemoryBarrier copyBarrier = {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        NULL,
+        0,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        Unwrap(ims[i]),
+        {FormatAspects(m_CreationInfo.m_Image[liveid].format), 0, VK_REMAINING_MIP_LEVELS, 0,
+         VK_REMAINING_ARRAY_LAYERS}};
+
+    DoPipelineBarrier(cmd, 1, &copyBarrier);
+
+    vector<VkImageCopy> regions;
+    GetWholeImageCopies(m_CreationInfo.m_Image[liveid], regions);
+
+    ObjDisp(cmd)->CmdCopyImage(Unwrap(cmd), live, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               Unwrap(ims[i]), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               (uint32_t)regions.size(), &regions[0]);
+
+    // the copy stays in TRANSFER_SRC_OPTIMAL, ready to be restored from
+    copyBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    copyBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    copyBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    copyBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    DoPipelineBarrier(cmd, 1, &copyBarrier);
+
+    // put the live image back how it was. Subresources that were never transitioned can't go
+    // back to undefined, so they're tracked as general from here on.
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    for(size_t si = 0; si < layouts.subresourceStates.size(); si++)
+    {
+      ImageRegionState &state = layouts.subresourceStates[si];
+
+      if(state.newLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+        state.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+      barrier.subresourceRange = state.subresourceRange;
+      barrier.newLayout = state.newLayout;
+      barrier.dstAccessMask = MakeAccessMask(state.newLayout);
+      DoPipelineBarrier(cmd, 1, &barrier);
+    }
+
+    checkpoint.images[liveid] = ims[i];
+  }
+
+  vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  SubmitCmds();
+
+  // descriptor sets are only tracked on the CPU, so they can be saved while the copies run
+  for(size_t i = 0; i < m_CheckpointDescSets.size(); i++)
+  {
+    ResourceId liveid = m_CheckpointDescSets[i];
+    DescriptorSetInfo &setInfo = m_DescriptorSetState[liveid];
+    const DescSetLayout &layout = m_CreationInfo.m_DescSetLayout[setInfo.layout];
+
+    if(setInfo.currentBindings.size() != layout.bindings.size())
+      continue;
+
+    vector<DescriptorSetSlot> slots;
+
+    for(size_t b = 0; b < layout.bindings.size(); b++)
+      slots.insert(slots.end(), setInfo.currentBindings[b],
+                   setInfo.currentBindings[b] + layout.bindings[b].descriptorCount);
+
+    if(slots.empty())
+      continue;
+
+    uint32_t validBinds = 0;
+    byte *blob = MakeDescriptorSetWrites(
+        ToHandle<VkDescriptorSet>(GetResourceManager()->GetCurrentResource(liveid)), layout,
+        &slots[0], (uint32_t)slots.size(), validBinds);
+
+    checkpoint.contents[liveid] = VulkanResourceManager::InitialContentData(NULL, validBinds, blob);
+  }
+
+  checkpoint.imageLayouts = m_ImageLayouts;
+  checkpoint.created = true;
+
+  // the replay carries on with the app's queues, make sure we're done with the live resources
+  FlushQ();
+}
+
+void WrappedVulkan::RestoreCheckpoint(ReplayCheckpoint &checkpoint)
+{
+  VkResult vkr = VK_SUCCESS;
+
+  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+  // same as ApplyInitialContents, make sure everything from the last replay has finished first
+  VkMemoryBarrier memBarrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL, VK_ACCESS_ALL_WRITE_BITS, VK_ACCESS_ALL_READ_BITS,
+  };
+
+  VkCommandBuffer cmd = GetNextCmd();
+
+  vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  // move every image from its current layouts to the checkpoint's, copying back the contents of
+  // any that were saved on the way.
+  for(auto it = checkpoint.imageLayouts.begin(); it != checkpoint.imageLayouts.end(); ++it)
+  {
+    ResourceId liveid = it->first;
+
+    auto cur = m_ImageLayouts.find(liveid);
+    if(cur == m_ImageLayouts.end())
+      continue;
+
+    auto saved = checkpoint.images.find(liveid);
+    bool restore = (saved != checkpoint.images.end());
+
+    if(!restore && SameLayouts(cur->second, it->second))
+      continue;
+
+    VkImageLayout via = restore ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+    VkImageMemoryBarrier barrier = {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        NULL,
+        VK_ACCESS_ALL_WRITE_BITS,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        via,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        Unwrap(GetResourceManager()->GetCurrentHandle<VkImage>(liveid)),
+        {0, 0, 1, 0, 1}};
+
+    for(size_t si = 0; si < cur->second.subresourceStates.size(); si++)
+    {
+      barrier.subresourceRange = cur->second.subresourceStates[si].subresourceRange;
+      barrier.oldLayout = cur->second.subresourceStates[si].newLayout;
+      DoPipelineBarrier(cmd, 1, &barrier);
+    }
+
+    if(restore)
+    {
+      vector<VkImageCopy> regions;
+      GetWholeImageCopies(m_CreationInfo.m_Image[liveid], regions);
+
+      ObjDisp(cmd)->CmdCopyImage(Unwrap(cmd), Unwrap(saved->second),
+                                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, barrier.image,
+                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)regions.size(),
+                                 &regions[0]);
+    }
+
+    ImageLayouts layouts = it->second;
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = via;
+
+    for(size_t si = 0; si < layouts.subresourceStates.size(); si++)
+    {
+      ImageRegionState &state = layouts.subresourceStates[si];
+
+      // can't transition back to undefined, stay in the intermediate layout instead
+      if(state.newLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+        state.newLayout = via;
+
+      barrier.subresourceRange = state.subresourceRange;
+      barrier.newLayout = state.newLayout;
+      barrier.dstAccessMask = MakeAccessMask(state.newLayout);
+      DoPipelineBarrier(cmd, 1, &barrier);
+    }
+
+    cur->second = layouts;
+  }
+
+  vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  SubmitCmds();
+  FlushQ();
+
+  // memory and descriptor sets are stored just like initial contents
+  for(auto it = checkpoint.contents.begin(); it != checkpoint.contents.end(); ++it)
+    Apply_InitialState(GetResourceManager()->GetCurrentResource(it->first), it->second);
+
+  cmd = GetNextCmd();
+
+  vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  SubmitCmds();
+  FlushQ();
+}
+
+void WrappedVulkan::FreeCheckpoint(ReplayCheckpoint &checkpoint)
+{
+  VkDevice d = GetDev();
+
+  for(auto it = checkpoint.images.begin(); it != checkpoint.images.end(); ++it)
+  {
+    ObjDisp(d)->DestroyImage(Unwrap(d), Unwrap(it->second), NULL);
+    GetResourceManager()->ReleaseWrappedResource(it->second);
+  }
+
+  for(auto it = checkpoint.contents.begin(); it != checkpoint.contents.end(); ++it)
+  {
+    if(it->second.resource)
+    {
+      VkBuffer buf = (VkBuffer)(uint64_t)it->second.resource;
+      ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(buf), NULL);
+      GetResourceManager()->ReleaseWrappedResource(buf);
+    }
+
+    Serialiser::FreeAlignedBuffer(it->second.blob);
+  }
+
+  for(size_t i = 0; i < checkpoint.mems.size(); i++)
+  {
+    ObjDisp(d)->FreeMemory(Unwrap(d), Unwrap(checkpoint.mems[i]), NULL);
+    GetResourceManager()->ReleaseWrappedResource(checkpoint.mems[i]);
+  }
+
+  checkpoint.images.clear();
+  checkpoint.contents.clear();
+  checkpoint.imageLayouts.clear();
+  checkpoint.mems.clear();
+  checkpoint.created = false;
+}
+
+void WrappedVulkan::FreeCheckpoints()
+{
+  if(m_Checkpoints.empty())
+    return;
+
+  ObjDisp(GetDev())->DeviceWaitIdle(Unwrap(GetDev()));
+
+  // the checkpoints themselves stay, to be taken again on the next replay that passes them
+  for(size_t i = 0; i < m_Checkpoints.size(); i++)
+    if(m_Checkpoints[i].created)
+      FreeCheckpoint(m_Checkpoints[i]);
+}
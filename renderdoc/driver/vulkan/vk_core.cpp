@@ -170,6 +170,8 @@ VkInitParams::VkInitParams()
 // Here we list which non-current versions we support, and what changed
 const uint32_t VkInitParams::VK_OLD_VERSIONS[VkInitParams::VK_NUM_SUPPORTED_OLD_VERSIONS] = {
     0x0000005,    // from 0x5 to 0x6, we added serialisation of the original swapchain's imageUsage
+    0x0000006,    // from 0x6 to 0x7, we added an omitted flag to image initial contents
+    0x0000007,    // from 0x7 to 0x8, memory initial contents can contain only the bound ranges
 };
 
 ReplayStatus VkInitParams::Serialise()
@@ -292,6 +294,10 @@ WrappedVulkan::WrappedVulkan(const char *logFilename) : m_RenderState(&m_Creatio
 
   m_AppControlledCapture = false;
 
+  m_CoherentMapWorkers = NULL;
+
+  m_InitStateBatch.cmd = VK_NULL_HANDLE;
+
   threadSerialiserTLSSlot = Threading::AllocateTLSSlot();
   tempMemoryTLSSlot = Threading::AllocateTLSSlot();
   debugMessageSinkTLSSlot = Threading::AllocateTLSSlot();
@@ -308,6 +314,12 @@ WrappedVulkan::WrappedVulkan(const char *logFilename) : m_RenderState(&m_Creatio
 
   m_LastCmdBufferID = ResourceId();
 
+  m_CreatingCheckpoints = false;
+  m_ResumeCheckpoint = NULL;
+  m_ReadingFrame = false;
+
+  m_ReplayWritesMarked = 0;
+
   m_DrawcallStack.push_back(&m_ParentDrawcall);
 
   m_SetDeviceLoaderData = NULL;
@@ -370,6 +382,8 @@ WrappedVulkan::~WrappedVulkan()
 
   SAFE_DELETE(m_pSerialiser);
 
+  ShutdownCoherentMapWorkers();
+
   for(size_t i = 0; i < m_MemIdxMaps.size(); i++)
     delete[] m_MemIdxMaps[i];
 
@@ -1138,6 +1152,9 @@ void WrappedVulkan::StartFrameCapture(void *dev, void *wnd)
     SCOPED_LOCK(m_CapTransitionLock);
     GetResourceManager()->PrepareInitialContents();
 
+    // wait for all the readback copies recorded while preparing
+    FinishInitStateBatch();
+
     RDCDEBUG("Attempting capture");
     m_FrameCaptureRecord->DeleteChunks();
 
@@ -1179,6 +1196,7 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
     if(swap == VK_NULL_HANDLE)
     {
       RDCERR("Output window %p provided for frame capture corresponds with no known swap chain", wnd);
+      AbandonFrameCapture();
       return false;
     }
   }
@@ -1236,15 +1254,7 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
 
     ObjDisp(GetDev())->DeviceWaitIdle(Unwrap(GetDev()));
 
-    {
-      SCOPED_LOCK(m_CoherentMapsLock);
-      for(auto it = m_CoherentMaps.begin(); it != m_CoherentMaps.end(); ++it)
-      {
-        Serialiser::FreeAlignedBuffer((*it)->memMapState->refData);
-        (*it)->memMapState->refData = NULL;
-        (*it)->memMapState->needRefData = false;
-      }
-    }
+    FreeCoherentMapRefData();
   }
 
   byte *thpixels = NULL;
@@ -1596,10 +1606,29 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
   RenderDoc::Inst().SuccessfullyWrittenLog(m_FrameCounter);
 
   SAFE_DELETE(m_pFileSerialiser);
-  SAFE_DELETE(m_HeaderChunk);
 
   m_State = WRITING_IDLE;
 
+  ReleaseFrameCaptureData();
+
+  return true;
+}
+
+void WrappedVulkan::FreeCoherentMapRefData()
+{
+  SCOPED_LOCK(m_CoherentMapsLock);
+  for(auto it = m_CoherentMaps.begin(); it != m_CoherentMaps.end(); ++it)
+  {
+    Serialiser::FreeAlignedBuffer((*it)->memMapState->refData);
+    (*it)->memMapState->refData = NULL;
+    (*it)->memMapState->needRefData = false;
+  }
+}
+
+void WrappedVulkan::ReleaseFrameCaptureData()
+{
+  SAFE_DELETE(m_HeaderChunk);
+
   // delete cmd buffers now - had to keep them alive until after serialiser flush.
   for(size_t i = 0; i < m_CmdBufferRecords.size(); i++)
     m_CmdBufferRecords[i]->Delete(GetResourceManager());
@@ -1612,9 +1641,28 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
 
   GetResourceManager()->FreeInitialContents();
 
+  FreeInitStateHeaps();
+
   GetResourceManager()->FlushPendingDirty();
+}
 
-  return true;
+void WrappedVulkan::AbandonFrameCapture()
+{
+  // transition back to IDLE atomically, as when the capture ends normally, then drop everything
+  // that was recorded without writing it out.
+  {
+    SCOPED_LOCK(m_CapTransitionLock);
+
+    m_State = WRITING_IDLE;
+
+    ObjDisp(GetDev())->DeviceWaitIdle(Unwrap(GetDev()));
+
+    FreeCoherentMapRefData();
+  }
+
+  m_FrameCaptureRecord->DeleteChunks();
+
+  ReleaseFrameCaptureData();
 }
 
 void WrappedVulkan::ReadLogInitialisation()
@@ -1626,6 +1674,8 @@ void WrappedVulkan::ReadLogInitialisation()
 
   m_pSerialiser->SetDebugText(true);
 
+  m_ChunkProfiler.Init(m_pSerialiser);
+
   m_pSerialiser->Rewind();
 
   while(!m_pSerialiser->AtEnd())
@@ -1668,6 +1718,8 @@ void WrappedVulkan::ReadLogInitialisation()
 
     uint64_t offset = m_pSerialiser->GetOffset();
 
+    m_ChunkProfiler.BeginChunk(m_pSerialiser);
+
     VulkanChunkType context = (VulkanChunkType)m_pSerialiser->PushContext(NULL, NULL, 1, false);
 
     if(context == CAPTURE_SCOPE)
@@ -1682,6 +1734,8 @@ void WrappedVulkan::ReadLogInitialisation()
 
     m_pSerialiser->PopContext(context);
 
+    m_ChunkProfiler.EndChunk(m_pSerialiser, context, true);
+
     RenderDoc::Inst().SetProgress(
         FileInitialRead, float(m_pSerialiser->GetOffset()) / float(m_pSerialiser->GetSize()));
 
@@ -1725,6 +1779,10 @@ void WrappedVulkan::ReadLogInitialisation()
   m_FrameRecord.frameInfo.persistentSize = m_pSerialiser->GetSize() - firstFrame;
   m_FrameRecord.frameInfo.initDataSize = chunkInfos[(VulkanChunkType)INITIAL_CONTENTS].totalsize;
 
+  LoadUsedImageContents();
+  PrepareCheckpoints();
+  PrepareReplayWrites();
+
   RDCDEBUG("Allocating %llu persistant bytes of memory for the log.",
            m_pSerialiser->GetSize() - firstFrame);
 
@@ -1740,10 +1798,13 @@ void WrappedVulkan::ContextReplayLog(LogState readType, uint32_t startEventID, u
 {
   m_State = readType;
 
+  m_ReadingFrame = (readType == READING);
+
   VulkanChunkType header = (VulkanChunkType)m_pSerialiser->PushContext(NULL, NULL, 1, false);
   RDCASSERTEQUAL(header, CONTEXT_CAPTURE_HEADER);
 
-  Serialise_BeginCaptureFrame(!partial);
+  // a checkpoint restores its own image layouts
+  Serialise_BeginCaptureFrame(!partial && m_ResumeCheckpoint == NULL);
 
   ObjDisp(GetDev())->DeviceWaitIdle(Unwrap(GetDev()));
 
@@ -1770,7 +1831,15 @@ void WrappedVulkan::ContextReplayLog(LogState readType, uint32_t startEventID, u
     // past the command buffer records, so can't
     // skip to the file offset of the first event
     if(partial)
+    {
       m_pSerialiser->SetOffset(ev.fileOffset);
+    }
+    else if(m_ResumeCheckpoint)
+    {
+      // carry on from just after the submit the checkpoint was taken at
+      m_RootEventID = m_ResumeCheckpoint->eventID + 1;
+      m_pSerialiser->SetOffset(m_ResumeCheckpoint->fileOffset);
+    }
 
     m_FirstEventID = startEventID;
     m_LastEventID = endEventID;
@@ -1800,12 +1869,32 @@ void WrappedVulkan::ContextReplayLog(LogState readType, uint32_t startEventID, u
 
     uint64_t offset = m_pSerialiser->GetOffset();
 
+    m_ChunkProfiler.BeginChunk(m_pSerialiser);
+
     VulkanChunkType context = (VulkanChunkType)m_pSerialiser->PushContext(NULL, NULL, 1, false);
 
     m_LastCmdBufferID = ResourceId();
 
     ContextProcessChunk(offset, context);
 
+    m_ChunkProfiler.EndChunk(m_pSerialiser, context, m_State == READING);
+
+    if(context == QUEUE_SUBMIT)
+    {
+      if(m_State == READING)
+      {
+        m_CheckpointCandidates.back().fileOffset = m_pSerialiser->GetOffset();
+      }
+      else if(m_CreatingCheckpoints && m_LastEventID >= m_RootEventID)
+      {
+        // the submit was replayed in full, take its checkpoint if it has one that's missing
+        ReplayCheckpoint *checkpoint = FindCheckpoint(m_RootEventID);
+
+        if(checkpoint && checkpoint->eventID == m_RootEventID && !checkpoint->created)
+          CreateCheckpoint(*checkpoint);
+      }
+    }
+
     RenderDoc::Inst().SetProgress(FileInitialRead, float(offset) / float(m_pSerialiser->GetSize()));
 
     // for now just abort after capture scope. Really we'd need to support multiple frames
@@ -1837,6 +1926,8 @@ void WrappedVulkan::ContextReplayLog(LogState readType, uint32_t startEventID, u
     }
   }
 
+  m_ReadingFrame = false;
+
   if(m_State == READING)
   {
     GetFrameRecord().drawcallList = m_ParentDrawcall.Bake();
@@ -1916,6 +2007,9 @@ void WrappedVulkan::ApplyInitialContents()
   // actually apply the initial contents here
   GetResourceManager()->ApplyInitialContents();
 
+  // nothing written since has been marked yet
+  m_ReplayWritesMarked = 0;
+
   // likewise again to make sure the initial states are all applied
   cmd = GetNextCmd();
 
@@ -1932,6 +2026,131 @@ void WrappedVulkan::ApplyInitialContents()
 #endif
 }
 
+// barriers count as writes, since a transition from UNDEFINED can discard contents
+static bool IsReplayWriteUsage(ResourceUsage usage)
+{
+  return (usage >= ResourceUsage::VS_RWResource && usage <= ResourceUsage::All_RWResource) ||
+         usage == ResourceUsage::StreamOut || usage == ResourceUsage::ColorTarget ||
+         usage == ResourceUsage::DepthStencilTarget || usage == ResourceUsage::Clear ||
+         usage == ResourceUsage::GenMips || usage == ResourceUsage::Resolve ||
+         usage == ResourceUsage::ResolveDst || usage == ResourceUsage::Copy ||
+         usage == ResourceUsage::CopyDst || usage == ResourceUsage::Barrier;
+}
+
+static void AddReplayWrite(map<ResourceId, uint32_t> &firstWrite, ResourceId id, uint32_t eventID)
+{
+  auto it = firstWrite.find(id);
+
+  if(it == firstWrite.end())
+    firstWrite[id] = eventID;
+  else
+    it->second = RDCMIN(it->second, eventID);
+}
+
+void WrappedVulkan::PrepareReplayWrites()
+{
+  vector<ResourceId> ids;
+  GetResourceManager()->GetInitialContentsIDs(ids);
+
+  map<ResourceId, uint32_t> firstWrite;
+
+  for(size_t i = 0; i < ids.size(); i++)
+  {
+    if(!GetResourceManager()->HasLiveResource(ids[i]))
+      continue;
+
+    WrappedVkRes *res = GetResourceManager()->GetLiveResource(ids[i]);
+    ResourceId liveid = GetResourceManager()->GetLiveID(ids[i]);
+    VkResourceType type = IdentifyTypeByPtr(res);
+
+    // sparse resources share memory through page tables we don't follow, so restore everything
+    if((type == eResBuffer || type == eResImage) &&
+       GetResourceManager()->GetInitialContents(ids[i]).num == eInitialContents_Sparse)
+    {
+      RDCLOG("Capture contains sparse resources, always applying all initial contents");
+      return;
+    }
+
+    // descriptor sets are cheap to restore and can be updated anywhere in the frame
+    if(type == eResDescriptorSet)
+      AddReplayWrite(firstWrite, liveid, 0);
+  }
+
+  // attachments can be written by render pass load and store ops without any usage
+  for(auto it = m_CreationInfo.m_Framebuffer.begin(); it != m_CreationInfo.m_Framebuffer.end();
+      ++it)
+  {
+    for(size_t a = 0; a < it->second.attachments.size(); a++)
+      AddReplayWrite(firstWrite, m_CreationInfo.m_ImageView[it->second.attachments[a].view].image,
+                     0);
+  }
+
+  for(auto it = m_ResourceUses.begin(); it != m_ResourceUses.end(); ++it)
+  {
+    for(size_t u = 0; u < it->second.size(); u++)
+    {
+      if(!IsReplayWriteUsage(it->second[u].usage))
+        continue;
+
+      uint32_t eid = it->second[u].eventID;
+
+      AddReplayWrite(firstWrite, it->first, eid);
+
+      // buffer contents are restored through their memory
+      auto buf = m_CreationInfo.m_Buffer.find(it->first);
+      if(buf != m_CreationInfo.m_Buffer.end() && buf->second.memory != ResourceId())
+        AddReplayWrite(firstWrite, buf->second.memory, eid);
+    }
+  }
+
+  for(auto it = m_FrameBufferWrites.begin(); it != m_FrameBufferWrites.end(); ++it)
+  {
+    AddReplayWrite(firstWrite, *it, 0);
+
+    auto buf = m_CreationInfo.m_Buffer.find(*it);
+    if(buf != m_CreationInfo.m_Buffer.end() && buf->second.memory != ResourceId())
+      AddReplayWrite(firstWrite, buf->second.memory, 0);
+  }
+
+  for(auto it = m_FrameHostWrites.begin(); it != m_FrameHostWrites.end(); ++it)
+    AddReplayWrite(firstWrite, it->first, 0);
+
+  // restoring memory can overwrite the images bound to it, so they're restored along with it
+  for(auto it = m_CreationInfo.m_Image.begin(); it != m_CreationInfo.m_Image.end(); ++it)
+  {
+    auto mem = firstWrite.find(it->second.memory);
+    if(it->second.memory != ResourceId() && mem != firstWrite.end())
+      AddReplayWrite(firstWrite, it->first, mem->second);
+  }
+
+  m_ReplayWrites.clear();
+  m_ReplayWrites.reserve(firstWrite.size());
+
+  for(auto it = firstWrite.begin(); it != firstWrite.end(); ++it)
+    m_ReplayWrites.push_back(std::make_pair(it->second, it->first));
+
+  std::sort(m_ReplayWrites.begin(), m_ReplayWrites.end());
+
+  RDCDEBUG("%u of %u resources with initial contents can be written by replay",
+           (uint32_t)m_ReplayWrites.size(), (uint32_t)ids.size());
+
+  // the initial read replayed the whole frame, so everything that can be written has been
+  GetResourceManager()->SetReplayWriteTracking(true);
+  m_ReplayWritesMarked = 0;
+  MarkReplayWrites(~0U);
+}
+
+void WrappedVulkan::MarkReplayWrites(uint32_t eventID)
+{
+  for(; m_ReplayWritesMarked < m_ReplayWrites.size(); m_ReplayWritesMarked++)
+  {
+    if(m_ReplayWrites[m_ReplayWritesMarked].first > eventID)
+      break;
+
+    GetResourceManager()->MarkReplayWritten(m_ReplayWrites[m_ReplayWritesMarked].second);
+  }
+}
+
 void WrappedVulkan::ContextProcessChunk(uint64_t offset, VulkanChunkType chunk)
 {
   m_CurChunkOffset = offset;
@@ -2346,10 +2565,30 @@ void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
 
   if(!partial)
   {
-    ApplyInitialContents();
+    // checkpoints hold the state of a plain replay, so don't use or take them while a callback
+    // might be re-recording command buffers
+    ReplayCheckpoint *checkpoint = NULL;
 
-    SubmitCmds();
-    FlushQ();
+    if(m_DrawcallCallback == NULL && !m_Checkpoints.empty())
+    {
+      m_CreatingCheckpoints = true;
+
+      checkpoint = FindCheckpoint(replayType == eReplay_Full ? endEventID
+                                                             : RDCMAX(1U, endEventID) - 1);
+    }
+
+    if(checkpoint && checkpoint->created)
+    {
+      RestoreCheckpoint(*checkpoint);
+      m_ResumeCheckpoint = checkpoint;
+    }
+    else
+    {
+      ApplyInitialContents();
+
+      SubmitCmds();
+      FlushQ();
+    }
 
     GetResourceManager()->ReleaseInFrameResources();
   }
@@ -2439,6 +2678,11 @@ void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
     else
       RDCFATAL("Unexpected replay type");
 
+    m_CreatingCheckpoints = false;
+    m_ResumeCheckpoint = NULL;
+
+    MarkReplayWrites(endEventID);
+
     if(m_Partial[Primary].outsideCmdBuffer != VK_NULL_HANDLE)
     {
       VkCommandBuffer cmd = m_Partial[Primary].outsideCmdBuffer;
@@ -37,6 +37,9 @@
 using std::vector;
 using std::list;
 
+struct CoherentMapDiff;
+class CoherentMapDiffWorkers;
+
 struct VkInitParams : public RDCInitParams
 {
   VkInitParams();
@@ -44,10 +47,10 @@ struct VkInitParams : public RDCInitParams
 
   void Set(const VkInstanceCreateInfo *pCreateInfo, ResourceId inst);
 
-  static const uint32_t VK_SERIALISE_VERSION = 0x0000006;
+  static const uint32_t VK_SERIALISE_VERSION = 0x0000008;
 
   // backwards compatibility for old logs described at the declaration of this array
-  static const uint32_t VK_NUM_SUPPORTED_OLD_VERSIONS = 1;
+  static const uint32_t VK_NUM_SUPPORTED_OLD_VERSIONS = 3;
   static const uint32_t VK_OLD_VERSIONS[VK_NUM_SUPPORTED_OLD_VERSIONS];
 
   // version number internal to vulkan stream
@@ -210,6 +213,11 @@ private:
   void Serialise_DebugMessages(Serialiser *localSerialiser, bool isDrawcall);
   vector<DebugMessage> GetDebugMessages();
   void AddDebugMessage(DebugMessage msg);
+
+  // per chunk-type load and replay statistics
+  ChunkProfiler m_ChunkProfiler;
+  vector<ChunkProfile> GetChunkProfile() { return m_ChunkProfiler.GetProfile(&GetChunkName); }
+
   void AddDebugMessage(MessageCategory c, MessageSeverity sv, MessageSource src, std::string d);
 
   enum
@@ -259,6 +267,13 @@ private:
 
   Threading::CriticalSection m_CapTransitionLock;
 
+  // threads that split up comparing coherent maps against their reference data on submit. Created
+  // on first use and kept until the device is destroyed.
+  Threading::CriticalSection m_CoherentMapWorkersLock;
+  CoherentMapDiffWorkers *m_CoherentMapWorkers;
+  void DiffCoherentMaps(vector<CoherentMapDiff> &diffs);
+  void ShutdownCoherentMapWorkers();
+
   VulkanDrawcallCallback *m_DrawcallCallback;
 
   // util function to handle fetching the right eventID, calling any
@@ -378,6 +393,31 @@ private:
   vector<VkDeviceMemory> m_CleanupMems;
   vector<VkEvent> m_CleanupEvents;
 
+  // initial states prepared at the start of a capture are read back into suballocations of a
+  // few large persistently mapped heaps. All the copies are recorded into shared command
+  // buffers which are submitted as each heap fills, with one wait after everything is prepared.
+  struct InitStateHeap
+  {
+    VkDeviceMemory mem;
+    VkBuffer buf;
+    VkDeviceSize size;
+    VkDeviceSize used;
+    byte *data;
+  };
+
+  struct
+  {
+    vector<InitStateHeap> heaps;
+
+    // the batch command buffer currently being recorded, if any
+    VkCommandBuffer cmd;
+
+    // temporary objects that must live until the batch has finished executing
+    vector<VkBuffer> bufdeletes;
+    vector<VkImage> imgdeletes;
+    vector<VkDeviceMemory> memdeletes;
+  } m_InitStateBatch;
+
   const VkPhysicalDeviceProperties &GetDeviceProps() { return m_PhysicalDeviceData.props; }
   VkDriverInfo GetDriverVersion() { return VkDriverInfo(m_PhysicalDeviceData.props); }
   const VkFormatProperties &GetFormatProperties(VkFormat f)
@@ -397,7 +437,8 @@ private:
           curEventID(0),
           drawCount(0),
           level(VK_COMMAND_BUFFER_LEVEL_PRIMARY),
-          beginFlags(0)
+          beginFlags(0),
+          beginOffset(0)
     {
     }
     ~BakedCmdBufferInfo() { SAFE_DELETE(draw); }
@@ -408,6 +449,9 @@ private:
     VkCommandBufferLevel level;
     VkCommandBufferUsageFlags beginFlags;
 
+    // file offset of the vkBeginCommandBuffer chunk that started recording this command buffer
+    uint64_t beginOffset;
+
     vector<pair<ResourceId, EventUsage> > resourceUsage;
 
     struct CmdBufferState
@@ -545,6 +589,91 @@ private:
   bool InRerecordRange(ResourceId cmdid);
   VkCommandBuffer RerecordCmdBuf(ResourceId cmdid, PartialReplayIndex partialType = ePartialNum);
 
+  // checkpoints are snapshots of the frame's state just after a queue submit, taken the first
+  // time a replay passes that submit. A later replay that ends past a checkpoint can restore it
+  // and carry on from there instead of applying initial contents and starting from the beginning.
+  // They're only enabled with a non-zero replay.checkpointBudgetMB config setting.
+  struct CheckpointCandidate
+  {
+    uint32_t eventID;        // the last event in the submit
+    uint64_t fileOffset;     // offset of the chunk after the submit
+    uint64_t recordStart;    // earliest vkBeginCommandBuffer of any command buffer submitted
+  };
+
+  struct ReplayCheckpoint
+  {
+    ReplayCheckpoint() : eventID(0), fileOffset(0), created(false) {}
+    uint32_t eventID;
+    uint64_t fileOffset;
+    bool created;
+
+    // copies of written images by live ID, kept in TRANSFER_SRC_OPTIMAL
+    map<ResourceId, VkImage> images;
+
+    // memory and descriptor set contents by live ID, in the same form as their initial contents
+    map<ResourceId, VulkanResourceManager::InitialContentData> contents;
+
+    map<ResourceId, ImageLayouts> imageLayouts;
+
+    vector<VkDeviceMemory> mems;
+  };
+
+  vector<CheckpointCandidate> m_CheckpointCandidates;
+  vector<ReplayCheckpoint> m_Checkpoints;
+
+  // the resources snapshotted at each checkpoint, by live ID. For memory, the packed regions to
+  // save with srcOffset in the snapshot and dstOffset in the memory, and the total size
+  vector<ResourceId> m_CheckpointImages;
+  vector<ResourceId> m_CheckpointDescSets;
+  map<ResourceId, pair<vector<VkBufferCopy>, VkDeviceSize> > m_CheckpointMemRegions;
+
+  // ranges of memory written from the host during the frame, by live ID. Only gathered while
+  // the frame itself is being read, host writes before it are part of the initial contents
+  map<ResourceId, vector<pair<VkDeviceSize, VkDeviceSize> > > m_FrameHostWrites;
+  bool m_ReadingFrame;
+
+  // set while a replay that can create checkpoints is running, and to the checkpoint a replay
+  // is resuming from
+  bool m_CreatingCheckpoints;
+  ReplayCheckpoint *m_ResumeCheckpoint;
+
+  void AddCheckpointCandidate(const vector<ResourceId> &cmdIds);
+  void PrepareCheckpoints();
+  ReplayCheckpoint *FindCheckpoint(uint32_t eventID);
+  void CreateCheckpoint(ReplayCheckpoint &checkpoint);
+  void RestoreCheckpoint(ReplayCheckpoint &checkpoint);
+  void FreeCheckpoint(ReplayCheckpoint &checkpoint);
+  void FreeCheckpoints();
+
+  // live IDs of buffers written by commands that don't record a resource usage, like
+  // vkCmdFillBuffer and vkCmdCopyQueryPoolResults
+  std::set<ResourceId> m_FrameBufferWrites;
+
+  // every resource with initial contents that replaying the frame can write, by live ID, with the
+  // first event that can write it and sorted by that event. The first m_ReplayWritesMarked have
+  // been marked in the resource manager since initial contents were last applied
+  vector<pair<uint32_t, ResourceId> > m_ReplayWrites;
+  size_t m_ReplayWritesMarked;
+
+  void PrepareReplayWrites();
+  void MarkReplayWrites(uint32_t eventID);
+
+  // data for the initial contents of single-sampled images by original ID, kept on the CPU until
+  // the image is inspected. After loading only images that nothing in the frame can modify, either
+  // directly or through their memory, are left here, so their contents are the same at any event.
+  // The data is freed as soon as it's uploaded. Only the upload is deferred - the images
+  // themselves are still created and bound while loading, and the data of images that are never
+  // inspected stays on the CPU until shutdown.
+  map<ResourceId, pair<byte *, uint32_t> > m_DeferredImageContents;
+
+  void LoadDeferredImageContents(ResourceId liveid);
+  void LoadUsedImageContents();
+
+  // returns the live handle for an image replay is about to read back or display. Every such read
+  // goes through here so that deferred initial contents are applied first. This can submit
+  // internal command buffers, so it must be called before GetNextCmd().
+  VkImage GetInspectedImage(ResourceId liveid);
+
   // this info is stored in the record on capture, but we
   // need it on replay too
   struct DescriptorSetInfo
@@ -568,10 +697,21 @@ private:
   Threading::CriticalSection m_CoherentMapsLock;
 
   // used both on capture and replay side to track image layouts. Only locked
-  // in capture
+  // in capture, and then only when images are created/destroyed or when command
+  // buffers' recorded barriers are applied at submit - recording barriers into a
+  // command buffer doesn't touch it.
   map<ResourceId, ImageLayouts> m_ImageLayouts;
   Threading::CriticalSection m_ImageLayoutsLock;
 
+  // protects the memory bindings in each memory record's MemMapState
+  Threading::CriticalSection m_MemBindingsLock;
+
+  void AddMemoryBinding(VkResourceRecord *record, ResourceId mem, VkDeviceSize offset,
+                        VkDeviceSize size);
+  void AddMemoryBinding(VkResourceRecord *viewRecord, VkResourceRecord *bufferRecord);
+  void RemoveMemoryBinding(VkResourceRecord *record);
+  void MarkSparseBound(VkDeviceMemory mem);
+
   // find swapchain for an image
   map<RENDERDOC_WindowHandle, VkSwapchainKHR> m_SwapLookup;
   Threading::CriticalSection m_SwapLookupLock;
@@ -619,6 +759,18 @@ private:
 
   // replay
 
+  VkCommandBuffer GetInitStateCmd();
+  void CloseInitStateCmd();
+  VkDeviceSize AllocInitStateReadback(VkDeviceSize size, uint32_t &heapIdx);
+  void FinishInitStateBatch();
+  void FreeInitStateHeaps();
+
+  // releases everything held for the frame capture once it's written or abandoned, including the
+  // initial contents and their readback heaps
+  void FreeCoherentMapRefData();
+  void ReleaseFrameCaptureData();
+  void AbandonFrameCapture();
+
   bool Prepare_SparseInitialState(WrappedVkBuffer *buf);
   bool Prepare_SparseInitialState(WrappedVkImage *im);
   bool Serialise_SparseBufferInitialState(ResourceId id,
@@ -630,6 +782,10 @@ private:
   bool Apply_SparseInitialState(WrappedVkImage *im,
                                 VulkanResourceManager::InitialContentData contents);
 
+  byte *MakeDescriptorSetWrites(VkDescriptorSet set, const DescSetLayout &layout,
+                                const DescriptorSetSlot *bindings, uint32_t numElems,
+                                uint32_t &validBinds);
+
   void ApplyInitialContents();
 
   vector<APIEvent> m_RootEvents, m_Events;
@@ -36,6 +36,18 @@ void VulkanReplay::PostDeviceInitCounters()
 
 void VulkanReplay::PreDeviceShutdownCounters()
 {
+  VkDevice dev = m_pDriver->GetDev();
+
+  if(m_CounterQueries.timeStamp != VK_NULL_HANDLE)
+    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), m_CounterQueries.timeStamp, NULL);
+  if(m_CounterQueries.occlusion != VK_NULL_HANDLE)
+    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), m_CounterQueries.occlusion, NULL);
+  if(m_CounterQueries.pipeStats != VK_NULL_HANDLE)
+    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), m_CounterQueries.pipeStats, NULL);
+  if(m_CounterQueries.isolated != VK_NULL_HANDLE)
+    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), m_CounterQueries.isolated, NULL);
+
+  RDCEraseEl(m_CounterQueries);
 }
 
 void VulkanReplay::PostDeviceShutdownCounters()
@@ -185,12 +197,13 @@ void VulkanReplay::DescribeCounter(GPUCounter counterID, CounterDescription &des
 struct VulkanGPUTimerCallback : public VulkanDrawcallCallback
 {
   VulkanGPUTimerCallback(WrappedVulkan *vk, VulkanReplay *rp, VkQueryPool tsqp, VkQueryPool occqp,
-                         VkQueryPool psqp)
+                         VkQueryPool psqp, bool recordAll)
       : m_pDriver(vk),
         m_pReplay(rp),
         m_TimeStampQueryPool(tsqp),
         m_OcclusionQueryPool(occqp),
-        m_PipeStatsQueryPool(psqp)
+        m_PipeStatsQueryPool(psqp),
+        m_RecordAll(recordAll)
   {
     m_pDriver->SetDrawcallCB(this);
   }
@@ -202,14 +215,16 @@ struct VulkanGPUTimerCallback : public VulkanDrawcallCallback
                                   VK_QUERY_CONTROL_PRECISE_BIT);
     if(m_PipeStatsQueryPool != VK_NULL_HANDLE)
       ObjDisp(cmd)->CmdBeginQuery(Unwrap(cmd), m_PipeStatsQueryPool, (uint32_t)m_Results.size(), 0);
-    ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                    m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 0));
+    if(m_TimeStampQueryPool != VK_NULL_HANDLE)
+      ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                      m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 0));
   }
 
   bool PostDraw(uint32_t eid, VkCommandBuffer cmd)
   {
-    ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                                    m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 1));
+    if(m_TimeStampQueryPool != VK_NULL_HANDLE)
+      ObjDisp(cmd)->CmdWriteTimestamp(Unwrap(cmd), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                      m_TimeStampQueryPool, (uint32_t)(m_Results.size() * 2 + 1));
     if(m_OcclusionQueryPool != VK_NULL_HANDLE)
       ObjDisp(cmd)->CmdEndQuery(Unwrap(cmd), m_OcclusionQueryPool, (uint32_t)m_Results.size());
     if(m_PipeStatsQueryPool != VK_NULL_HANDLE)
@@ -226,7 +241,7 @@ struct VulkanGPUTimerCallback : public VulkanDrawcallCallback
   void PreMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) { PreDraw(eid, cmd); }
   bool PostMisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) { return PostDraw(eid, cmd); }
   void PostRemisc(uint32_t eid, DrawFlags flags, VkCommandBuffer cmd) { PostRedraw(eid, cmd); }
-  bool RecordAllCmds() { return true; }
+  bool RecordAllCmds() { return m_RecordAll; }
   void AliasEvent(uint32_t primary, uint32_t alias)
   {
     m_AliasEvents.push_back(std::make_pair(primary, alias));
@@ -237,6 +252,9 @@ struct VulkanGPUTimerCallback : public VulkanDrawcallCallback
   VkQueryPool m_TimeStampQueryPool;
   VkQueryPool m_OcclusionQueryPool;
   VkQueryPool m_PipeStatsQueryPool;
+  // when replaying a single isolated event it's recorded into the partial command buffer, so
+  // there's no need to re-record every command buffer
+  bool m_RecordAll;
   vector<uint32_t> m_Results;
   // events which are the 'same' from being the same command buffer resubmitted
   // multiple times in the frame. We will only get the full callback when we're
@@ -245,6 +263,48 @@ struct VulkanGPUTimerCallback : public VulkanDrawcallCallback
   vector<pair<uint32_t, uint32_t> > m_AliasEvents;
 };
 
+static VkQueryPipelineStatisticFlags PipeStatsFlag(GPUCounter counter)
+{
+  switch(counter)
+  {
+    case GPUCounter::InputVerticesRead:
+      return VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT;
+    case GPUCounter::IAPrimitives: return VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT;
+    case GPUCounter::VSInvocations:
+      return VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT;
+    case GPUCounter::GSInvocations:
+      return VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_INVOCATIONS_BIT;
+    case GPUCounter::GSPrimitives:
+      return VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_PRIMITIVES_BIT;
+    case GPUCounter::RasterizerInvocations:
+      return VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT;
+    case GPUCounter::RasterizedPrimitives:
+      return VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT;
+    case GPUCounter::PSInvocations:
+      return VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+    case GPUCounter::TCSInvocations:
+      return VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT;
+    case GPUCounter::TESInvocations:
+      return VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT;
+    case GPUCounter::CSInvocations:
+      return VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+    default: break;
+  }
+
+  return 0;
+}
+
+// pipeline statistics results are packed in bit order, containing only the enabled statistics
+static uint32_t PipeStatsIndex(VkQueryPipelineStatisticFlags flags,
+                               VkQueryPipelineStatisticFlags stat)
+{
+  uint32_t ret = 0;
+  for(VkQueryPipelineStatisticFlags bit = 1; bit < stat; bit <<= 1)
+    if(flags & bit)
+      ret++;
+  return ret;
+}
+
 vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &counters)
 {
   uint32_t maxEID = m_pDriver->GetMaxEID();
@@ -253,48 +313,77 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
 
   VkDevice dev = m_pDriver->GetDev();
 
-  VkQueryPoolCreateInfo timeStampPoolCreateInfo = {
-      VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL, 0, VK_QUERY_TYPE_TIMESTAMP, maxEID * 2, 0};
-
-  VkQueryPoolCreateInfo occlusionPoolCreateInfo = {
-      VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL, 0, VK_QUERY_TYPE_OCCLUSION, maxEID, 0};
-
-  VkQueryPipelineStatisticFlags pipeStatsFlags =
-      VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_INVOCATIONS_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_PRIMITIVES_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT |
-      VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
-
-  VkQueryPoolCreateInfo pipeStatsPoolCreateInfo = {
-      VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL,   0,
-      VK_QUERY_TYPE_PIPELINE_STATISTICS,        maxEID, pipeStatsFlags};
-
-  VkQueryPool timeStampPool;
-  VkResult vkr =
-      ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &timeStampPoolCreateInfo, NULL, &timeStampPool);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  // only enable the queries that the requested counters need, so all of them are gathered in one
+  // replay without timing extra work on every draw
+  bool timeStamps = false, occlusion = false;
+  VkQueryPipelineStatisticFlags pipeStatsFlags = 0;
 
-  VkQueryPool occlusionPool = VK_NULL_HANDLE;
-  if(availableFeatures.occlusionQueryPrecise)
+  for(size_t c = 0; c < counters.size(); c++)
   {
-    vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &occlusionPoolCreateInfo, NULL, &occlusionPool);
+    if(counters[c] == GPUCounter::EventGPUDuration)
+      timeStamps = true;
+    else if(counters[c] == GPUCounter::SamplesWritten)
+      occlusion = availableFeatures.occlusionQueryPrecise != VK_FALSE;
+    else if(availableFeatures.pipelineStatisticsQuery)
+      pipeStatsFlags |= PipeStatsFlag(counters[c]);
+  }
+
+  uint32_t numPipeStats = PipeStatsIndex(pipeStatsFlags, 0x80000000U);
+
+  if(m_CounterQueries.size < maxEID)
+  {
+    PreDeviceShutdownCounters();
+    m_CounterQueries.size = maxEID;
+  }
+
+  if(m_CounterQueries.pipeStats != VK_NULL_HANDLE &&
+     m_CounterQueries.pipeStatsFlags != pipeStatsFlags)
+  {
+    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), m_CounterQueries.pipeStats, NULL);
+    m_CounterQueries.pipeStats = VK_NULL_HANDLE;
+  }
+
+  VkResult vkr = VK_SUCCESS;
+
+  if(timeStamps && m_CounterQueries.timeStamp == VK_NULL_HANDLE)
+  {
+    VkQueryPoolCreateInfo timeStampPoolCreateInfo = {
+        VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL, 0, VK_QUERY_TYPE_TIMESTAMP,
+        m_CounterQueries.size * 2, 0};
+
+    vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &timeStampPoolCreateInfo, NULL,
+                                        &m_CounterQueries.timeStamp);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
 
-  VkQueryPool pipeStatsPool = VK_NULL_HANDLE;
-  if(availableFeatures.pipelineStatisticsQuery)
+  if(occlusion && m_CounterQueries.occlusion == VK_NULL_HANDLE)
   {
-    vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &pipeStatsPoolCreateInfo, NULL, &pipeStatsPool);
+    VkQueryPoolCreateInfo occlusionPoolCreateInfo = {
+        VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL, 0, VK_QUERY_TYPE_OCCLUSION,
+        m_CounterQueries.size, 0};
+
+    vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &occlusionPoolCreateInfo, NULL,
+                                        &m_CounterQueries.occlusion);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
   }
 
+  if(pipeStatsFlags && m_CounterQueries.pipeStats == VK_NULL_HANDLE)
+  {
+    VkQueryPoolCreateInfo pipeStatsPoolCreateInfo = {
+        VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL, 0, VK_QUERY_TYPE_PIPELINE_STATISTICS,
+        m_CounterQueries.size, pipeStatsFlags};
+
+    vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &pipeStatsPoolCreateInfo, NULL,
+                                        &m_CounterQueries.pipeStats);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    m_CounterQueries.pipeStatsFlags = pipeStatsFlags;
+  }
+
+  VkQueryPool timeStampPool = timeStamps ? m_CounterQueries.timeStamp : VK_NULL_HANDLE;
+  VkQueryPool occlusionPool = occlusion ? m_CounterQueries.occlusion : VK_NULL_HANDLE;
+  VkQueryPool pipeStatsPool = pipeStatsFlags ? m_CounterQueries.pipeStats : VK_NULL_HANDLE;
+
   VkCommandBuffer cmd = m_pDriver->GetNextCmd();
 
   VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
@@ -303,7 +392,8 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
   vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), timeStampPool, 0, maxEID * 2);
+  if(timeStampPool != VK_NULL_HANDLE)
+    ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), timeStampPool, 0, maxEID * 2);
   if(occlusionPool != VK_NULL_HANDLE)
     ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), occlusionPool, 0, maxEID);
   if(pipeStatsPool != VK_NULL_HANDLE)
@@ -316,46 +406,42 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
   m_pDriver->SubmitCmds();
 #endif
 
-  VulkanGPUTimerCallback cb(m_pDriver, this, timeStampPool, occlusionPool, pipeStatsPool);
+  VulkanGPUTimerCallback cb(m_pDriver, this, timeStampPool, occlusionPool, pipeStatsPool, true);
 
   // replay the events to perform all the queries
   m_pDriver->ReplayLog(0, maxEID, eReplay_Full);
 
   vector<uint64_t> m_TimeStampData;
   m_TimeStampData.resize(cb.m_Results.size() * 2);
-
-  vkr = ObjDisp(dev)->GetQueryPoolResults(
-      Unwrap(dev), timeStampPool, 0, (uint32_t)m_TimeStampData.size(),
-      sizeof(uint64_t) * m_TimeStampData.size(), &m_TimeStampData[0], sizeof(uint64_t),
-      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), timeStampPool, NULL);
+  if(timeStampPool != VK_NULL_HANDLE && !cb.m_Results.empty())
+  {
+    vkr = ObjDisp(dev)->GetQueryPoolResults(
+        Unwrap(dev), timeStampPool, 0, (uint32_t)m_TimeStampData.size(),
+        sizeof(uint64_t) * m_TimeStampData.size(), &m_TimeStampData[0], sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
 
   vector<uint64_t> m_OcclusionData;
   m_OcclusionData.resize(cb.m_Results.size());
-  if(occlusionPool != VK_NULL_HANDLE)
+  if(occlusionPool != VK_NULL_HANDLE && !cb.m_Results.empty())
   {
     vkr = ObjDisp(dev)->GetQueryPoolResults(
         Unwrap(dev), occlusionPool, 0, (uint32_t)m_OcclusionData.size(),
         sizeof(uint64_t) * m_OcclusionData.size(), &m_OcclusionData[0], sizeof(uint64_t),
         VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), occlusionPool, NULL);
   }
 
   vector<uint64_t> m_PipeStatsData;
-  m_PipeStatsData.resize(cb.m_Results.size() * 11);
-  if(pipeStatsPool != VK_NULL_HANDLE)
+  m_PipeStatsData.resize(cb.m_Results.size() * numPipeStats);
+  if(pipeStatsPool != VK_NULL_HANDLE && !cb.m_Results.empty())
   {
     vkr = ObjDisp(dev)->GetQueryPoolResults(
         Unwrap(dev), pipeStatsPool, 0, (uint32_t)cb.m_Results.size(),
-        sizeof(uint64_t) * m_PipeStatsData.size(), &m_PipeStatsData[0], sizeof(uint64_t) * 11,
-        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+        sizeof(uint64_t) * m_PipeStatsData.size(), &m_PipeStatsData[0],
+        sizeof(uint64_t) * numPipeStats, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    ObjDisp(dev)->DestroyQueryPool(Unwrap(dev), pipeStatsPool, NULL);
   }
 
   vector<CounterResult> ret;
@@ -379,28 +465,25 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
                            / (1000.0 * 1000.0 * 1000.0);    // to seconds
         }
         break;
-        case GPUCounter::InputVerticesRead: result.value.u64 = m_PipeStatsData[i * 11 + 0]; break;
-        case GPUCounter::IAPrimitives: result.value.u64 = m_PipeStatsData[i * 11 + 1]; break;
-        case GPUCounter::GSPrimitives: result.value.u64 = m_PipeStatsData[i * 11 + 4]; break;
-        case GPUCounter::RasterizerInvocations:
-          result.value.u64 = m_PipeStatsData[i * 11 + 5];
-          break;
-        case GPUCounter::RasterizedPrimitives:
-          result.value.u64 = m_PipeStatsData[i * 11 + 6];
-          break;
         case GPUCounter::SamplesWritten: result.value.u64 = m_OcclusionData[i]; break;
-        case GPUCounter::VSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 2]; break;
-        case GPUCounter::TCSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 8]; break;
-        case GPUCounter::TESInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 9]; break;
-        case GPUCounter::GSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 3]; break;
-        case GPUCounter::PSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 9]; break;
-        case GPUCounter::CSInvocations: result.value.u64 = m_PipeStatsData[i * 11 + 10]; break;
-        default: break;
+        default:
+        {
+          VkQueryPipelineStatisticFlags stat = PipeStatsFlag(counters[c]);
+          if(pipeStatsFlags & stat)
+            result.value.u64 =
+                m_PipeStatsData[i * numPipeStats + PipeStatsIndex(pipeStatsFlags, stat)];
+          break;
+        }
       }
       ret.push_back(result);
     }
   }
 
+  // sort the directly fetched results so aliases can binary search for the result they copy
+  std::sort(ret.begin(), ret.end());
+
+  size_t numResults = ret.size();
+
   for(size_t i = 0; i < cb.m_AliasEvents.size(); i++)
   {
     for(size_t c = 0; c < counters.size(); c++)
@@ -410,8 +493,8 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
       search.eventID = cb.m_AliasEvents[i].first;
 
       // find the result we're aliasing
-      auto it = std::find(ret.begin(), ret.end(), search);
-      RDCASSERT(it != ret.end());
+      auto it = std::lower_bound(ret.begin(), ret.begin() + numResults, search);
+      RDCASSERT(it != ret.begin() + numResults && *it == search);
 
       // duplicate the result and append
       CounterResult aliased = *it;
@@ -425,3 +508,63 @@ vector<CounterResult> VulkanReplay::FetchCounters(const vector<GPUCounter> &coun
 
   return ret;
 }
+
+double VulkanReplay::GetIsolatedDuration(uint32_t eventID)
+{
+  VkDevice dev = m_pDriver->GetDev();
+
+  VkResult vkr = VK_SUCCESS;
+
+  if(m_CounterQueries.isolated == VK_NULL_HANDLE)
+  {
+    VkQueryPoolCreateInfo timeStampPoolCreateInfo = {
+        VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, NULL, 0, VK_QUERY_TYPE_TIMESTAMP, 2, 0};
+
+    vkr = ObjDisp(dev)->CreateQueryPool(Unwrap(dev), &timeStampPoolCreateInfo, NULL,
+                                        &m_CounterQueries.isolated);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
+
+  VkCommandBuffer cmd = m_pDriver->GetNextCmd();
+
+  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+  vkr = ObjDisp(dev)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  ObjDisp(dev)->CmdResetQueryPool(Unwrap(cmd), m_CounterQueries.isolated, 0, 2);
+
+  vkr = ObjDisp(dev)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  // bring the state up to just before the event, then replay only the event itself with the
+  // timestamps around it.
+  m_pDriver->ReplayLog(0, eventID, eReplay_WithoutDraw);
+
+  vector<uint32_t> results;
+
+  {
+    VulkanGPUTimerCallback cb(m_pDriver, this, m_CounterQueries.isolated, VK_NULL_HANDLE,
+                              VK_NULL_HANDLE, false);
+
+    m_pDriver->ReplayLog(0, eventID, eReplay_OnlyDraw);
+
+    results.swap(cb.m_Results);
+  }
+
+  // the event wasn't a drawcall, dispatch or other timed command
+  if(results.empty())
+    return -1.0;
+
+  uint64_t timestamps[2] = {};
+
+  vkr = ObjDisp(dev)->GetQueryPoolResults(Unwrap(dev), m_CounterQueries.isolated, 0, 2,
+                                          sizeof(timestamps), timestamps, sizeof(uint64_t),
+                                          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  return (double(m_pDriver->GetDeviceProps().limits.timestampPeriod) *
+          double(timestamps[1] - timestamps[0]))    // nanoseconds
+         / (1000.0 * 1000.0 * 1000.0);              // to seconds
+}
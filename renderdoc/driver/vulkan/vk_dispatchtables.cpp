@@ -160,11 +160,131 @@ void InitDeviceExtensionTables(VkDevice device)
 
 #undef DeviceGPA
 
-static Threading::CriticalSection devlock;
-std::map<void *, VkLayerDispatchTableExtended> devlookup;
+// There are only ever a handful of instances and devices, so the tables are stored in a small
+// fixed array of slots. Lookups on the hot path scan the published slots without locking, and
+// everything else happens under the lock. A slot is freed when its object is destroyed and reused
+// by the next one created, keeping its table allocation. If an application has more live objects
+// than fit, the rest spill into a map which is looked up under the lock as before.
+template <typename TableType>
+struct DispatchTableLookup
+{
+  static const int32_t MaxFastEntries = 16;
+
+  struct Entry
+  {
+    // NULL while the slot is free
+    void *volatile key;
+    TableType *table;
+  };
+
+  Entry entries[MaxFastEntries];
+
+  // slots [0, numEntries) have been used at least once and have a table allocated. Only ever
+  // incremented, after the slot is filled in - Inc32 is a full barrier and readers pair it with
+  // an acquire load.
+  volatile int32_t numEntries;
+
+  Threading::CriticalSection lock;
+  std::map<void *, TableType> overflow;
+
+  ~DispatchTableLookup()
+  {
+    for(int32_t i = 0; i < numEntries; i++)
+      delete entries[i].table;
+  }
+
+  TableType *FindFast(void *key)
+  {
+    int32_t num = Atomic::LoadAcquire32(&numEntries);
+    for(int32_t i = 0; i < num; i++)
+      if(entries[i].key == key)
+        return entries[i].table;
 
-static Threading::CriticalSection instlock;
-std::map<void *, VkLayerInstanceDispatchTableExtended> instlookup;
+    return NULL;
+  }
+
+  TableType *Get(void *key)
+  {
+    TableType *ret = FindFast(key);
+    if(ret)
+      return ret;
+
+    SCOPED_LOCK(lock);
+
+    auto it = overflow.find(key);
+    if(it != overflow.end())
+      return &it->second;
+
+    // may have been published while we were taking the lock
+    return FindFast(key);
+  }
+
+  TableType *Init(void *key)
+  {
+    SCOPED_LOCK(lock);
+
+    // keys can be re-used if an object is destroyed and another created at the same address
+    TableType *ret = FindFast(key);
+
+    if(ret == NULL)
+    {
+      auto it = overflow.find(key);
+      if(it != overflow.end())
+        ret = &it->second;
+    }
+
+    // reuse a slot freed by a destroyed object before adding a new one
+    for(int32_t i = 0; ret == NULL && i < numEntries; i++)
+    {
+      if(entries[i].key == NULL)
+      {
+        ret = entries[i].table;
+        entries[i].key = key;
+      }
+    }
+
+    if(ret == NULL)
+    {
+      if(numEntries < MaxFastEntries)
+      {
+        ret = new TableType;
+
+        // fill in the entry before publishing it, Inc32 is a full barrier
+        entries[numEntries].key = key;
+        entries[numEntries].table = ret;
+        Atomic::Inc32(&numEntries);
+      }
+      else
+      {
+        ret = &overflow[key];
+      }
+    }
+
+    RDCEraseMem(ret, sizeof(TableType));
+
+    return ret;
+  }
+
+  void Destroy(void *key)
+  {
+    SCOPED_LOCK(lock);
+
+    for(int32_t i = 0; i < numEntries; i++)
+    {
+      if(entries[i].key == key)
+      {
+        // the table stays allocated for the next object to use this slot
+        entries[i].key = NULL;
+        return;
+      }
+    }
+
+    overflow.erase(key);
+  }
+};
+
+static DispatchTableLookup<VkLayerDispatchTableExtended> devlookup;
+static DispatchTableLookup<VkLayerInstanceDispatchTableExtended> instlookup;
 
 static void *GetKey(void *obj)
 {
@@ -176,13 +296,7 @@ void InitDeviceTable(VkDevice dev, PFN_vkGetDeviceProcAddr gpa)
 {
   void *key = GetKey(dev);
 
-  VkLayerDispatchTableExtended *table = NULL;
-
-  {
-    SCOPED_LOCK(devlock);
-    RDCEraseEl(devlookup[key]);
-    table = &devlookup[key];
-  }
+  VkLayerDispatchTableExtended *table = devlookup.Init(key);
 
   table->GetDeviceProcAddr = gpa;
 
@@ -199,13 +313,7 @@ void InitInstanceTable(VkInstance inst, PFN_vkGetInstanceProcAddr gpa)
 {
   void *key = GetKey(inst);
 
-  VkLayerInstanceDispatchTableExtended *table = NULL;
-
-  {
-    SCOPED_LOCK(instlock);
-    RDCEraseEl(instlookup[key]);
-    table = &instlookup[key];
-  }
+  VkLayerInstanceDispatchTableExtended *table = instlookup.Init(key);
 
   // init the GetInstanceProcAddr function first
   table->GetInstanceProcAddr = gpa;
@@ -223,6 +331,16 @@ void InitInstanceTable(VkInstance inst, PFN_vkGetInstanceProcAddr gpa)
   HookInit(EnumerateDeviceLayerProperties);
 }
 
+void DestroyDeviceTable(VkDevice dev)
+{
+  devlookup.Destroy(GetKey(dev));
+}
+
+void DestroyInstanceTable(VkInstance inst)
+{
+  instlookup.Destroy(GetKey(inst));
+}
+
 VkLayerDispatchTableExtended *GetDeviceDispatchTable(void *device)
 {
   if(replay)
@@ -230,16 +348,12 @@ VkLayerDispatchTableExtended *GetDeviceDispatchTable(void *device)
 
   void *key = GetKey(device);
 
-  {
-    SCOPED_LOCK(devlock);
-
-    auto it = devlookup.find(key);
+  VkLayerDispatchTableExtended *table = devlookup.Get(key);
 
-    if(it == devlookup.end())
-      RDCFATAL("Bad device pointer");
+  if(table == NULL)
+    RDCFATAL("Bad device pointer");
 
-    return &it->second;
-  }
+  return table;
 }
 
 VkLayerInstanceDispatchTableExtended *GetInstanceDispatchTable(void *instance)
@@ -249,14 +363,10 @@ VkLayerInstanceDispatchTableExtended *GetInstanceDispatchTable(void *instance)
 
   void *key = GetKey(instance);
 
-  {
-    SCOPED_LOCK(instlock);
+  VkLayerInstanceDispatchTableExtended *table = instlookup.Get(key);
 
-    auto it = instlookup.find(key);
+  if(table == NULL)
+    RDCFATAL("Bad device pointer");
 
-    if(it == instlookup.end())
-      RDCFATAL("Bad device pointer");
-
-    return &it->second;
-  }
+  return table;
 }
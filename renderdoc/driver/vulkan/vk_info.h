@@ -253,6 +253,9 @@ struct VulkanCreationInfo
 
     VkBufferUsageFlags usage;
     uint64_t size;
+
+    // the memory bound with vkBindBufferMemory, if any
+    ResourceId memory;
   };
   map<ResourceId, Buffer> m_Buffer;
 
@@ -283,6 +286,9 @@ struct VulkanCreationInfo
 
     bool cube;
     TextureCategory creationFlags;
+
+    // the memory bound with vkBindImageMemory, if any
+    ResourceId memory;
   };
   map<ResourceId, Image> m_Image;
 
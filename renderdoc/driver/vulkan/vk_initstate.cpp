@@ -34,13 +34,56 @@
 // VKTODOLOW The code pattern for creating a few contiguous arrays all in one
 // AllocAlignedBuffer for the initial contents buffer is ugly.
 
-// VKTODOLOW in general we do a lot of "create buffer, use it, flush/sync then destroy".
-// I don't know what the exact cost is, but it would be nice to batch up the buffers/etc
-// used across init state use, and only do a single flush. Also we could then get some
-// nice command buffer reuse (although need to be careful we don't create too large a
-// command buffer that stalls the GPU).
+// On capture the init state preparation is batched - see m_InitStateBatch. Readback data is
+// suballocated from large heaps and all copies are recorded into shared command buffers, with
+// one wait in FinishInitStateBatch once every resource has been prepared.
+// The only overlap is the GPU copying into one heap while the CPU records the copies for the
+// next. The data isn't serialised until the capture ends, long after that wait, so there is no
+// overlap between serialisation and the copies.
+
+// VKTODOLOW on replay we still do a lot of "create buffer, use it, flush/sync then destroy".
+// It would be nice to batch up the buffers/etc used when applying init states too.
 // See INITSTATEBATCH
 
+// readback heaps are allocated in chunks of this size, unless a single resource is larger
+static const VkDeviceSize InitStateHeapSize = 64 * 1024 * 1024;
+
+// suballocations are aligned to this, which covers buffer-image copy offset requirements for
+// all formats
+static const VkDeviceSize InitStateAlignment = 256;
+
+// memory allocations at least this large only read back the ranges bound to resources
+static const VkDeviceSize PartialMemoryInitStateSize = 32 * 1024 * 1024;
+
+// a bound range of memory and where it landed in the packed readback data
+struct MemoryBindingReadback
+{
+  ResourceId resource;
+  VkDeviceSize memOffset, size;
+  VkDeviceSize dataOffset;
+};
+
+// prepared readback data for a non-sparse image or memory, stored as the initial contents blob.
+struct ReadbackInitState
+{
+  uint32_t heap;
+  VkDeviceSize offset;
+  VkDeviceSize size;
+
+  // if only the bound ranges of memory were read back, the bindings sorted by offset. These are
+  // allocated after the struct in the same blob. 0 if the whole image or memory was read back
+  uint32_t numBindings;
+  MemoryBindingReadback *bindings;
+};
+
+struct MemoryBindingSort
+{
+  bool operator()(const MemoryBinding &a, const MemoryBinding &b) const
+  {
+    return a.offset < b.offset;
+  }
+};
+
 struct MemIDOffset
 {
   ResourceId memId;
@@ -86,6 +129,159 @@ struct SparseImageInitState
   VkDeviceSize totalSize;
 };
 
+VkCommandBuffer WrappedVulkan::GetInitStateCmd()
+{
+  if(m_InitStateBatch.cmd == VK_NULL_HANDLE)
+  {
+    m_InitStateBatch.cmd = GetNextCmd();
+
+    VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+    VkResult vkr = ObjDisp(m_InitStateBatch.cmd)
+                       ->BeginCommandBuffer(Unwrap(m_InitStateBatch.cmd), &beginInfo);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
+
+  return m_InitStateBatch.cmd;
+}
+
+void WrappedVulkan::CloseInitStateCmd()
+{
+  if(m_InitStateBatch.cmd == VK_NULL_HANDLE)
+    return;
+
+  // make the readback copies visible to the host
+  VkMemoryBarrier memBarrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT,
+  };
+
+  DoPipelineBarrier(m_InitStateBatch.cmd, 1, &memBarrier);
+
+  VkResult vkr = ObjDisp(m_InitStateBatch.cmd)->EndCommandBuffer(Unwrap(m_InitStateBatch.cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  m_InitStateBatch.cmd = VK_NULL_HANDLE;
+
+  // kick off the copies so far, but don't wait. The GPU can work through them while we
+  // record the rest
+  SubmitCmds();
+}
+
+VkDeviceSize WrappedVulkan::AllocInitStateReadback(VkDeviceSize size, uint32_t &heapIdx)
+{
+  size = AlignUp(size, InitStateAlignment);
+
+  if(!m_InitStateBatch.heaps.empty())
+  {
+    InitStateHeap &heap = m_InitStateBatch.heaps.back();
+
+    if(heap.used + size <= heap.size)
+    {
+      VkDeviceSize ret = heap.used;
+      heap.used += size;
+      heapIdx = uint32_t(m_InitStateBatch.heaps.size() - 1);
+      return ret;
+    }
+
+    // the current heap is full, submit the copies into it before moving on to a new one
+    CloseInitStateCmd();
+  }
+
+  VkDevice d = GetDev();
+
+  InitStateHeap heap = {};
+  heap.size = RDCMAX(size, InitStateHeapSize);
+  heap.used = size;
+
+  VkBufferCreateInfo bufInfo = {
+      VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      NULL,
+      0,
+      heap.size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+  };
+
+  VkResult vkr = ObjDisp(d)->CreateBuffer(Unwrap(d), &bufInfo, NULL, &heap.buf);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  VkMemoryRequirements mrq = {0};
+
+  ObjDisp(d)->GetBufferMemoryRequirements(Unwrap(d), heap.buf, &mrq);
+
+  VkMemoryAllocateInfo allocInfo = {
+      VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
+      GetReadbackMemoryIndex(mrq.memoryTypeBits),
+  };
+
+  vkr = ObjDisp(d)->AllocateMemory(Unwrap(d), &allocInfo, NULL, &heap.mem);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), heap.buf, heap.mem, 0);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  // map up front so it's ready to serialise from as soon as the batch completes
+  vkr = ObjDisp(d)->MapMemory(Unwrap(d), heap.mem, 0, VK_WHOLE_SIZE, 0, (void **)&heap.data);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  heapIdx = (uint32_t)m_InitStateBatch.heaps.size();
+  m_InitStateBatch.heaps.push_back(heap);
+
+  return 0;
+}
+
+void WrappedVulkan::FinishInitStateBatch()
+{
+  CloseInitStateCmd();
+
+  if(m_InitStateBatch.heaps.empty() && m_InitStateBatch.bufdeletes.empty() &&
+     m_InitStateBatch.imgdeletes.empty() && m_InitStateBatch.memdeletes.empty())
+    return;
+
+  FlushQ();
+
+  VkDevice d = GetDev();
+
+  for(size_t i = 0; i < m_InitStateBatch.bufdeletes.size(); i++)
+    ObjDisp(d)->DestroyBuffer(Unwrap(d), m_InitStateBatch.bufdeletes[i], NULL);
+
+  for(size_t i = 0; i < m_InitStateBatch.imgdeletes.size(); i++)
+    ObjDisp(d)->DestroyImage(Unwrap(d), m_InitStateBatch.imgdeletes[i], NULL);
+
+  for(size_t i = 0; i < m_InitStateBatch.memdeletes.size(); i++)
+    ObjDisp(d)->FreeMemory(Unwrap(d), m_InitStateBatch.memdeletes[i], NULL);
+
+  m_InitStateBatch.bufdeletes.clear();
+  m_InitStateBatch.imgdeletes.clear();
+  m_InitStateBatch.memdeletes.clear();
+
+  // readback memory might not be coherent
+  for(size_t i = 0; i < m_InitStateBatch.heaps.size(); i++)
+  {
+    VkMappedMemoryRange range = {
+        VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, m_InitStateBatch.heaps[i].mem, 0,
+        VK_WHOLE_SIZE,
+    };
+
+    VkResult vkr = ObjDisp(d)->InvalidateMappedMemoryRanges(Unwrap(d), 1, &range);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  }
+}
+
+void WrappedVulkan::FreeInitStateHeaps()
+{
+  VkDevice d = GetDev();
+
+  for(size_t i = 0; i < m_InitStateBatch.heaps.size(); i++)
+  {
+    ObjDisp(d)->UnmapMemory(Unwrap(d), m_InitStateBatch.heaps[i].mem);
+    ObjDisp(d)->DestroyBuffer(Unwrap(d), m_InitStateBatch.heaps[i].buf, NULL);
+    ObjDisp(d)->FreeMemory(Unwrap(d), m_InitStateBatch.heaps[i].mem, NULL);
+  }
+
+  m_InitStateBatch.heaps.clear();
+}
+
 bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
 {
   ResourceId id = buf->id;
@@ -115,8 +311,6 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
   memcpy(binds, &buf->record->sparseInfo->opaquemappings[0], sizeof(VkSparseMemoryBind) * numElems);
 
   VkDevice d = GetDev();
-  // INITSTATEBATCH
-  VkCommandBuffer cmd = GetNextCmd();
 
   VkBufferCreateInfo bufInfo = {
       VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
@@ -171,14 +365,9 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
   vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), dstBuf, Unwrap(readbackmem), 0);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  vector<VkBuffer> bufdeletes;
-  bufdeletes.push_back(dstBuf);
+  m_InitStateBatch.bufdeletes.push_back(dstBuf);
 
-  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
-
-  vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  VkCommandBuffer cmd = GetInitStateCmd();
 
   // copy all of the bound memory objects
   for(auto it = boundMems.begin(); it != boundMems.end(); ++it)
@@ -197,19 +386,9 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
 
     ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), srcBuf, dstBuf, 1, &region);
 
-    bufdeletes.push_back(srcBuf);
+    m_InitStateBatch.bufdeletes.push_back(srcBuf);
   }
 
-  vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  // INITSTATEBATCH
-  SubmitCmds();
-  FlushQ();
-
-  for(size_t i = 0; i < bufdeletes.size(); i++)
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), bufdeletes[i], NULL);
-
   GetResourceManager()->SetInitialContents(
       id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), 0, (byte *)info));
 
@@ -290,8 +469,6 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
   }
 
   VkDevice d = GetDev();
-  // INITSTATEBATCH
-  VkCommandBuffer cmd = GetNextCmd();
 
   VkBufferCreateInfo bufInfo = {
       VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
@@ -346,14 +523,9 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
   vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), dstBuf, Unwrap(readbackmem), 0);
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  vector<VkBuffer> bufdeletes;
-  bufdeletes.push_back(dstBuf);
-
-  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+  m_InitStateBatch.bufdeletes.push_back(dstBuf);
 
-  vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+  VkCommandBuffer cmd = GetInitStateCmd();
 
   // copy all of the bound memory objects
   for(auto it = boundMems.begin(); it != boundMems.end(); ++it)
@@ -372,21 +544,12 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
 
     ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), srcBuf, dstBuf, 1, &region);
 
-    bufdeletes.push_back(srcBuf);
+    m_InitStateBatch.bufdeletes.push_back(srcBuf);
   }
 
-  vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
-  RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-  // INITSTATEBATCH
-  SubmitCmds();
-  FlushQ();
-
-  for(size_t i = 0; i < bufdeletes.size(); i++)
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), bufdeletes[i], NULL);
-
   GetResourceManager()->SetInitialContents(
-      id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), 0, (byte *)blob));
+      id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem),
+                                                    eInitialContents_Sparse, (byte *)blob));
 
   return true;
 }
@@ -1026,8 +1189,6 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     }
 
     VkDevice d = GetDev();
-    // INITSTATEBATCH
-    VkCommandBuffer cmd = GetNextCmd();
 
     ImageLayouts *layout = NULL;
     {
@@ -1040,16 +1201,6 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     if(IsBlockFormat(layout->format))
       bufAlignment = (VkDeviceSize)GetByteSize(1, 1, 1, layout->format, 0);
 
-    VkDeviceMemory readbackmem = VK_NULL_HANDLE;
-
-    VkBufferCreateInfo bufInfo = {
-        VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        NULL,
-        0,
-        0,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-    };
-
     VkImage arrayIm = VK_NULL_HANDLE;
     VkDeviceMemory arrayMem = VK_NULL_HANDLE;
 
@@ -1092,58 +1243,47 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
 
       vkr = ObjDisp(d)->BindImageMemory(Unwrap(d), arrayIm, arrayMem, 0);
       RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      // this can't be freed until the batch has completed
+      m_InitStateBatch.imgdeletes.push_back(arrayIm);
+      m_InitStateBatch.memdeletes.push_back(arrayMem);
     }
 
     VkFormat sizeFormat = GetDepthOnlyFormat(layout->format);
 
+    VkDeviceSize dataSize = 0;
+
     for(int a = 0; a < numLayers; a++)
     {
       for(int m = 0; m < layout->levelCount; m++)
       {
-        bufInfo.size = AlignUp(bufInfo.size, bufAlignment);
+        dataSize = AlignUp(dataSize, bufAlignment);
 
-        bufInfo.size += GetByteSize(layout->extent.width, layout->extent.height,
-                                    layout->extent.depth, sizeFormat, m);
+        dataSize += GetByteSize(layout->extent.width, layout->extent.height,
+                                layout->extent.depth, sizeFormat, m);
 
         if(sizeFormat != layout->format)
         {
           // if there's stencil and depth, allocate space for stencil
-          bufInfo.size = AlignUp(bufInfo.size, bufAlignment);
+          dataSize = AlignUp(dataSize, bufAlignment);
 
-          bufInfo.size += GetByteSize(layout->extent.width, layout->extent.height,
-                                      layout->extent.depth, VK_FORMAT_S8_UINT, m);
+          dataSize += GetByteSize(layout->extent.width, layout->extent.height,
+                                  layout->extent.depth, VK_FORMAT_S8_UINT, m);
         }
       }
     }
 
-    // since this is very short lived, it is not wrapped
-    VkBuffer dstBuf;
-
-    vkr = ObjDisp(d)->CreateBuffer(Unwrap(d), &bufInfo, NULL, &dstBuf);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    VkMemoryRequirements mrq = {0};
-
-    ObjDisp(d)->GetBufferMemoryRequirements(Unwrap(d), dstBuf, &mrq);
-
-    VkMemoryAllocateInfo allocInfo = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
-        GetReadbackMemoryIndex(mrq.memoryTypeBits),
-    };
-
-    vkr = ObjDisp(d)->AllocateMemory(Unwrap(d), &allocInfo, NULL, &readbackmem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    GetResourceManager()->WrapResource(Unwrap(d), readbackmem);
+    ReadbackInitState *info =
+        (ReadbackInitState *)Serialiser::AllocAlignedBuffer(sizeof(ReadbackInitState));
 
-    vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), dstBuf, Unwrap(readbackmem), 0);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    info->size = dataSize;
+    info->offset = AllocInitStateReadback(dataSize, info->heap);
+    info->numBindings = 0;
+    info->bindings = NULL;
 
-    VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+    VkBuffer dstBuf = m_InitStateBatch.heaps[info->heap].buf;
 
-    vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    VkCommandBuffer cmd = GetInitStateCmd();
 
     VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
     if(IsStencilOnlyFormat(layout->format))
@@ -1199,16 +1339,14 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
 
       DoPipelineBarrier(cmd, 1, &arrayimBarrier);
 
-      vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
-      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      // the MSAA copy records and submits its own commands, so close the batch first to keep
+      // everything in order. It also waits, so MSAA images remain a sync point.
+      CloseInitStateCmd();
 
       GetDebugManager()->CopyTex2DMSToArray(arrayIm, realim, layout->extent, layout->layerCount,
                                             layout->sampleCount, layout->format);
 
-      cmd = GetNextCmd();
-
-      vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      cmd = GetInitStateCmd();
 
       arrayimBarrier.srcAccessMask =
           VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
@@ -1221,7 +1359,7 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
       realim = arrayIm;
     }
 
-    VkDeviceSize bufOffset = 0;
+    VkDeviceSize bufOffset = info->offset;
 
     // loop over every slice/mip, copying it to the appropriate point in the buffer
     for(int a = 0; a < numLayers; a++)
@@ -1273,8 +1411,9 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
       }
     }
 
-    RDCASSERTMSG("buffer wasn't sized sufficiently!", bufOffset <= bufInfo.size, bufOffset,
-                 mrq.size, layout->extent, layout->format, numLayers, layout->levelCount);
+    RDCASSERTMSG("buffer wasn't sized sufficiently!", bufOffset <= info->offset + dataSize,
+                 bufOffset, dataSize, layout->extent, layout->format, numLayers,
+                 layout->levelCount);
 
     // transfer back to whatever it was
     srcimBarrier.oldLayout = srcimBarrier.newLayout;
@@ -1290,24 +1429,8 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
       DoPipelineBarrier(cmd, 1, &srcimBarrier);
     }
 
-    vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    // INITSTATEBATCH
-    SubmitCmds();
-    FlushQ();
-
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), dstBuf, NULL);
-
-    if(arrayIm != VK_NULL_HANDLE)
-    {
-      ObjDisp(d)->DestroyImage(Unwrap(d), arrayIm, NULL);
-      ObjDisp(d)->FreeMemory(Unwrap(d), arrayMem, NULL);
-    }
-
     GetResourceManager()->SetInitialContents(
-        id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), (uint32_t)mrq.size,
-                                                      NULL));
+        id, VulkanResourceManager::InitialContentData(NULL, 0, (byte *)info));
 
     return true;
   }
@@ -1316,8 +1439,6 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     VkResult vkr = VK_SUCCESS;
 
     VkDevice d = GetDev();
-    // INITSTATEBATCH
-    VkCommandBuffer cmd = GetNextCmd();
 
     VkResourceRecord *record = GetResourceManager()->GetResourceRecord(id);
     VkDeviceSize dataoffs = 0;
@@ -1329,8 +1450,6 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     RDCASSERT(record->Length > 0);
     VkDeviceSize memsize = record->Length;
 
-    VkDeviceMemory readbackmem = VK_NULL_HANDLE;
-
     VkBufferCreateInfo bufInfo = {
         VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         NULL,
@@ -1339,63 +1458,108 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
     };
 
-    // since these are very short lived, they are not wrapped
-    VkBuffer srcBuf, dstBuf;
-
-    // dstBuf is just over the allocated memory, so only the image's size
-    bufInfo.size = datasize;
-    vkr = ObjDisp(d)->CreateBuffer(Unwrap(d), &bufInfo, NULL, &dstBuf);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    // since this is very short lived, it is not wrapped
+    VkBuffer srcBuf;
 
     // srcBuf spans the entire memory, then we copy out the sub-region we're interested in
     bufInfo.size = memsize;
     vkr = ObjDisp(d)->CreateBuffer(Unwrap(d), &bufInfo, NULL, &srcBuf);
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    VkMemoryRequirements mrq = {0};
+    vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), srcBuf, datamem, 0);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    ObjDisp(d)->GetBufferMemoryRequirements(Unwrap(d), srcBuf, &mrq);
+    m_InitStateBatch.bufdeletes.push_back(srcBuf);
 
-    VkMemoryAllocateInfo allocInfo = {
-        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, datasize,
-        GetReadbackMemoryIndex(mrq.memoryTypeBits),
-    };
+    // large allocations are usually suballocated from, so only read back the ranges bound to
+    // something. Which of those the frame actually uses isn't known until the end of the frame,
+    // so they're filtered again when serialising
+    vector<MemoryBinding> bindings;
 
-    allocInfo.allocationSize = AlignUp(allocInfo.allocationSize, mrq.alignment);
+    if(memsize >= PartialMemoryInitStateSize)
+    {
+      SCOPED_LOCK(m_MemBindingsLock);
+      if(!record->memMapState->sparseBound)
+        bindings = record->memMapState->bindings;
+    }
 
-    vkr = ObjDisp(d)->AllocateMemory(Unwrap(d), &allocInfo, NULL, &readbackmem);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    std::sort(bindings.begin(), bindings.end(), MemoryBindingSort());
 
-    GetResourceManager()->WrapResource(Unwrap(d), readbackmem);
+    // merge overlapping and adjacent ranges into spans, packed one after another in the readback.
+    // dstOffset is relative to the start of the readback data here
+    vector<VkBufferCopy> spans;
 
-    vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), srcBuf, datamem, 0);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-    vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), dstBuf, Unwrap(readbackmem), 0);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    for(size_t i = 0; i < bindings.size(); i++)
+    {
+      VkDeviceSize start = RDCMIN(bindings[i].offset, memsize);
+      VkDeviceSize end = RDCMIN(bindings[i].offset + bindings[i].size, memsize);
 
-    VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+      if(!spans.empty() && start <= spans.back().srcOffset + spans.back().size)
+      {
+        VkBufferCopy &span = spans.back();
+        span.size = RDCMAX(span.size, end - span.srcOffset);
+      }
+      else if(end > start)
+      {
+        VkBufferCopy span = {start, 0, end - start};
+        spans.push_back(span);
+      }
+    }
 
-    vkr = ObjDisp(d)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    if(spans.empty())
+    {
+      bindings.clear();
 
-    VkBufferCopy region = {dataoffs, 0, datasize};
+      VkBufferCopy span = {dataoffs, 0, datasize};
+      spans.push_back(span);
+    }
+    else
+    {
+      datasize = 0;
+      for(size_t i = 0; i < spans.size(); i++)
+      {
+        spans[i].dstOffset = datasize;
+        datasize += spans[i].size;
+      }
+    }
 
-    ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), srcBuf, dstBuf, 1, &region);
+    ReadbackInitState *info = (ReadbackInitState *)Serialiser::AllocAlignedBuffer(
+        sizeof(ReadbackInitState) + sizeof(MemoryBindingReadback) * bindings.size());
 
-    vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    info->size = datasize;
+    info->offset = AllocInitStateReadback(datasize, info->heap);
+    info->numBindings = 0;
+    info->bindings = (MemoryBindingReadback *)(info + 1);
 
-    // INITSTATEBATCH
-    SubmitCmds();
-    FlushQ();
+    for(size_t i = 0, sp = 0; i < bindings.size(); i++)
+    {
+      VkDeviceSize start = RDCMIN(bindings[i].offset, memsize);
+      VkDeviceSize end = RDCMIN(bindings[i].offset + bindings[i].size, memsize);
+
+      if(end <= start)
+        continue;
+
+      // every non-empty binding lies entirely within one span
+      while(start >= spans[sp].srcOffset + spans[sp].size)
+        sp++;
+
+      MemoryBindingReadback &bind = info->bindings[info->numBindings++];
+      bind.resource = bindings[i].resource;
+      bind.memOffset = start;
+      bind.size = end - start;
+      bind.dataOffset = spans[sp].dstOffset + (start - spans[sp].srcOffset);
+    }
+
+    for(size_t i = 0; i < spans.size(); i++)
+      spans[i].dstOffset += info->offset;
 
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), srcBuf, NULL);
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), dstBuf, NULL);
+    VkCommandBuffer cmd = GetInitStateCmd();
+
+    ObjDisp(d)->CmdCopyBuffer(Unwrap(cmd), srcBuf, m_InitStateBatch.heaps[info->heap].buf,
+                              (uint32_t)spans.size(), &spans[0]);
 
     GetResourceManager()->SetInitialContents(
-        id, VulkanResourceManager::InitialContentData(GetWrapped(readbackmem), (uint32_t)datasize,
-                                                      NULL));
+        id, VulkanResourceManager::InitialContentData(NULL, 0, (byte *)info));
 
     return true;
   }
@@ -1407,6 +1571,155 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
   return false;
 }
 
+// builds a blob holding a VkWriteDescriptorSet per binding that has valid contents in bindings,
+// followed by the descriptor structures they point to. validBinds is set to how many writes there
+// are at the start of the blob.
+byte *WrappedVulkan::MakeDescriptorSetWrites(VkDescriptorSet set, const DescSetLayout &layout,
+                                             const DescriptorSetSlot *bindings, uint32_t numElems,
+                                             uint32_t &validBinds)
+{
+  uint32_t numBinds = (uint32_t)layout.bindings.size();
+
+  // allocate memory to keep the element structures around, as well as a WriteDescriptorSet
+  // array
+  byte *blob = Serialiser::AllocAlignedBuffer(sizeof(VkDescriptorBufferInfo) * numElems +
+                                              sizeof(VkWriteDescriptorSet) * numBinds);
+
+  RDCCOMPILE_ASSERT(sizeof(VkDescriptorBufferInfo) >= sizeof(VkDescriptorImageInfo),
+                    "Descriptor structs sizes are unexpected, ensure largest size is used");
+
+  VkWriteDescriptorSet *writes = (VkWriteDescriptorSet *)blob;
+  VkDescriptorBufferInfo *dstData = (VkDescriptorBufferInfo *)(writes + numBinds);
+  const DescriptorSetSlot *srcData = bindings;
+
+  validBinds = numBinds;
+
+  // i is the writedescriptor that we're updating, could be
+  // lower than j if a writedescriptor ended up being no-op and
+  // was skipped. j is the actual index.
+  for(uint32_t i = 0, j = 0; j < numBinds; j++)
+  {
+    writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[i].pNext = NULL;
+
+    // update whole element (array or single)
+    writes[i].dstSet = set;
+    writes[i].dstBinding = j;
+    writes[i].dstArrayElement = 0;
+    writes[i].descriptorCount = layout.bindings[j].descriptorCount;
+    writes[i].descriptorType = layout.bindings[j].descriptorType;
+
+    const DescriptorSetSlot *src = srcData;
+    srcData += layout.bindings[j].descriptorCount;
+
+    // will be cast to the appropriate type, we just need to increment
+    // the dstData pointer by worst case size
+    VkDescriptorBufferInfo *dstBuffer = dstData;
+    VkDescriptorImageInfo *dstImage = (VkDescriptorImageInfo *)dstData;
+    VkBufferView *dstTexelBuffer = (VkBufferView *)dstData;
+    dstData += layout.bindings[j].descriptorCount;
+
+    // the correct one will be set below
+    writes[i].pBufferInfo = NULL;
+    writes[i].pImageInfo = NULL;
+    writes[i].pTexelBufferView = NULL;
+
+    // check that the resources we need for this write are present,
+    // as some might have been skipped due to stale descriptor set
+    // slots or otherwise unreferenced objects (the descriptor set
+    // initial contents do not cause a frame reference for their
+    // resources
+    //
+    // While we go, we copy from the DescriptorSetSlot structures to
+    // the appropriate array in the VkWriteDescriptorSet for the
+    // descriptor type
+    bool valid = true;
+
+    // quick check for slots that were completely uninitialised
+    // and so don't have valid data
+    if(src->texelBufferView == VK_NULL_HANDLE && src->imageInfo.sampler == VK_NULL_HANDLE &&
+       src->imageInfo.imageView == VK_NULL_HANDLE && src->bufferInfo.buffer == VK_NULL_HANDLE)
+    {
+      valid = false;
+    }
+    else
+    {
+      switch(writes[i].descriptorType)
+      {
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+        {
+          for(uint32_t d = 0; d < writes[i].descriptorCount; d++)
+          {
+            dstImage[d] = src[d].imageInfo;
+            valid &= (src[d].imageInfo.sampler != VK_NULL_HANDLE);
+          }
+          writes[i].pImageInfo = dstImage;
+          break;
+        }
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        {
+          for(uint32_t d = 0; d < writes[i].descriptorCount; d++)
+          {
+            dstImage[d] = src[d].imageInfo;
+            valid &= (src[d].imageInfo.sampler != VK_NULL_HANDLE) ||
+                     (layout.bindings[j].immutableSampler &&
+                      layout.bindings[j].immutableSampler[d] != ResourceId());
+            valid &= (src[d].imageInfo.imageView != VK_NULL_HANDLE);
+          }
+          writes[i].pImageInfo = dstImage;
+          break;
+        }
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+        {
+          for(uint32_t d = 0; d < writes[i].descriptorCount; d++)
+          {
+            dstImage[d] = src[d].imageInfo;
+            valid &= (src[d].imageInfo.imageView != VK_NULL_HANDLE);
+          }
+          writes[i].pImageInfo = dstImage;
+          break;
+        }
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+        {
+          for(uint32_t d = 0; d < writes[i].descriptorCount; d++)
+          {
+            dstTexelBuffer[d] = src[d].texelBufferView;
+            valid &= (src[d].texelBufferView != VK_NULL_HANDLE);
+          }
+          writes[i].pTexelBufferView = dstTexelBuffer;
+          break;
+        }
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+        {
+          for(uint32_t d = 0; d < writes[i].descriptorCount; d++)
+          {
+            dstBuffer[d] = src[d].bufferInfo;
+            valid &= (src[d].bufferInfo.buffer != VK_NULL_HANDLE);
+          }
+          writes[i].pBufferInfo = dstBuffer;
+          break;
+        }
+        default: RDCERR("Unexpected descriptor type %d", writes[i].descriptorType);
+      }
+    }
+
+    // if this write is not valid, skip it
+    // and start writing the next one in here
+    if(!valid)
+      validBinds--;
+    else
+      i++;
+  }
+
+  return blob;
+}
+
 // second parameter isn't used, as we might be serialising init state for a deleted resource
 bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
 {
@@ -1447,9 +1760,7 @@ bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
     else if(type == eResDeviceMemory || type == eResImage)
     {
       // both image and memory are serialised as a whole hunk of data
-      VkDevice d = GetDev();
-
-      bool isSparse = (initContents.blob != NULL);
+      bool isSparse = (initContents.num == eInitialContents_Sparse);
       m_pSerialiser->Serialise("isSparse", isSparse);
 
       if(isSparse)
@@ -1459,16 +1770,93 @@ bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
         return Serialise_SparseImageInitialState(id, initContents);
       }
 
-      byte *ptr = NULL;
-      ObjDisp(d)->MapMemory(Unwrap(d), ToHandle<VkDeviceMemory>(initContents.resource), 0,
-                            VK_WHOLE_SIZE, 0, (void **)&ptr);
+      if(type == eResImage)
+      {
+        // images that were completely overwritten before anything read them don't need their
+        // contents, on replay they're just cleared
+        bool omitted = !RenderDoc::Inst().GetCaptureOptions().SaveAllInitials &&
+                       GetResourceManager()->OverwrittenBeforeRead(id);
 
-      size_t dataSize = (size_t)initContents.num;
+        m_pSerialiser->Serialise("omitted", omitted);
 
-      m_pSerialiser->Serialise("dataSize", initContents.num);
-      m_pSerialiser->SerialiseBuffer("data", ptr, dataSize);
+        if(omitted)
+        {
+          RDCDEBUG("Not serialising image initial state %llu, it's overwritten before being read",
+                   id);
+          return true;
+        }
+      }
+
+      ReadbackInitState *info = (ReadbackInitState *)initContents.blob;
+
+      // the readback heaps are already mapped, and the batch was completed at capture start
+      byte *ptr = m_InitStateBatch.heaps[info->heap].data + info->offset;
+
+      if(type == eResDeviceMemory)
+      {
+        bool partial = info->numBindings > 0;
+        m_pSerialiser->Serialise("partial", partial);
+
+        if(partial)
+        {
+          // merge the ranges of the resources used in the frame into regions. srcOffset is in
+          // the readback data, which is contiguous for any overlapping or adjacent bindings
+          vector<VkBufferCopy> regions;
+
+          for(uint32_t i = 0; i < info->numBindings; i++)
+          {
+            const MemoryBindingReadback &bind = info->bindings[i];
+
+            if(!GetResourceManager()->IsFrameReferenced(bind.resource))
+              continue;
+
+            if(!regions.empty() && bind.memOffset <= regions.back().dstOffset + regions.back().size)
+            {
+              VkBufferCopy &region = regions.back();
+              region.size = RDCMAX(region.size, bind.memOffset + bind.size - region.dstOffset);
+            }
+            else
+            {
+              VkBufferCopy region = {bind.dataOffset, bind.memOffset, bind.size};
+              regions.push_back(region);
+            }
+          }
 
-      ObjDisp(d)->UnmapMemory(Unwrap(d), ToHandle<VkDeviceMemory>(initContents.resource));
+          // the data is packed when written out, so srcOffset becomes the offset in that
+          vector<VkBufferCopy> packed = regions;
+
+          VkDeviceSize packedSize = 0;
+          for(size_t i = 0; i < packed.size(); i++)
+          {
+            packed[i].srcOffset = packedSize;
+            packedSize += packed[i].size;
+          }
+
+          VkBufferCopy *packedRegions = packed.empty() ? NULL : &packed[0];
+          uint32_t numRegions = (uint32_t)packed.size();
+
+          m_pSerialiser->SerialisePODArray("regions", packedRegions, numRegions);
+
+          for(size_t i = 0; i < regions.size(); i++)
+          {
+            byte *data = ptr + regions[i].srcOffset;
+            size_t dataSize = (size_t)regions[i].size;
+
+            m_pSerialiser->SerialiseBuffer("data", data, dataSize);
+          }
+
+          RDCDEBUG("Serialised %llu of %llu bytes of memory %llu, from %u bindings", packedSize,
+                   record->Length, id, info->numBindings);
+
+          return true;
+        }
+      }
+
+      uint32_t dataSize32 = (uint32_t)info->size;
+      size_t dataSize = (size_t)info->size;
+
+      m_pSerialiser->Serialise("dataSize", dataSize32);
+      m_pSerialiser->SerialiseBuffer("data", ptr, dataSize);
     }
     else
     {
@@ -1493,144 +1881,9 @@ bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
       const DescSetLayout &layout =
           m_CreationInfo.m_DescSetLayout[m_DescriptorSetState[liveid].layout];
 
-      uint32_t numBinds = (uint32_t)layout.bindings.size();
-
-      // allocate memory to keep the element structures around, as well as a WriteDescriptorSet
-      // array
-      byte *blob = Serialiser::AllocAlignedBuffer(sizeof(VkDescriptorBufferInfo) * numElems +
-                                                  sizeof(VkWriteDescriptorSet) * numBinds);
-
-      RDCCOMPILE_ASSERT(sizeof(VkDescriptorBufferInfo) >= sizeof(VkDescriptorImageInfo),
-                        "Descriptor structs sizes are unexpected, ensure largest size is used");
-
-      VkWriteDescriptorSet *writes = (VkWriteDescriptorSet *)blob;
-      VkDescriptorBufferInfo *dstData = (VkDescriptorBufferInfo *)(writes + numBinds);
-      DescriptorSetSlot *srcData = bindings;
-
-      uint32_t validBinds = numBinds;
-
-      // i is the writedescriptor that we're updating, could be
-      // lower than j if a writedescriptor ended up being no-op and
-      // was skipped. j is the actual index.
-      for(uint32_t i = 0, j = 0; j < numBinds; j++)
-      {
-        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writes[i].pNext = NULL;
-
-        // update whole element (array or single)
-        writes[i].dstSet = ToHandle<VkDescriptorSet>(res);
-        writes[i].dstBinding = j;
-        writes[i].dstArrayElement = 0;
-        writes[i].descriptorCount = layout.bindings[j].descriptorCount;
-        writes[i].descriptorType = layout.bindings[j].descriptorType;
-
-        DescriptorSetSlot *src = srcData;
-        srcData += layout.bindings[j].descriptorCount;
-
-        // will be cast to the appropriate type, we just need to increment
-        // the dstData pointer by worst case size
-        VkDescriptorBufferInfo *dstBuffer = dstData;
-        VkDescriptorImageInfo *dstImage = (VkDescriptorImageInfo *)dstData;
-        VkBufferView *dstTexelBuffer = (VkBufferView *)dstData;
-        dstData += layout.bindings[j].descriptorCount;
-
-        // the correct one will be set below
-        writes[i].pBufferInfo = NULL;
-        writes[i].pImageInfo = NULL;
-        writes[i].pTexelBufferView = NULL;
-
-        // check that the resources we need for this write are present,
-        // as some might have been skipped due to stale descriptor set
-        // slots or otherwise unreferenced objects (the descriptor set
-        // initial contents do not cause a frame reference for their
-        // resources
-        //
-        // While we go, we copy from the DescriptorSetSlot structures to
-        // the appropriate array in the VkWriteDescriptorSet for the
-        // descriptor type
-        bool valid = true;
-
-        // quick check for slots that were completely uninitialised
-        // and so don't have valid data
-        if(src->texelBufferView == VK_NULL_HANDLE && src->imageInfo.sampler == VK_NULL_HANDLE &&
-           src->imageInfo.imageView == VK_NULL_HANDLE && src->bufferInfo.buffer == VK_NULL_HANDLE)
-        {
-          valid = false;
-        }
-        else
-        {
-          switch(writes[i].descriptorType)
-          {
-            case VK_DESCRIPTOR_TYPE_SAMPLER:
-            {
-              for(uint32_t d = 0; d < writes[i].descriptorCount; d++)
-              {
-                dstImage[d] = src[d].imageInfo;
-                valid &= (src[d].imageInfo.sampler != VK_NULL_HANDLE);
-              }
-              writes[i].pImageInfo = dstImage;
-              break;
-            }
-            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-            {
-              for(uint32_t d = 0; d < writes[i].descriptorCount; d++)
-              {
-                dstImage[d] = src[d].imageInfo;
-                valid &= (src[d].imageInfo.sampler != VK_NULL_HANDLE) ||
-                         (layout.bindings[j].immutableSampler &&
-                          layout.bindings[j].immutableSampler[d] != ResourceId());
-                valid &= (src[d].imageInfo.imageView != VK_NULL_HANDLE);
-              }
-              writes[i].pImageInfo = dstImage;
-              break;
-            }
-            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-            {
-              for(uint32_t d = 0; d < writes[i].descriptorCount; d++)
-              {
-                dstImage[d] = src[d].imageInfo;
-                valid &= (src[d].imageInfo.imageView != VK_NULL_HANDLE);
-              }
-              writes[i].pImageInfo = dstImage;
-              break;
-            }
-            case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-            case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-            {
-              for(uint32_t d = 0; d < writes[i].descriptorCount; d++)
-              {
-                dstTexelBuffer[d] = src[d].texelBufferView;
-                valid &= (src[d].texelBufferView != VK_NULL_HANDLE);
-              }
-              writes[i].pTexelBufferView = dstTexelBuffer;
-              break;
-            }
-            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
-            {
-              for(uint32_t d = 0; d < writes[i].descriptorCount; d++)
-              {
-                dstBuffer[d] = src[d].bufferInfo;
-                valid &= (src[d].bufferInfo.buffer != VK_NULL_HANDLE);
-              }
-              writes[i].pBufferInfo = dstBuffer;
-              break;
-            }
-            default: RDCERR("Unexpected descriptor type %d", writes[i].descriptorType);
-          }
-        }
-
-        // if this write is not valid, skip it
-        // and start writing the next one in here
-        if(!valid)
-          validBinds--;
-        else
-          i++;
-      }
+      uint32_t validBinds = 0;
+      byte *blob = MakeDescriptorSetWrites(ToHandle<VkDescriptorSet>(res), layout, bindings,
+                                           numElems, validBinds);
 
       SAFE_DELETE_ARRAY(bindings);
 
@@ -1651,9 +1904,38 @@ bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
         return Serialise_SparseImageInitialState(id, VulkanResourceManager::InitialContentData());
       }
 
+      bool omitted = false;
+
+      if(GetLogVersion() >= 0x0000007)
+        m_pSerialiser->Serialise("omitted", omitted);
+
+      if(omitted)
+      {
+        Create_InitialState(id, res, false);
+        return true;
+      }
+
       uint32_t dataSize = 0;
       m_pSerialiser->Serialise("dataSize", dataSize);
 
+      VulkanCreationInfo::Image &c = m_CreationInfo.m_Image[liveid];
+
+      // single-sampled image data stays on the CPU until something uses or inspects the image,
+      // so textures nothing in the frame touches don't take up GPU memory. It has to be copied
+      // out here: initial contents come before the capture scope so they aren't part of the
+      // persistent block, and the compressed file can't be seeked back into once it's closed
+      if(c.samples == VK_SAMPLE_COUNT_1_BIT)
+      {
+        byte *data = Serialiser::AllocAlignedBuffer(dataSize);
+
+        size_t dummy = 0;
+        m_pSerialiser->SerialiseBuffer("data", data, dummy);
+
+        m_DeferredImageContents[id] = std::make_pair(data, dataSize);
+
+        return true;
+      }
+
       VkResult vkr = VK_SUCCESS;
 
       VkDevice d = GetDev();
@@ -1703,182 +1985,173 @@ bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
 
       VulkanResourceManager::InitialContentData initial(GetWrapped(buf), 0, NULL);
 
-      VulkanCreationInfo::Image &c = m_CreationInfo.m_Image[liveid];
+      // multisampled images are uploaded into an array image, then copied across when applied
+      int numLayers = c.arrayLayers * (int)c.samples;
 
-      if(c.samples == VK_SAMPLE_COUNT_1_BIT)
-      {
-        // remember to free this memory on shutdown
-        m_CleanupMems.push_back(uploadmem);
-      }
-      else
-      {
-        int numLayers = c.arrayLayers * (int)c.samples;
+      VkImageCreateInfo arrayInfo = {
+          VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+          NULL,
+          VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT,
+          VK_IMAGE_TYPE_2D,
+          c.format,
+          c.extent,
+          (uint32_t)c.mipLevels,
+          (uint32_t)numLayers,
+          VK_SAMPLE_COUNT_1_BIT,
+          VK_IMAGE_TILING_OPTIMAL,
+          VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+          VK_SHARING_MODE_EXCLUSIVE,
+          0,
+          NULL,
+          VK_IMAGE_LAYOUT_UNDEFINED,
+      };
 
-        VkImageCreateInfo arrayInfo = {
-            VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-            NULL,
-            VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT,
-            VK_IMAGE_TYPE_2D,
-            c.format,
-            c.extent,
-            (uint32_t)c.mipLevels,
-            (uint32_t)numLayers,
-            VK_SAMPLE_COUNT_1_BIT,
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-            VK_SHARING_MODE_EXCLUSIVE,
-            0,
-            NULL,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-        };
+      VkImage arrayIm;
 
-        VkImage arrayIm;
+      vkr = ObjDisp(d)->CreateImage(Unwrap(d), &arrayInfo, NULL, &arrayIm);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-        vkr = ObjDisp(d)->CreateImage(Unwrap(d), &arrayInfo, NULL, &arrayIm);
-        RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      GetResourceManager()->WrapResource(Unwrap(d), arrayIm);
 
-        GetResourceManager()->WrapResource(Unwrap(d), arrayIm);
+      ObjDisp(d)->GetImageMemoryRequirements(Unwrap(d), Unwrap(arrayIm), &mrq);
 
-        ObjDisp(d)->GetImageMemoryRequirements(Unwrap(d), Unwrap(arrayIm), &mrq);
+      allocInfo.allocationSize = mrq.size;
+      allocInfo.memoryTypeIndex = GetGPULocalMemoryIndex(mrq.memoryTypeBits);
 
-        allocInfo.allocationSize = mrq.size;
-        allocInfo.memoryTypeIndex = GetGPULocalMemoryIndex(mrq.memoryTypeBits);
+      VkDeviceMemory arrayMem;
 
-        VkDeviceMemory arrayMem;
+      vkr = ObjDisp(d)->AllocateMemory(Unwrap(d), &allocInfo, NULL, &arrayMem);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-        vkr = ObjDisp(d)->AllocateMemory(Unwrap(d), &allocInfo, NULL, &arrayMem);
-        RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      GetResourceManager()->WrapResource(Unwrap(d), arrayMem);
 
-        GetResourceManager()->WrapResource(Unwrap(d), arrayMem);
+      vkr = ObjDisp(d)->BindImageMemory(Unwrap(d), Unwrap(arrayIm), Unwrap(arrayMem), 0);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-        vkr = ObjDisp(d)->BindImageMemory(Unwrap(d), Unwrap(arrayIm), Unwrap(arrayMem), 0);
-        RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      VkCommandBuffer cmd = GetNextCmd();
 
-        VkCommandBuffer cmd = GetNextCmd();
+      VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
 
-        VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
-                                              VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+      vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-        vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
-        RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      VkExtent3D extent = c.extent;
 
-        VkExtent3D extent = c.extent;
+      VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
 
-        VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
+      VkFormat fmt = c.format;
+      if(IsStencilOnlyFormat(fmt))
+        aspectFlags = VK_IMAGE_ASPECT_STENCIL_BIT;
+      else if(IsDepthOrStencilFormat(fmt))
+        aspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT;
 
-        VkFormat fmt = c.format;
-        if(IsStencilOnlyFormat(fmt))
-          aspectFlags = VK_IMAGE_ASPECT_STENCIL_BIT;
-        else if(IsDepthOrStencilFormat(fmt))
-          aspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT;
+      VkImageMemoryBarrier dstimBarrier = {
+          VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          NULL,
+          0,
+          0,
+          VK_IMAGE_LAYOUT_UNDEFINED,
+          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+          VK_QUEUE_FAMILY_IGNORED,
+          VK_QUEUE_FAMILY_IGNORED,
+          Unwrap(arrayIm),
+          {aspectFlags, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS}};
 
-        VkImageMemoryBarrier dstimBarrier = {
-            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-            NULL,
-            0,
-            0,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            VK_QUEUE_FAMILY_IGNORED,
-            VK_QUEUE_FAMILY_IGNORED,
-            Unwrap(arrayIm),
-            {aspectFlags, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS}};
+      if(aspectFlags == VK_IMAGE_ASPECT_DEPTH_BIT && !IsDepthOnlyFormat(fmt))
+        dstimBarrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
 
-        if(aspectFlags == VK_IMAGE_ASPECT_DEPTH_BIT && !IsDepthOnlyFormat(fmt))
-          dstimBarrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+      DoPipelineBarrier(cmd, 1, &dstimBarrier);
 
-        DoPipelineBarrier(cmd, 1, &dstimBarrier);
+      VkDeviceSize bufOffset = 0;
 
-        VkDeviceSize bufOffset = 0;
+      // must ensure offset remains valid. Must be multiple of block size, or 4, depending on
+      // format
+      VkDeviceSize bufAlignment = 4;
+      if(IsBlockFormat(fmt))
+        bufAlignment = (VkDeviceSize)GetByteSize(1, 1, 1, fmt, 0);
 
-        // must ensure offset remains valid. Must be multiple of block size, or 4, depending on
-        // format
-        VkDeviceSize bufAlignment = 4;
-        if(IsBlockFormat(fmt))
-          bufAlignment = (VkDeviceSize)GetByteSize(1, 1, 1, fmt, 0);
+      std::vector<VkBufferImageCopy> mainCopies, stencilCopies;
 
-        std::vector<VkBufferImageCopy> mainCopies, stencilCopies;
+      // copy each slice/mip individually
+      for(int a = 0; a < numLayers; a++)
+      {
+        extent = c.extent;
 
-        // copy each slice/mip individually
-        for(int a = 0; a < numLayers; a++)
+        for(int m = 0; m < c.mipLevels; m++)
         {
-          extent = c.extent;
-
-          for(int m = 0; m < c.mipLevels; m++)
-          {
-            VkBufferImageCopy region = {
-                0,
-                0,
-                0,
-                {aspectFlags, (uint32_t)m, (uint32_t)a, 1},
-                {
-                    0, 0, 0,
-                },
-                extent,
-            };
-
-            bufOffset = AlignUp(bufOffset, bufAlignment);
+          VkBufferImageCopy region = {
+              0,
+              0,
+              0,
+              {aspectFlags, (uint32_t)m, (uint32_t)a, 1},
+              {
+                  0, 0, 0,
+              },
+              extent,
+          };
 
-            region.bufferOffset = bufOffset;
+          bufOffset = AlignUp(bufOffset, bufAlignment);
 
-            VkFormat sizeFormat = GetDepthOnlyFormat(fmt);
+          region.bufferOffset = bufOffset;
 
-            // pass 0 for mip since we've already pre-downscaled extent
-            bufOffset += GetByteSize(extent.width, extent.height, extent.depth, sizeFormat, 0);
+          VkFormat sizeFormat = GetDepthOnlyFormat(fmt);
 
-            mainCopies.push_back(region);
+          // pass 0 for mip since we've already pre-downscaled extent
+          bufOffset += GetByteSize(extent.width, extent.height, extent.depth, sizeFormat, 0);
 
-            if(sizeFormat != fmt)
-            {
-              // if we removed stencil from the format, copy that separately now.
-              bufOffset = AlignUp(bufOffset, bufAlignment);
+          mainCopies.push_back(region);
 
-              region.bufferOffset = bufOffset;
-              region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_STENCIL_BIT;
+          if(sizeFormat != fmt)
+          {
+            // if we removed stencil from the format, copy that separately now.
+            bufOffset = AlignUp(bufOffset, bufAlignment);
 
-              bufOffset +=
-                  GetByteSize(extent.width, extent.height, extent.depth, VK_FORMAT_S8_UINT, 0);
+            region.bufferOffset = bufOffset;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_STENCIL_BIT;
 
-              stencilCopies.push_back(region);
-            }
+            bufOffset +=
+                GetByteSize(extent.width, extent.height, extent.depth, VK_FORMAT_S8_UINT, 0);
 
-            // update the extent for the next mip
-            extent.width = RDCMAX(extent.width >> 1, 1U);
-            extent.height = RDCMAX(extent.height >> 1, 1U);
-            extent.depth = RDCMAX(extent.depth >> 1, 1U);
+            stencilCopies.push_back(region);
           }
-        }
 
-        if(!stencilCopies.empty())
-          ObjDisp(cmd)->CmdCopyBufferToImage(Unwrap(cmd), Unwrap(buf), Unwrap(arrayIm),
-                                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                             (uint32_t)stencilCopies.size(), &stencilCopies[0]);
+          // update the extent for the next mip
+          extent.width = RDCMAX(extent.width >> 1, 1U);
+          extent.height = RDCMAX(extent.height >> 1, 1U);
+          extent.depth = RDCMAX(extent.depth >> 1, 1U);
+        }
+      }
 
+      if(!stencilCopies.empty())
         ObjDisp(cmd)->CmdCopyBufferToImage(Unwrap(cmd), Unwrap(buf), Unwrap(arrayIm),
                                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                           (uint32_t)mainCopies.size(), &mainCopies[0]);
+                                           (uint32_t)stencilCopies.size(), &stencilCopies[0]);
 
-        // once transfers complete, get ready for copy array->ms
-        dstimBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        dstimBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        dstimBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        dstimBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+      ObjDisp(cmd)->CmdCopyBufferToImage(Unwrap(cmd), Unwrap(buf), Unwrap(arrayIm),
+                                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                         (uint32_t)mainCopies.size(), &mainCopies[0]);
 
-        DoPipelineBarrier(cmd, 1, &dstimBarrier);
+      // once transfers complete, get ready for copy array->ms
+      dstimBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      dstimBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      dstimBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      dstimBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-        vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
-        RDCASSERTEQUAL(vkr, VK_SUCCESS);
+      DoPipelineBarrier(cmd, 1, &dstimBarrier);
 
-        // INITSTATEBATCH
-        SubmitCmds();
-        FlushQ();
+      vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-        vkDestroyBuffer(d, buf, NULL);
-        vkFreeMemory(d, uploadmem, NULL);
+      // INITSTATEBATCH
+      SubmitCmds();
+      FlushQ();
 
-        m_CleanupMems.push_back(arrayMem);
-        initial.resource = GetWrapped(arrayIm);
-      }
+      vkDestroyBuffer(d, buf, NULL);
+      vkFreeMemory(d, uploadmem, NULL);
+
+      m_CleanupMems.push_back(arrayMem);
+      initial.resource = GetWrapped(arrayIm);
 
       GetResourceManager()->SetInitialContents(id, initial);
     }
@@ -1892,8 +2165,29 @@ bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
       (void)isSparse;
       RDCASSERT(!isSparse);
 
+      bool partial = false;
+
+      if(GetLogVersion() >= 0x0000008)
+        m_pSerialiser->Serialise("partial", partial);
+
+      VkBufferCopy *regions = NULL;
+      uint32_t numRegions = 0;
       uint32_t dataSize = 0;
-      m_pSerialiser->Serialise("dataSize", dataSize);
+
+      if(partial)
+      {
+        m_pSerialiser->SerialisePODArray("regions", regions, numRegions);
+
+        // nothing bound to this memory was used in the frame
+        if(numRegions == 0)
+          return true;
+
+        dataSize = uint32_t(regions[numRegions - 1].srcOffset + regions[numRegions - 1].size);
+      }
+      else
+      {
+        m_pSerialiser->Serialise("dataSize", dataSize);
+      }
 
       VkResult vkr = VK_SUCCESS;
 
@@ -1936,15 +2230,40 @@ bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
       byte *ptr = NULL;
       ObjDisp(d)->MapMemory(Unwrap(d), Unwrap(mem), 0, VK_WHOLE_SIZE, 0, (void **)&ptr);
 
-      size_t dummy = 0;
-      m_pSerialiser->SerialiseBuffer("data", ptr, dummy);
+      if(partial)
+      {
+        for(uint32_t i = 0; i < numRegions; i++)
+        {
+          byte *data = ptr + regions[i].srcOffset;
+          size_t dummy = 0;
+          m_pSerialiser->SerialiseBuffer("data", data, dummy);
+        }
+      }
+      else
+      {
+        size_t dummy = 0;
+        m_pSerialiser->SerialiseBuffer("data", ptr, dummy);
+      }
 
       ObjDisp(d)->UnmapMemory(Unwrap(d), Unwrap(mem));
 
       m_CleanupMems.push_back(mem);
 
-      GetResourceManager()->SetInitialContents(
-          id, VulkanResourceManager::InitialContentData(GetWrapped(buf), (uint32_t)dataSize, NULL));
+      if(partial)
+      {
+        // the blob holds the regions to copy into the memory, num is how many
+        byte *blob = Serialiser::AllocAlignedBuffer(sizeof(VkBufferCopy) * numRegions);
+        memcpy(blob, regions, sizeof(VkBufferCopy) * numRegions);
+        SAFE_DELETE_ARRAY(regions);
+
+        GetResourceManager()->SetInitialContents(
+            id, VulkanResourceManager::InitialContentData(GetWrapped(buf), numRegions, blob));
+      }
+      else
+      {
+        GetResourceManager()->SetInitialContents(
+            id, VulkanResourceManager::InitialContentData(GetWrapped(buf), dataSize, NULL));
+      }
     }
     else
     {
@@ -1955,6 +2274,172 @@ bool WrappedVulkan::Serialise_InitialState(ResourceId resid, WrappedVkRes *)
   return true;
 }
 
+void WrappedVulkan::LoadDeferredImageContents(ResourceId liveid)
+{
+  ResourceId id = GetResourceManager()->GetOriginalID(liveid);
+
+  auto it = m_DeferredImageContents.find(id);
+
+  if(it == m_DeferredImageContents.end())
+    return;
+
+  byte *data = it->second.first;
+  uint32_t dataSize = it->second.second;
+
+  m_DeferredImageContents.erase(it);
+
+  VkResult vkr = VK_SUCCESS;
+
+  VkDevice d = GetDev();
+
+  VkBufferCreateInfo bufInfo = {
+      VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      NULL,
+      0,
+      dataSize,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+  };
+
+  VkBuffer buf;
+  VkDeviceMemory uploadmem = VK_NULL_HANDLE;
+
+  vkr = ObjDisp(d)->CreateBuffer(Unwrap(d), &bufInfo, NULL, &buf);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  GetResourceManager()->WrapResource(Unwrap(d), buf);
+
+  VkMemoryRequirements mrq = {0};
+
+  ObjDisp(d)->GetBufferMemoryRequirements(Unwrap(d), Unwrap(buf), &mrq);
+
+  VkMemoryAllocateInfo allocInfo = {
+      VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
+      GetUploadMemoryIndex(mrq.memoryTypeBits),
+  };
+
+  vkr = ObjDisp(d)->AllocateMemory(Unwrap(d), &allocInfo, NULL, &uploadmem);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  GetResourceManager()->WrapResource(Unwrap(d), uploadmem);
+
+  vkr = ObjDisp(d)->BindBufferMemory(Unwrap(d), Unwrap(buf), Unwrap(uploadmem), 0);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  byte *ptr = NULL;
+  ObjDisp(d)->MapMemory(Unwrap(d), Unwrap(uploadmem), 0, VK_WHOLE_SIZE, 0, (void **)&ptr);
+
+  memcpy(ptr, data, dataSize);
+
+  ObjDisp(d)->UnmapMemory(Unwrap(d), Unwrap(uploadmem));
+
+  Serialiser::FreeAlignedBuffer(data);
+
+  // remember to free this memory on shutdown
+  m_CleanupMems.push_back(uploadmem);
+
+  VulkanResourceManager::InitialContentData initial(GetWrapped(buf), 0, NULL);
+
+  GetResourceManager()->SetInitialContents(id, initial);
+
+  // from now on it's applied along with everything else, but it may have missed the last apply
+  Apply_InitialState(GetResourceManager()->GetLiveResource(id), initial);
+
+  SubmitCmds();
+}
+
+// conservatively, anything that isn't a plain read. Barriers can change an image's layout in place
+static bool CanModifyMemory(ResourceUsage usage)
+{
+  return IsWriteUsage(usage) || usage == ResourceUsage::Barrier || usage == ResourceUsage::Unused;
+}
+
+void WrappedVulkan::LoadUsedImageContents()
+{
+  if(m_DeferredImageContents.empty())
+    return;
+
+  // images the frame uses are loaded now. So is every image whose memory the frame can write
+  // through any resource or from the host, since writes through aliased resources don't record a
+  // use on the image. What's left can't change during the frame, so whenever it's first inspected
+  // its initial contents are also its contents at the current event.
+  std::set<ResourceId> used;
+  std::set<ResourceId> writtenMem;
+
+  for(auto it = m_CreationInfo.m_Framebuffer.begin(); it != m_CreationInfo.m_Framebuffer.end();
+      ++it)
+  {
+    for(size_t a = 0; a < it->second.attachments.size(); a++)
+    {
+      ResourceId image = m_CreationInfo.m_ImageView[it->second.attachments[a].view].image;
+      used.insert(image);
+      writtenMem.insert(m_CreationInfo.m_Image[image].memory);
+    }
+  }
+
+  for(auto it = m_ResourceUses.begin(); it != m_ResourceUses.end(); ++it)
+  {
+    used.insert(it->first);
+
+    bool modifies = false;
+    for(size_t u = 0; u < it->second.size(); u++)
+      modifies |= CanModifyMemory(it->second[u].usage);
+
+    if(!modifies)
+      continue;
+
+    auto buf = m_CreationInfo.m_Buffer.find(it->first);
+    if(buf != m_CreationInfo.m_Buffer.end())
+      writtenMem.insert(buf->second.memory);
+
+    auto img = m_CreationInfo.m_Image.find(it->first);
+    if(img != m_CreationInfo.m_Image.end())
+      writtenMem.insert(img->second.memory);
+  }
+
+  for(auto it = m_FrameBufferWrites.begin(); it != m_FrameBufferWrites.end(); ++it)
+  {
+    auto buf = m_CreationInfo.m_Buffer.find(*it);
+    if(buf != m_CreationInfo.m_Buffer.end())
+      writtenMem.insert(buf->second.memory);
+  }
+
+  for(auto it = m_FrameHostWrites.begin(); it != m_FrameHostWrites.end(); ++it)
+    writtenMem.insert(it->first);
+
+  // from resources that were never bound
+  writtenMem.erase(ResourceId());
+
+  vector<ResourceId> load;
+  uint64_t deferredBytes = 0;
+
+  for(auto it = m_DeferredImageContents.begin(); it != m_DeferredImageContents.end(); ++it)
+  {
+    ResourceId liveid = GetResourceManager()->GetLiveID(it->first);
+
+    if(used.find(liveid) != used.end() ||
+       writtenMem.find(m_CreationInfo.m_Image[liveid].memory) != writtenMem.end())
+      load.push_back(liveid);
+    else
+      deferredBytes += it->second.second;
+  }
+
+  RDCDEBUG("Uploading initial contents for %u of %u images, deferring the rest (%llu bytes)",
+           (uint32_t)load.size(), (uint32_t)m_DeferredImageContents.size(), deferredBytes);
+
+  for(size_t i = 0; i < load.size(); i++)
+    LoadDeferredImageContents(load[i]);
+
+  SubmitCmds();
+  FlushQ();
+}
+
+VkImage WrappedVulkan::GetInspectedImage(ResourceId liveid)
+{
+  LoadDeferredImageContents(liveid);
+
+  return GetResourceManager()->GetCurrentHandle<VkImage>(liveid);
+}
+
 void WrappedVulkan::Create_InitialState(ResourceId id, WrappedVkRes *live, bool hasData)
 {
   VkResourceType type = IdentifyTypeByPtr(live);
@@ -2444,9 +2929,18 @@ void WrappedVulkan::Apply_InitialState(WrappedVkRes *live,
 
     VkBuffer dstBuf = m_CreationInfo.m_Memory[id].wholeMemBuf;
 
-    VkBufferCopy region = {0, dstMemOffs, datasize};
+    if(initial.blob)
+    {
+      // only the bound ranges used in the frame were saved
+      ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf), initial.num,
+                                  (VkBufferCopy *)initial.blob);
+    }
+    else
+    {
+      VkBufferCopy region = {0, dstMemOffs, datasize};
 
-    ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf), 1, &region);
+      ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(srcBuf), Unwrap(dstBuf), 1, &region);
+    }
 
     vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
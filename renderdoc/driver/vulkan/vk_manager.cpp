@@ -49,6 +49,30 @@ bool VulkanResourceManager::SerialisableResource(ResourceId id, VkResourceRecord
 #define TRDBG(...)
 #endif
 
+// once an image has been split into one state per subresource, collapse it back to a single
+// whole-image state if every subresource has converged on the same layout. This keeps the
+// tracking for large array textures bounded instead of it growing to layers * mips entries for
+// the rest of the image's lifetime after a single partial barrier.
+static void MergeSubresourceStates(ImageLayouts &layouts)
+{
+  if(layouts.subresourceStates.size() <= 1 ||
+     layouts.subresourceStates.size() != size_t(layouts.layerCount * layouts.levelCount))
+    return;
+
+  VkImageLayout layout = layouts.subresourceStates[0].newLayout;
+
+  for(size_t i = 1; i < layouts.subresourceStates.size(); i++)
+    if(layouts.subresourceStates[i].newLayout != layout)
+      return;
+
+  layouts.subresourceStates.erase(layouts.subresourceStates.begin() + 1,
+                                  layouts.subresourceStates.end());
+  layouts.subresourceStates[0].subresourceRange.baseArrayLayer = 0;
+  layouts.subresourceStates[0].subresourceRange.baseMipLevel = 0;
+  layouts.subresourceStates[0].subresourceRange.layerCount = layouts.layerCount;
+  layouts.subresourceStates[0].subresourceRange.levelCount = layouts.levelCount;
+}
+
 template <typename SrcBarrierType>
 void VulkanResourceManager::RecordSingleBarrier(vector<pair<ResourceId, ImageRegionState> > &dststates,
                                                 ResourceId id, const SrcBarrierType &t,
@@ -219,22 +243,37 @@ void VulkanResourceManager::RecordBarriers(vector<pair<ResourceId, ImageRegionSt
     uint32_t nummips = t.subresourceRange.levelCount;
     uint32_t numslices = t.subresourceRange.layerCount;
 
-    auto it = layouts.find(id);
-
-    if(nummips == VK_REMAINING_MIP_LEVELS)
+    if(nummips == VK_REMAINING_MIP_LEVELS || numslices == VK_REMAINING_ARRAY_LAYERS)
     {
-      if(it != layouts.end())
-        nummips = it->second.levelCount - t.subresourceRange.baseMipLevel;
-      else
-        nummips = 1;
-    }
+      // while capturing, the image's full range is cached on its record so barriers can be
+      // recorded from any thread without going through the shared layouts map (and its lock).
+      // On replay the map is only touched from the replay thread.
+      uint32_t levelCount = 1, layerCount = 1;
 
-    if(numslices == VK_REMAINING_ARRAY_LAYERS)
-    {
-      if(it != layouts.end())
-        numslices = it->second.layerCount - t.subresourceRange.baseArrayLayer;
+      if(m_State >= WRITING)
+      {
+        VkResourceRecord *record = GetRecord(t.image);
+        if(record)
+        {
+          levelCount = record->viewRange.levelCount;
+          layerCount = record->viewRange.layerCount;
+        }
+      }
       else
-        numslices = 1;
+      {
+        auto it = layouts.find(id);
+        if(it != layouts.end())
+        {
+          levelCount = it->second.levelCount;
+          layerCount = it->second.layerCount;
+        }
+      }
+
+      if(nummips == VK_REMAINING_MIP_LEVELS)
+        nummips = levelCount - t.subresourceRange.baseMipLevel;
+
+      if(numslices == VK_REMAINING_ARRAY_LAYERS)
+        numslices = layerCount - t.subresourceRange.baseArrayLayer;
     }
 
     RecordSingleBarrier(states, id, t, nummips, numslices);
@@ -329,36 +368,7 @@ void VulkanResourceManager::SerialiseImageStates(map<ResourceId, ImageLayouts> &
   // try to merge images that have been split up by subresource but are now all in the same state
   // again.
   for(auto it = states.begin(); it != states.end(); ++it)
-  {
-    ImageLayouts &layouts = it->second;
-
-    if(layouts.subresourceStates.size() > 1 &&
-       layouts.subresourceStates.size() == size_t(layouts.layerCount * layouts.levelCount))
-    {
-      VkImageLayout layout = layouts.subresourceStates[0].newLayout;
-
-      bool allIdentical = true;
-
-      for(size_t i = 0; i < layouts.subresourceStates.size(); i++)
-      {
-        if(layouts.subresourceStates[i].newLayout != layout)
-        {
-          allIdentical = false;
-          break;
-        }
-      }
-
-      if(allIdentical)
-      {
-        layouts.subresourceStates.erase(layouts.subresourceStates.begin() + 1,
-                                        layouts.subresourceStates.end());
-        layouts.subresourceStates[0].subresourceRange.baseArrayLayer = 0;
-        layouts.subresourceStates[0].subresourceRange.baseMipLevel = 0;
-        layouts.subresourceStates[0].subresourceRange.layerCount = layouts.layerCount;
-        layouts.subresourceStates[0].subresourceRange.levelCount = layouts.levelCount;
-      }
-    }
-  }
+    MergeSubresourceStates(it->second);
 }
 
 void VulkanResourceManager::MarkSparseMapReferenced(SparseMapping *sparse)
@@ -403,9 +413,9 @@ void VulkanResourceManager::ApplyBarriers(vector<pair<ResourceId, ImageRegionSta
     uint32_t nummips = t.subresourceRange.levelCount;
     uint32_t numslices = t.subresourceRange.layerCount;
     if(nummips == VK_REMAINING_MIP_LEVELS)
-      nummips = layouts[id].levelCount;
+      nummips = stit->second.levelCount;
     if(numslices == VK_REMAINING_ARRAY_LAYERS)
-      numslices = layouts[id].layerCount;
+      numslices = stit->second.layerCount;
 
     if(nummips == 0)
       nummips = 1;
@@ -564,6 +574,19 @@ void VulkanResourceManager::ApplyBarriers(vector<pair<ResourceId, ImageRegionSta
     if(!done)
       RDCERR("Couldn't find subresource range to apply barrier to - invalid!");
   }
+
+  // states are grouped by ID, so each image's barriers are contiguous. Once they've all been
+  // applied, re-merge any image that has converged back to a single layout.
+  for(size_t ti = 0; ti < states.size(); ti++)
+  {
+    if(ti > 0 && states[ti].first == states[ti - 1].first)
+      continue;
+
+    auto stit = layouts.find(states[ti].first);
+
+    if(stit != layouts.end())
+      MergeSubresourceStates(stit->second);
+  }
 }
 
 bool VulkanResourceManager::Force_InitialState(WrappedVkRes *res, bool prepare)
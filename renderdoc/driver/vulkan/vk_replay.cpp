@@ -623,6 +623,8 @@ VulkanReplay::VulkanReplay()
   m_BindDepth = false;
 
   m_DebugWidth = m_DebugHeight = 1;
+
+  RDCEraseEl(m_CounterQueries);
 }
 
 VulkanDebugManager *VulkanReplay::GetDebugManager()
@@ -757,6 +759,11 @@ vector<DebugMessage> VulkanReplay::GetDebugMessages()
   return m_pDriver->GetDebugMessages();
 }
 
+vector<ChunkProfile> VulkanReplay::GetChunkProfile()
+{
+  return m_pDriver->GetChunkProfile();
+}
+
 vector<ResourceId> VulkanReplay::GetTextures()
 {
   vector<ResourceId> texs;
@@ -1118,13 +1125,14 @@ bool VulkanReplay::RenderTextureInternal(TextureDisplay cfg, VkRenderPassBeginIn
   const bool mipShift = (flags & eTexDisplay_MipShift) != 0;
   const bool f32render = (flags & eTexDisplay_F32Render) != 0;
 
+  VkImage liveIm = m_pDriver->GetInspectedImage(cfg.texid);
+
   VkDevice dev = m_pDriver->GetDev();
   VkCommandBuffer cmd = m_pDriver->GetNextCmd();
   const VkLayerDispatchTable *vt = ObjDisp(dev);
 
   ImageLayouts &layouts = m_pDriver->m_ImageLayouts[cfg.texid];
   VulkanCreationInfo::Image &iminfo = m_pDriver->m_CreationInfo.m_Image[cfg.texid];
-  VkImage liveIm = m_pDriver->GetResourceManager()->GetCurrentHandle<VkImage>(cfg.texid);
 
   VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
 
@@ -3658,13 +3666,14 @@ void VulkanReplay::FillCBufferVariables(ResourceId shader, string entryPoint, ui
 bool VulkanReplay::GetMinMax(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
                              CompType typeHint, float *minval, float *maxval)
 {
+  VkImage liveIm = m_pDriver->GetInspectedImage(texid);
+
   VkDevice dev = m_pDriver->GetDev();
   VkCommandBuffer cmd = m_pDriver->GetNextCmd();
   const VkLayerDispatchTable *vt = ObjDisp(dev);
 
   ImageLayouts &layouts = m_pDriver->m_ImageLayouts[texid];
   VulkanCreationInfo::Image &iminfo = m_pDriver->m_CreationInfo.m_Image[texid];
-  VkImage liveIm = m_pDriver->GetResourceManager()->GetCurrentHandle<VkImage>(texid);
 
   VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
   if(IsStencilOnlyFormat(layouts.format))
@@ -3916,13 +3925,14 @@ bool VulkanReplay::GetHistogram(ResourceId texid, uint32_t sliceFace, uint32_t m
   if(minval >= maxval)
     return false;
 
+  VkImage liveIm = m_pDriver->GetInspectedImage(texid);
+
   VkDevice dev = m_pDriver->GetDev();
   VkCommandBuffer cmd = m_pDriver->GetNextCmd();
   const VkLayerDispatchTable *vt = ObjDisp(dev);
 
   ImageLayouts &layouts = m_pDriver->m_ImageLayouts[texid];
   VulkanCreationInfo::Image &iminfo = m_pDriver->m_CreationInfo.m_Image[texid];
-  VkImage liveIm = m_pDriver->GetResourceManager()->GetCurrentHandle<VkImage>(texid);
 
   VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
   if(IsStencilOnlyFormat(layouts.format))
@@ -4256,7 +4266,7 @@ byte *VulkanReplay::GetTextureData(ResourceId tex, uint32_t arrayIdx, uint32_t m
       (layouts.subresourceStates[0].subresourceRange.aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT) != 0;
   VkImageAspectFlags srcAspectMask = layouts.subresourceStates[0].subresourceRange.aspectMask;
 
-  VkImage srcImage = Unwrap(GetResourceManager()->GetCurrentHandle<VkImage>(tex));
+  VkImage srcImage = Unwrap(m_pDriver->GetInspectedImage(tex));
   VkImage tmpImage = VK_NULL_HANDLE;
   VkDeviceMemory tmpMemory = VK_NULL_HANDLE;
 
@@ -5136,11 +5146,16 @@ void VulkanReplay::BuildTargetShader(string source, string entry, const uint32_t
 void VulkanReplay::ReplaceResource(ResourceId from, ResourceId to)
 {
   GetDebugManager()->ReplaceResource(from, to);
+
+  // anything replayed with the old shader is stale now
+  m_pDriver->FreeCheckpoints();
 }
 
 void VulkanReplay::RemoveReplacement(ResourceId id)
 {
   GetDebugManager()->RemoveReplacement(id);
+
+  m_pDriver->FreeCheckpoints();
 }
 
 void VulkanReplay::FreeTargetResource(ResourceId id)
@@ -148,6 +148,7 @@ public:
 
   FrameRecord GetFrameRecord();
   vector<DebugMessage> GetDebugMessages();
+  vector<ChunkProfile> GetChunkProfile();
 
   void SavePipelineState();
   D3D11Pipe::State GetD3D11PipelineState() { return D3D11Pipe::State(); }
@@ -181,6 +182,7 @@ public:
   vector<GPUCounter> EnumerateCounters();
   void DescribeCounter(GPUCounter counterID, CounterDescription &desc);
   vector<CounterResult> FetchCounters(const vector<GPUCounter> &counters);
+  double GetIsolatedDuration(uint32_t eventID);
 
   bool GetMinMax(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
                  CompType typeHint, float *minval, float *maxval);
@@ -326,6 +328,19 @@ private:
 
   HighlightCache m_HighlightCache;
 
+  // query pools for FetchCounters, kept between calls and only recreated when they're too small
+  // for the frame or a different set of pipeline statistics is needed
+  struct CounterQueryPools
+  {
+    VkQueryPool timeStamp;
+    VkQueryPool occlusion;
+    VkQueryPool pipeStats;
+    VkQueryPipelineStatisticFlags pipeStatsFlags;
+    uint32_t size;
+    // pair of timestamps used by GetIsolatedDuration
+    VkQueryPool isolated;
+  } m_CounterQueries;
+
   bool m_Proxy;
 
   WrappedVulkan *m_pDriver;
@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <unordered_map>
 #include "common/wrapped_pool.h"
 #include "core/resource_manager.h"
 #include "vk_common.h"
@@ -902,10 +903,82 @@ struct CmdBufferRecordingInfo
   set<VkDescriptorSet> boundDescSets;
 
   vector<VkResourceRecord *> subcmds;
+
+  // chunk data recorded into this command buffer, allocated from the command pool's pages. It's
+  // swapped along with the chunks when baking, and recycled when the baked commands are freed.
+  ChunkArena alloc;
 };
 
 struct DescSetLayout;
 
+// contains the framerefs (ref counted) for the resources bound in a descriptor set's slots.
+// Updated when updating descriptor sets and then applied in a block on queue submit.
+//
+// Each distinct resource gets a dense index into a flat array of refs, which is re-used once its
+// refcount drops to zero. Every descriptor slot stores the indices it holds, so overwriting a
+// slot releases its refs without looking anything up. Refs with write access are also kept in
+// their own list so that dirtying only needs to visit those.
+struct DescSetBindRefs
+{
+  DescSetBindRefs() : numSlots(0) {}
+
+  static const uint32_t NoRef = ~0U;
+
+  // a slot refs at most a view or buffer, the resource and memory behind it, and a sampler
+  static const uint32_t RefsPerSlot = 4;
+
+  struct Ref
+  {
+    ResourceId id;
+    uint32_t count;
+    FrameRefType ref;
+    bool sparse;
+    uint32_t writeIdx;
+  };
+
+  // record where each binding's slots start in the layout. The slot storage itself isn't
+  // allocated until the first time a slot is written, since many sets are never updated while
+  // capturing.
+  void Init(const DescSetLayout &layout);
+
+  uint32_t *GetSlotRefs(uint32_t binding, uint32_t arrayElement)
+  {
+    if(slotRefs.empty())
+      slotRefs.assign(numSlots * RefsPerSlot, NoRef);
+
+    return &slotRefs[(bindingOffsets[binding] + arrayElement) * RefsPerSlot];
+  }
+
+  void AddSlotRef(uint32_t *slot, ResourceId id, FrameRefType ref, bool sparse = false);
+  void ReleaseSlot(uint32_t *slot);
+
+  // all refs, including unused ones with a count of 0
+  vector<Ref> refs;
+  // indices of refs with write access, ie. those that dirty their resource when bound
+  vector<uint32_t> writeRefs;
+
+private:
+  uint32_t AddRef(ResourceId id, FrameRefType ref, bool sparse);
+  void ReleaseRef(uint32_t idx);
+
+  struct IdHash
+  {
+    size_t operator()(const ResourceId &id) const
+    {
+      RDCCOMPILE_ASSERT(sizeof(id) == sizeof(uint64_t),
+                        "ResourceId is no longer 1:1 with uint64_t");
+      return std::hash<uint64_t>()((const uint64_t &)id);
+    }
+  };
+
+  std::unordered_map<ResourceId, uint32_t, IdHash> lookup;
+  vector<uint32_t> freeRefs;
+
+  uint32_t numSlots;
+  vector<uint32_t> bindingOffsets;
+  vector<uint32_t> slotRefs;
+};
+
 struct DescriptorSetData
 {
   DescriptorSetData() : layout(NULL) {}
@@ -922,13 +995,15 @@ struct DescriptorSetData
   // create from the layout.
   vector<DescriptorSetSlot *> descBindings;
 
-  // contains the framerefs (ref counted) for the bound resources
-  // in the binding slots. Updated when updating descriptor sets
-  // and then applied in a block on descriptor set bind.
-  // the refcount has the high-bit set if this resource has sparse
-  // mapping information
-  static const uint32_t SPARSE_REF_BIT = 0x80000000;
-  map<ResourceId, pair<uint32_t, FrameRefType> > bindFrameRefs;
+  // only filled out while capturing
+  DescSetBindRefs bindRefs;
+};
+
+// a buffer, image or buffer view that accesses a range of a memory allocation
+struct MemoryBinding
+{
+  ResourceId resource;
+  VkDeviceSize offset, size;
 };
 
 struct MemMapState
@@ -940,7 +1015,9 @@ struct MemMapState
         mapFlushed(false),
         mapCoherent(false),
         mappedPtr(NULL),
-        refData(NULL)
+        refData(NULL),
+        writeWatch(NULL),
+        sparseBound(false)
   {
   }
   VkDeviceSize mapOffset, mapSize;
@@ -949,6 +1026,15 @@ struct MemMapState
   bool mapCoherent;
   byte *mappedPtr;
   byte *refData;
+  // if the TrackMapWrites option is enabled and supported, this tracks which pages of a coherent
+  // map have been written since the last submit, and replaces the refData comparison.
+  WriteWatch::Region *writeWatch;
+
+  // the resources bound to this memory, so large allocations can read back only the ranges
+  // something uses for initial contents. Locked by m_MemBindingsLock. Sparse binds aren't
+  // tracked, they just set sparseBound and the whole allocation is always read back
+  vector<MemoryBinding> bindings;
+  bool sparseBound;
 };
 
 struct AttachmentInfo
@@ -960,6 +1046,16 @@ struct AttachmentInfo
   // and subresource range are filled in when creating the framebuffer, which is what is
   // used to apply the barrier in EndRenderPass
   VkImageMemoryBarrier barrier;
+
+  // only for render passes, set if the load ops never read the attachment's previous contents
+  bool discardsContents;
+
+  // only for framebuffers, set if the view covers the whole image so a render pass that discards
+  // the attachment with a render area of at least wholeArea overwrites the image completely. The
+  // load ops aren't known until the render pass is begun, as any compatible render pass can be
+  // used with the framebuffer.
+  bool coversWholeImage;
+  VkExtent2D wholeArea;
 };
 
 struct VkResourceRecord : public ResourceRecord
@@ -993,50 +1089,7 @@ public:
     cmdInfo->imgbarriers.swap(bakedCommands->cmdInfo->imgbarriers);
     cmdInfo->subcmds.swap(bakedCommands->cmdInfo->subcmds);
     cmdInfo->sparse.swap(bakedCommands->cmdInfo->sparse);
-  }
-
-  void AddBindFrameRef(ResourceId id, FrameRefType ref, bool hasSparse = false)
-  {
-    if(id == ResourceId())
-    {
-      RDCERR("Unexpected NULL resource ID being added as a bind frame ref");
-      return;
-    }
-
-    if((descInfo->bindFrameRefs[id].first & ~DescriptorSetData::SPARSE_REF_BIT) == 0)
-    {
-      descInfo->bindFrameRefs[id] =
-          std::make_pair(1 | (hasSparse ? DescriptorSetData::SPARSE_REF_BIT : 0), ref);
-    }
-    else
-    {
-      // be conservative - mark refs as read before write if we see a write and a read ref on it
-      if(ref == eFrameRef_Write && descInfo->bindFrameRefs[id].second == eFrameRef_Read)
-        descInfo->bindFrameRefs[id].second = eFrameRef_ReadBeforeWrite;
-      descInfo->bindFrameRefs[id].first++;
-    }
-  }
-
-  void RemoveBindFrameRef(ResourceId id)
-  {
-    // ignore any NULL IDs - probably an object that was
-    // deleted since it was bound.
-    if(id == ResourceId())
-      return;
-
-    auto it = descInfo->bindFrameRefs.find(id);
-
-    // in the case of re-used handles bound to descriptor sets,
-    // it's possible to try and remove a frameref on something we
-    // don't have (which means we'll have a corresponding stale ref)
-    // but this is harmless so we can ignore it.
-    if(it == descInfo->bindFrameRefs.end())
-      return;
-
-    it->second.first--;
-
-    if((it->second.first & ~DescriptorSetData::SPARSE_REF_BIT) == 0)
-      descInfo->bindFrameRefs.erase(it);
+    cmdInfo->alloc.Swap(bakedCommands->cmdInfo->alloc);
   }
 
   // we have a lot of 'cold' data in the resource record, as it can be accessed
@@ -1073,6 +1126,7 @@ public:
     SwapchainInfo *swapInfo;                       // only for swapchains
     MemMapState *memMapState;                      // only for device memory
     CmdBufferRecordingInfo *cmdInfo;               // only for command buffers
+    ChunkPagePool *cmdPoolChunks;                  // only for command pools
     AttachmentInfo *imageAttachments;              // only for framebuffers and render passes
     DescriptorSetData *descInfo;    // only for descriptor sets and descriptor set layouts
   };
@@ -1087,7 +1141,8 @@ public:
   vector<VkResourceRecord *> pooledChildren;
 
   // we only need a couple of bytes to store the view's range,
-  // so just pack/unpack into bitfields
+  // so just pack/unpack into bitfields. Images store their whole
+  // range here too, so barriers can be recorded without the layouts lock
   struct ViewRange
   {
     ViewRange &operator=(const VkImageSubresourceRange &range)
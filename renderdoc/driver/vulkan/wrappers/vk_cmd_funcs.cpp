@@ -361,6 +361,8 @@ VkResult WrappedVulkan::vkCreateCommandPool(VkDevice device,
 
       VkResourceRecord *record = GetResourceManager()->AddResourceRecord(*pCmdPool);
       record->AddChunk(chunk);
+
+      record->cmdPoolChunks = new ChunkPagePool();
     }
     else
     {
@@ -374,12 +376,36 @@ VkResult WrappedVulkan::vkCreateCommandPool(VkDevice device,
 VkResult WrappedVulkan::vkResetCommandPool(VkDevice device, VkCommandPool cmdPool,
                                            VkCommandPoolResetFlags flags)
 {
+  if(m_State >= WRITING)
+  {
+    VkResourceRecord *record = GetRecord(cmdPool);
+
+    // resetting the pool implicitly resets every command buffer allocated from it, so free their
+    // baked commands the same as vkResetCommandBuffer. This hands their chunk pages back to the
+    // pool to be re-used by the next recording.
+    record->LockChunks();
+    for(auto it = record->pooledChildren.begin(); it != record->pooledChildren.end(); ++it)
+    {
+      if((*it)->bakedCommands)
+        (*it)->bakedCommands->Delete(GetResourceManager());
+
+      (*it)->bakedCommands = NULL;
+    }
+    record->UnlockChunks();
+
+    if(flags & VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT)
+      record->cmdPoolChunks->Trim();
+  }
+
   return ObjDisp(device)->ResetCommandPool(Unwrap(device), Unwrap(cmdPool), flags);
 }
 
 void WrappedVulkan::vkTrimCommandPoolKHR(VkDevice device, VkCommandPool commandPool,
                                          VkCommandPoolTrimFlagsKHR flags)
 {
+  if(m_State >= WRITING)
+    GetRecord(commandPool)->cmdPoolChunks->Trim();
+
   return ObjDisp(device)->TrimCommandPoolKHR(Unwrap(device), Unwrap(commandPool), flags);
 }
 
@@ -437,6 +463,7 @@ VkResult WrappedVulkan::vkAllocateCommandBuffers(VkDevice device,
         record->cmdInfo->device = device;
         record->cmdInfo->allocInfo = *pAllocateInfo;
         record->cmdInfo->allocInfo.commandBufferCount = 1;
+        record->cmdInfo->alloc.SetPool(record->pool->cmdPoolChunks);
       }
       else
       {
@@ -487,6 +514,8 @@ bool WrappedVulkan::Serialise_vkBeginCommandBuffer(Serialiser *localSerialiser,
 
     m_BakedCmdBufferInfo[cmdId].level = m_BakedCmdBufferInfo[bakeId].level = allocInfo.level;
     m_BakedCmdBufferInfo[cmdId].beginFlags = m_BakedCmdBufferInfo[bakeId].beginFlags = info.flags;
+    m_BakedCmdBufferInfo[cmdId].beginOffset = m_BakedCmdBufferInfo[bakeId].beginOffset =
+        m_CurChunkOffset;
   }
 
   if(m_State == EXECUTING)
@@ -641,6 +670,7 @@ VkResult WrappedVulkan::vkBeginCommandBuffer(VkCommandBuffer commandBuffer,
 
     record->bakedCommands->cmdInfo->device = record->cmdInfo->device;
     record->bakedCommands->cmdInfo->allocInfo = record->cmdInfo->allocInfo;
+    record->bakedCommands->cmdInfo->alloc.SetPool(record->pool->cmdPoolChunks);
 
     {
       CACHE_THREAD_SERIALISER();
@@ -648,7 +678,7 @@ VkResult WrappedVulkan::vkBeginCommandBuffer(VkCommandBuffer commandBuffer,
       SCOPED_SERIALISE_CONTEXT(BEGIN_CMD_BUFFER);
       Serialise_vkBeginCommandBuffer(localSerialiser, commandBuffer, pBeginInfo);
 
-      record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get(record->cmdInfo->alloc));
     }
 
     if(pBeginInfo->pInheritanceInfo)
@@ -791,7 +821,7 @@ VkResult WrappedVulkan::vkEndCommandBuffer(VkCommandBuffer commandBuffer)
       SCOPED_SERIALISE_CONTEXT(END_CMD_BUFFER);
       Serialise_vkEndCommandBuffer(localSerialiser, commandBuffer);
 
-      record->AddChunk(scope.Get());
+      record->AddChunk(scope.Get(record->cmdInfo->alloc));
     }
 
     record->Bake();
@@ -920,10 +950,11 @@ void WrappedVulkan::vkCmdBeginRenderPass(VkCommandBuffer commandBuffer,
     SCOPED_SERIALISE_CONTEXT(BEGIN_RENDERPASS);
     Serialise_vkCmdBeginRenderPass(localSerialiser, commandBuffer, pRenderPassBegin, contents);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     record->MarkResourceFrameReferenced(GetResID(pRenderPassBegin->renderPass), eFrameRef_Read);
 
     VkResourceRecord *fb = GetRecord(pRenderPassBegin->framebuffer);
+    VkResourceRecord *rp = GetRecord(pRenderPassBegin->renderPass);
 
     record->MarkResourceFrameReferenced(fb->GetResourceID(), eFrameRef_Read);
     for(size_t i = 0; i < VkResourceRecord::MaxImageAttachments; i++)
@@ -932,7 +963,18 @@ void WrappedVulkan::vkCmdBeginRenderPass(VkCommandBuffer commandBuffer,
       if(att == NULL)
         break;
 
-      record->MarkResourceFrameReferenced(att->baseResource, eFrameRef_Write);
+      // if the load ops of the render pass being begun discard the attachment, and the render
+      // area covers the whole image, the previous contents are never read
+      const AttachmentInfo &info = fb->imageAttachments[i];
+      const VkRect2D &area = pRenderPassBegin->renderArea;
+
+      if(rp->imageAttachments[i].discardsContents && info.coversWholeImage &&
+         area.offset.x == 0 && area.offset.y == 0 && area.extent.width >= info.wholeArea.width &&
+         area.extent.height >= info.wholeArea.height)
+        record->MarkResourceFrameReferenced(att->baseResource, eFrameRef_CompleteWrite);
+      else
+        record->MarkResourceFrameReferenced(att->baseResource, eFrameRef_Write);
+
       if(att->baseResourceMem != ResourceId())
         record->MarkResourceFrameReferenced(att->baseResourceMem, eFrameRef_Read);
       if(att->sparseInfo)
@@ -1017,7 +1059,7 @@ void WrappedVulkan::vkCmdNextSubpass(VkCommandBuffer commandBuffer, VkSubpassCon
     SCOPED_SERIALISE_CONTEXT(NEXT_SUBPASS);
     Serialise_vkCmdNextSubpass(localSerialiser, commandBuffer, contents);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
   }
 }
 
@@ -1094,7 +1136,7 @@ void WrappedVulkan::vkCmdEndRenderPass(VkCommandBuffer commandBuffer)
     SCOPED_SERIALISE_CONTEXT(END_RENDERPASS);
     Serialise_vkCmdEndRenderPass(localSerialiser, commandBuffer);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     VkResourceRecord *fb = record->cmdInfo->framebuffer;
 
@@ -1109,11 +1151,8 @@ void WrappedVulkan::vkCmdEndRenderPass(VkCommandBuffer commandBuffer)
     }
 
     // apply the implicit layout transitions here
-    {
-      SCOPED_LOCK(m_ImageLayoutsLock);
-      GetResourceManager()->RecordBarriers(GetRecord(commandBuffer)->cmdInfo->imgbarriers,
-                                           m_ImageLayouts, (uint32_t)barriers.size(), &barriers[0]);
-    }
+    GetResourceManager()->RecordBarriers(GetRecord(commandBuffer)->cmdInfo->imgbarriers,
+                                         m_ImageLayouts, (uint32_t)barriers.size(), &barriers[0]);
   }
 }
 
@@ -1222,7 +1261,7 @@ void WrappedVulkan::vkCmdBindPipeline(VkCommandBuffer commandBuffer,
     SCOPED_SERIALISE_CONTEXT(BIND_PIPELINE);
     Serialise_vkCmdBindPipeline(localSerialiser, commandBuffer, pipelineBindPoint, pipeline);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     record->MarkResourceFrameReferenced(GetResID(pipeline), eFrameRef_Read);
   }
 }
@@ -1409,7 +1448,7 @@ void WrappedVulkan::vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer,
                                       firstSet, setCount, pDescriptorSets, dynamicOffsetCount,
                                       pDynamicOffsets);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     record->MarkResourceFrameReferenced(GetResID(layout), eFrameRef_Read);
     record->cmdInfo->boundDescSets.insert(pDescriptorSets, pDescriptorSets + setCount);
 
@@ -1419,17 +1458,13 @@ void WrappedVulkan::vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer,
     // but per Vulkan ethos we consider that the application's problem to solve. Plus,
     // it would mean we'd need to dirty every drawcall instead of just every bind at
     // lower frequency.
+    // Only the writeable refs are visited, which are kept in their own list.
     for(uint32_t i = 0; i < setCount; i++)
     {
-      VkResourceRecord *descSet = GetRecord(pDescriptorSets[i]);
-
-      map<ResourceId, pair<uint32_t, FrameRefType> > &frameRefs = descSet->descInfo->bindFrameRefs;
+      const DescSetBindRefs &bindRefs = GetRecord(pDescriptorSets[i])->descInfo->bindRefs;
 
-      for(auto it = frameRefs.begin(); it != frameRefs.end(); ++it)
-      {
-        if(it->second.second == eFrameRef_Write || it->second.second == eFrameRef_ReadBeforeWrite)
-          record->cmdInfo->dirtied.insert(it->first);
-      }
+      for(size_t w = 0; w < bindRefs.writeRefs.size(); w++)
+        record->cmdInfo->dirtied.insert(bindRefs.refs[bindRefs.writeRefs[w]].id);
     }
   }
 }
@@ -1534,7 +1569,7 @@ void WrappedVulkan::vkCmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32
     Serialise_vkCmdBindVertexBuffers(localSerialiser, commandBuffer, firstBinding, bindingCount,
                                      pBuffers, pOffsets);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     for(uint32_t i = 0; i < bindingCount; i++)
     {
       record->MarkResourceFrameReferenced(GetResID(pBuffers[i]), eFrameRef_Read);
@@ -1607,7 +1642,7 @@ void WrappedVulkan::vkCmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer
     SCOPED_SERIALISE_CONTEXT(BIND_INDEX_BUFFER);
     Serialise_vkCmdBindIndexBuffer(localSerialiser, commandBuffer, buffer, offset, indexType);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     record->MarkResourceFrameReferenced(GetResID(buffer), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(buffer)->baseResource, eFrameRef_Read);
     if(GetRecord(buffer)->sparseInfo)
@@ -1647,6 +1682,9 @@ bool WrappedVulkan::Serialise_vkCmdUpdateBuffer(Serialiser *localSerialiser,
     commandBuffer = GetResourceManager()->GetLiveHandle<VkCommandBuffer>(cmdid);
     destBuffer = GetResourceManager()->GetLiveHandle<VkBuffer>(bufid);
 
+    // no usage is recorded for this write
+    m_FrameBufferWrites.insert(GetResID(destBuffer));
+
     ObjDisp(commandBuffer)
         ->CmdUpdateBuffer(Unwrap(commandBuffer), Unwrap(destBuffer), offs, sz, (uint32_t *)bufdata);
   }
@@ -1676,7 +1714,7 @@ void WrappedVulkan::vkCmdUpdateBuffer(VkCommandBuffer commandBuffer, VkBuffer de
     Serialise_vkCmdUpdateBuffer(localSerialiser, commandBuffer, destBuffer, destOffset, dataSize,
                                 pData);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     VkResourceRecord *buf = GetRecord(destBuffer);
 
@@ -1721,6 +1759,9 @@ bool WrappedVulkan::Serialise_vkCmdFillBuffer(Serialiser *localSerialiser,
     commandBuffer = GetResourceManager()->GetLiveHandle<VkCommandBuffer>(cmdid);
     destBuffer = GetResourceManager()->GetLiveHandle<VkBuffer>(bufid);
 
+    // no usage is recorded for this write
+    m_FrameBufferWrites.insert(GetResID(destBuffer));
+
     ObjDisp(commandBuffer)->CmdFillBuffer(Unwrap(commandBuffer), Unwrap(destBuffer), offs, sz, d);
   }
 
@@ -1744,7 +1785,7 @@ void WrappedVulkan::vkCmdFillBuffer(VkCommandBuffer commandBuffer, VkBuffer dest
     SCOPED_SERIALISE_CONTEXT(FILL_BUF);
     Serialise_vkCmdFillBuffer(localSerialiser, commandBuffer, destBuffer, destOffset, fillSize, data);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     VkResourceRecord *buf = GetRecord(destBuffer);
 
@@ -1822,7 +1863,7 @@ void WrappedVulkan::vkCmdPushConstants(VkCommandBuffer commandBuffer, VkPipeline
     Serialise_vkCmdPushConstants(localSerialiser, commandBuffer, layout, stageFlags, start, length,
                                  values);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     record->MarkResourceFrameReferenced(GetResID(layout), eFrameRef_Read);
   }
 }
@@ -1972,15 +2013,12 @@ void WrappedVulkan::vkCmdPipelineBarrier(
                                    bufferMemoryBarrierCount, pBufferMemoryBarriers,
                                    imageMemoryBarrierCount, pImageMemoryBarriers);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     if(imageMemoryBarrierCount > 0)
-    {
-      SCOPED_LOCK(m_ImageLayoutsLock);
       GetResourceManager()->RecordBarriers(GetRecord(commandBuffer)->cmdInfo->imgbarriers,
                                            m_ImageLayouts, imageMemoryBarrierCount,
                                            pImageMemoryBarriers);
-    }
   }
 }
 
@@ -2038,7 +2076,7 @@ void WrappedVulkan::vkCmdWriteTimestamp(VkCommandBuffer commandBuffer,
     SCOPED_SERIALISE_CONTEXT(WRITE_TIMESTAMP);
     Serialise_vkCmdWriteTimestamp(localSerialiser, commandBuffer, pipelineStage, queryPool, query);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
   }
@@ -2082,6 +2120,9 @@ bool WrappedVulkan::Serialise_vkCmdCopyQueryPoolResults(
     queryPool = GetResourceManager()->GetLiveHandle<VkQueryPool>(qid);
     destBuffer = GetResourceManager()->GetLiveHandle<VkBuffer>(bufid);
 
+    // no usage is recorded for this write
+    m_FrameBufferWrites.insert(GetResID(destBuffer));
+
     ObjDisp(commandBuffer)
         ->CmdCopyQueryPoolResults(Unwrap(commandBuffer), Unwrap(queryPool), first, count,
                                   Unwrap(destBuffer), offs, stride, f);
@@ -2111,7 +2152,7 @@ void WrappedVulkan::vkCmdCopyQueryPoolResults(VkCommandBuffer commandBuffer, VkQ
     Serialise_vkCmdCopyQueryPoolResults(localSerialiser, commandBuffer, queryPool, firstQuery,
                                         queryCount, destBuffer, destOffset, destStride, flags);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
 
     VkResourceRecord *buf = GetRecord(destBuffer);
@@ -2179,7 +2220,7 @@ void WrappedVulkan::vkCmdBeginQuery(VkCommandBuffer commandBuffer, VkQueryPool q
     SCOPED_SERIALISE_CONTEXT(BEGIN_QUERY);
     Serialise_vkCmdBeginQuery(localSerialiser, commandBuffer, queryPool, query, flags);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
   }
 }
@@ -2233,7 +2274,7 @@ void WrappedVulkan::vkCmdEndQuery(VkCommandBuffer commandBuffer, VkQueryPool que
     SCOPED_SERIALISE_CONTEXT(END_QUERY);
     Serialise_vkCmdEndQuery(localSerialiser, commandBuffer, queryPool, query);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
   }
 }
@@ -2291,7 +2332,7 @@ void WrappedVulkan::vkCmdResetQueryPool(VkCommandBuffer commandBuffer, VkQueryPo
     SCOPED_SERIALISE_CONTEXT(RESET_QUERY_POOL);
     Serialise_vkCmdResetQueryPool(localSerialiser, commandBuffer, queryPool, firstQuery, queryCount);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     record->MarkResourceFrameReferenced(GetResID(queryPool), eFrameRef_Read);
   }
 }
@@ -2597,7 +2638,7 @@ void WrappedVulkan::vkCmdExecuteCommands(VkCommandBuffer commandBuffer, uint32_t
     SCOPED_SERIALISE_CONTEXT(EXEC_CMDS);
     Serialise_vkCmdExecuteCommands(localSerialiser, commandBuffer, commandBufferCount, pCmdBuffers);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     for(uint32_t i = 0; i < commandBufferCount; i++)
     {
@@ -2667,7 +2708,7 @@ void WrappedVulkan::vkCmdDebugMarkerBeginEXT(VkCommandBuffer commandBuffer,
     SCOPED_SERIALISE_CONTEXT(BEGIN_EVENT);
     Serialise_vkCmdDebugMarkerBeginEXT(localSerialiser, commandBuffer, pMarker);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
   }
 }
 
@@ -2716,7 +2757,7 @@ void WrappedVulkan::vkCmdDebugMarkerEndEXT(VkCommandBuffer commandBuffer)
     SCOPED_SERIALISE_CONTEXT(END_EVENT);
     Serialise_vkCmdDebugMarkerEndEXT(localSerialiser, commandBuffer);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
   }
 }
 
@@ -2769,6 +2810,6 @@ void WrappedVulkan::vkCmdDebugMarkerInsertEXT(VkCommandBuffer commandBuffer,
     SCOPED_SERIALISE_CONTEXT(SET_MARKER);
     Serialise_vkCmdDebugMarkerInsertEXT(localSerialiser, commandBuffer, pMarker);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
   }
 }
@@ -335,6 +335,7 @@ VkResult WrappedVulkan::vkAllocateDescriptorSets(VkDevice device,
       record->descInfo = new DescriptorSetData();
       record->descInfo->layout = layoutRecord->descInfo->layout;
       record->descInfo->layout->CreateBindingsArray(record->descInfo->descBindings);
+      record->descInfo->bindRefs.Init(*record->descInfo->layout);
     }
     else
     {
@@ -381,6 +382,45 @@ VkResult WrappedVulkan::vkResetDescriptorPool(VkDevice device, VkDescriptorPool
   return ObjDisp(device)->ResetDescriptorPool(Unwrap(device), Unwrap(descriptorPool), flags);
 }
 
+// add the frame refs for everything bound in a descriptor slot. ref is the access for the
+// underlying resource or memory, the views and samplers themselves are only ever read.
+static void AddSlotFrameRefs(DescSetBindRefs &bindRefs, uint32_t *slotRefs,
+                             const DescriptorSetSlot &bind, FrameRefType ref)
+{
+  if(bind.texelBufferView != VK_NULL_HANDLE)
+  {
+    VkResourceRecord *viewRecord = GetRecord(bind.texelBufferView);
+
+    bindRefs.AddSlotRef(slotRefs, GetResID(bind.texelBufferView), eFrameRef_Read,
+                        viewRecord->sparseInfo != NULL);
+    if(viewRecord->baseResource != ResourceId())
+      bindRefs.AddSlotRef(slotRefs, viewRecord->baseResource, ref);
+  }
+  if(bind.imageInfo.imageView != VK_NULL_HANDLE)
+  {
+    VkResourceRecord *viewRecord = GetRecord(bind.imageInfo.imageView);
+
+    bindRefs.AddSlotRef(slotRefs, GetResID(bind.imageInfo.imageView), eFrameRef_Read,
+                        viewRecord->sparseInfo != NULL);
+    bindRefs.AddSlotRef(slotRefs, viewRecord->baseResource, ref);
+    if(viewRecord->baseResourceMem != ResourceId())
+      bindRefs.AddSlotRef(slotRefs, viewRecord->baseResourceMem, eFrameRef_Read);
+  }
+  if(bind.imageInfo.sampler != VK_NULL_HANDLE)
+  {
+    bindRefs.AddSlotRef(slotRefs, GetResID(bind.imageInfo.sampler), eFrameRef_Read);
+  }
+  if(bind.bufferInfo.buffer != VK_NULL_HANDLE)
+  {
+    VkResourceRecord *bufRecord = GetRecord(bind.bufferInfo.buffer);
+
+    bindRefs.AddSlotRef(slotRefs, GetResID(bind.bufferInfo.buffer), eFrameRef_Read,
+                        bufRecord->sparseInfo != NULL);
+    if(bufRecord->baseResource != ResourceId())
+      bindRefs.AddSlotRef(slotRefs, bufRecord->baseResource, ref);
+  }
+}
+
 bool WrappedVulkan::Serialise_vkUpdateDescriptorSets(Serialiser *localSerialiser, VkDevice device,
                                                      uint32_t writeCount,
                                                      const VkWriteDescriptorSet *pDescriptorWrites,
@@ -760,7 +800,7 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
       // - what refs
       // the source set?).
       // At the same time as ref'ing the source set, we must ref all of its resources (via the
-      // bindFrameRefs).
+      // bindRefs).
       // We just ref all rather than looking at only the copied sets to keep things simple.
       // This does mean a slightly conservative ref'ing if the dest set doesn't end up getting
       // bound, but we only
@@ -774,14 +814,18 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
 
         VkResourceRecord *setrecord = GetRecord(pDescriptorCopies[i].srcSet);
 
-        for(auto refit = setrecord->descInfo->bindFrameRefs.begin();
-            refit != setrecord->descInfo->bindFrameRefs.end(); ++refit)
+        const vector<DescSetBindRefs::Ref> &refs = setrecord->descInfo->bindRefs.refs;
+
+        for(size_t r = 0; r < refs.size(); r++)
         {
-          GetResourceManager()->MarkResourceFrameReferenced(refit->first, refit->second.second);
+          if(refs[r].count == 0)
+            continue;
+
+          GetResourceManager()->MarkResourceFrameReferenced(refs[r].id, refs[r].ref);
 
-          if(refit->second.first & DescriptorSetData::SPARSE_REF_BIT)
+          if(refs[r].sparse)
           {
-            VkResourceRecord *record = GetResourceManager()->GetResourceRecord(refit->first);
+            VkResourceRecord *record = GetResourceManager()->GetResourceRecord(refs[r].id);
 
             GetResourceManager()->MarkSparseMapReferenced(record->sparseInfo);
           }
@@ -836,9 +880,11 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
       // (would need to version handles somehow, but don't have enough bits
       // to do that reliably).
       //
-      // This is handled by RemoveBindFrameRef silently dropping id == ResourceId()
+      // Releasing the old refs doesn't need the handles at all, as each slot remembers the IDs
+      // it added refs for.
 
       // start at the dstArrayElement
+      uint32_t bindIdx = pDescriptorWrites[i].dstBinding;
       uint32_t curIdx = pDescriptorWrites[i].dstArrayElement;
 
       for(uint32_t d = 0; d < pDescriptorWrites[i].descriptorCount; d++, curIdx++)
@@ -858,43 +904,15 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
         {
           layoutBinding++;
           binding++;
+          bindIdx++;
           curIdx = 0;
         }
 
         DescriptorSetSlot &bind = (*binding)[curIdx];
 
-        if(bind.texelBufferView != VK_NULL_HANDLE)
-        {
-          record->RemoveBindFrameRef(GetResID(bind.texelBufferView));
+        uint32_t *slotRefs = record->descInfo->bindRefs.GetSlotRefs(bindIdx, curIdx);
 
-          VkResourceRecord *viewRecord = GetRecord(bind.texelBufferView);
-          if(viewRecord && viewRecord->baseResource != ResourceId())
-            record->RemoveBindFrameRef(viewRecord->baseResource);
-        }
-        if(bind.imageInfo.imageView != VK_NULL_HANDLE)
-        {
-          record->RemoveBindFrameRef(GetResID(bind.imageInfo.imageView));
-
-          VkResourceRecord *viewRecord = GetRecord(bind.imageInfo.imageView);
-          if(viewRecord)
-          {
-            record->RemoveBindFrameRef(viewRecord->baseResource);
-            if(viewRecord->baseResourceMem != ResourceId())
-              record->RemoveBindFrameRef(viewRecord->baseResourceMem);
-          }
-        }
-        if(bind.imageInfo.sampler != VK_NULL_HANDLE)
-        {
-          record->RemoveBindFrameRef(GetResID(bind.imageInfo.sampler));
-        }
-        if(bind.bufferInfo.buffer != VK_NULL_HANDLE)
-        {
-          record->RemoveBindFrameRef(GetResID(bind.bufferInfo.buffer));
-
-          VkResourceRecord *bufRecord = GetRecord(bind.bufferInfo.buffer);
-          if(bufRecord && bufRecord->baseResource != ResourceId())
-            record->RemoveBindFrameRef(bufRecord->baseResource);
-        }
+        record->descInfo->bindRefs.ReleaseSlot(slotRefs);
 
         // NULL everything out now so that we don't accidentally reference an object
         // that was removed already
@@ -928,33 +946,7 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
           bind.bufferInfo = pDescriptorWrites[i].pBufferInfo[d];
         }
 
-        if(bind.texelBufferView != VK_NULL_HANDLE)
-        {
-          record->AddBindFrameRef(GetResID(bind.texelBufferView), eFrameRef_Read,
-                                  GetRecord(bind.texelBufferView)->sparseInfo != NULL);
-          if(GetRecord(bind.texelBufferView)->baseResource != ResourceId())
-            record->AddBindFrameRef(GetRecord(bind.texelBufferView)->baseResource, ref);
-        }
-        if(bind.imageInfo.imageView != VK_NULL_HANDLE)
-        {
-          record->AddBindFrameRef(GetResID(bind.imageInfo.imageView), eFrameRef_Read,
-                                  GetRecord(bind.imageInfo.imageView)->sparseInfo != NULL);
-          record->AddBindFrameRef(GetRecord(bind.imageInfo.imageView)->baseResource, ref);
-          if(GetRecord(bind.imageInfo.imageView)->baseResourceMem != ResourceId())
-            record->AddBindFrameRef(GetRecord(bind.imageInfo.imageView)->baseResourceMem,
-                                    eFrameRef_Read);
-        }
-        if(bind.imageInfo.sampler != VK_NULL_HANDLE)
-        {
-          record->AddBindFrameRef(GetResID(bind.imageInfo.sampler), eFrameRef_Read);
-        }
-        if(bind.bufferInfo.buffer != VK_NULL_HANDLE)
-        {
-          record->AddBindFrameRef(GetResID(bind.bufferInfo.buffer), eFrameRef_Read,
-                                  GetRecord(bind.bufferInfo.buffer)->sparseInfo != NULL);
-          if(GetRecord(bind.bufferInfo.buffer)->baseResource != ResourceId())
-            record->AddBindFrameRef(GetRecord(bind.bufferInfo.buffer)->baseResource, ref);
-        }
+        AddSlotFrameRefs(record->descInfo->bindRefs, slotRefs, bind, ref);
       }
     }
 
@@ -1005,6 +997,7 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
 
       // allow roll-over between consecutive bindings. See above in the plain write case for more
       // explanation
+      uint32_t dstBindIdx = pDescriptorCopies[i].dstBinding;
       uint32_t curSrcIdx = pDescriptorCopies[i].srcArrayElement;
       uint32_t curDstIdx = pDescriptorCopies[i].dstArrayElement;
 
@@ -1014,6 +1007,7 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
         {
           dstlayoutBinding++;
           dstbinding++;
+          dstBindIdx++;
           curDstIdx = 0;
         }
 
@@ -1027,59 +1021,13 @@ void WrappedVulkan::vkUpdateDescriptorSets(VkDevice device, uint32_t writeCount,
 
         DescriptorSetSlot &bind = (*dstbinding)[curDstIdx];
 
-        if(bind.texelBufferView != VK_NULL_HANDLE)
-        {
-          dstrecord->RemoveBindFrameRef(GetResID(bind.texelBufferView));
-          if(GetRecord(bind.texelBufferView)->baseResource != ResourceId())
-            dstrecord->RemoveBindFrameRef(GetRecord(bind.texelBufferView)->baseResource);
-        }
-        if(bind.imageInfo.imageView != VK_NULL_HANDLE)
-        {
-          dstrecord->RemoveBindFrameRef(GetResID(bind.imageInfo.imageView));
-          dstrecord->RemoveBindFrameRef(GetRecord(bind.imageInfo.imageView)->baseResource);
-          if(GetRecord(bind.imageInfo.imageView)->baseResourceMem != ResourceId())
-            dstrecord->RemoveBindFrameRef(GetRecord(bind.imageInfo.imageView)->baseResourceMem);
-        }
-        if(bind.imageInfo.sampler != VK_NULL_HANDLE)
-        {
-          dstrecord->RemoveBindFrameRef(GetResID(bind.imageInfo.sampler));
-        }
-        if(bind.bufferInfo.buffer != VK_NULL_HANDLE)
-        {
-          dstrecord->RemoveBindFrameRef(GetResID(bind.bufferInfo.buffer));
-          if(GetRecord(bind.bufferInfo.buffer)->baseResource != ResourceId())
-            dstrecord->RemoveBindFrameRef(GetRecord(bind.bufferInfo.buffer)->baseResource);
-        }
+        uint32_t *slotRefs = dstrecord->descInfo->bindRefs.GetSlotRefs(dstBindIdx, curDstIdx);
+
+        dstrecord->descInfo->bindRefs.ReleaseSlot(slotRefs);
 
         bind = (*srcbinding)[curSrcIdx];
 
-        if(bind.texelBufferView != VK_NULL_HANDLE)
-        {
-          dstrecord->AddBindFrameRef(GetResID(bind.texelBufferView), eFrameRef_Read,
-                                     GetRecord(bind.texelBufferView)->sparseInfo != NULL);
-          if(GetRecord(bind.texelBufferView)->baseResource != ResourceId())
-            dstrecord->AddBindFrameRef(GetRecord(bind.texelBufferView)->baseResource, ref);
-        }
-        if(bind.imageInfo.imageView != VK_NULL_HANDLE)
-        {
-          dstrecord->AddBindFrameRef(GetResID(bind.imageInfo.imageView), eFrameRef_Read,
-                                     GetRecord(bind.imageInfo.imageView)->sparseInfo != NULL);
-          dstrecord->AddBindFrameRef(GetRecord(bind.imageInfo.imageView)->baseResource, ref);
-          if(GetRecord(bind.imageInfo.imageView)->baseResourceMem != ResourceId())
-            dstrecord->AddBindFrameRef(GetRecord(bind.imageInfo.imageView)->baseResourceMem,
-                                       eFrameRef_Read);
-        }
-        if(bind.imageInfo.sampler != VK_NULL_HANDLE)
-        {
-          dstrecord->AddBindFrameRef(GetResID(bind.imageInfo.sampler), ref);
-        }
-        if(bind.bufferInfo.buffer != VK_NULL_HANDLE)
-        {
-          dstrecord->AddBindFrameRef(GetResID(bind.bufferInfo.buffer), eFrameRef_Read,
-                                     GetRecord(bind.bufferInfo.buffer)->sparseInfo != NULL);
-          if(GetRecord(bind.bufferInfo.buffer)->baseResource != ResourceId())
-            dstrecord->AddBindFrameRef(GetRecord(bind.bufferInfo.buffer)->baseResource, ref);
-        }
+        AddSlotFrameRefs(dstrecord->descInfo->bindRefs, slotRefs, bind, ref);
       }
     }
   }
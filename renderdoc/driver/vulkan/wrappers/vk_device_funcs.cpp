@@ -28,6 +28,8 @@
 // vk_dispatchtables.cpp
 void InitDeviceTable(VkDevice dev, PFN_vkGetDeviceProcAddr gpa);
 void InitInstanceTable(VkInstance inst, PFN_vkGetInstanceProcAddr gpa);
+void DestroyDeviceTable(VkDevice dev);
+void DestroyInstanceTable(VkInstance inst);
 
 // Init/shutdown order:
 //
@@ -438,6 +440,12 @@ void WrappedVulkan::Shutdown()
   // no explicit vkDestroyDevice, we destroy the device here then the instance
 
   // destroy any replay objects that aren't specifically to do with the frame capture
+  FreeCheckpoints();
+
+  for(auto it = m_DeferredImageContents.begin(); it != m_DeferredImageContents.end(); ++it)
+    Serialiser::FreeAlignedBuffer(it->second.first);
+  m_DeferredImageContents.clear();
+
   for(size_t i = 0; i < m_CleanupMems.size(); i++)
   {
     ObjDisp(m_Device)->FreeMemory(Unwrap(m_Device), Unwrap(m_CleanupMems[i]), NULL);
@@ -497,7 +505,12 @@ void WrappedVulkan::vkDestroyInstance(VkInstance instance, const VkAllocationCal
   // the device should already have been destroyed, assuming that the
   // application is well behaved. If not, we just leak.
 
-  ObjDisp(m_Instance)->DestroyInstance(Unwrap(m_Instance), NULL);
+  // the dispatch table's key is read from the object, so the table has to be released while the
+  // object still exists, before the table's function is used to destroy it.
+  PFN_vkDestroyInstance destroyFunc = ObjDisp(m_Instance)->DestroyInstance;
+  DestroyInstanceTable(Unwrap(m_Instance));
+
+  destroyFunc(Unwrap(m_Instance), NULL);
   GetResourceManager()->ReleaseWrappedResource(m_Instance);
 
   RenderDoc::Inst().RemoveDeviceFrameCapturer(LayerDisp(m_Instance));
@@ -1453,6 +1466,11 @@ void WrappedVulkan::vkDestroyDevice(VkDevice device, const VkAllocationCallbacks
   SubmitSemaphores();
   FlushQ();
 
+  // release any initial state readback heaps, in case we're mid-capture
+  FreeInitStateHeaps();
+
+  ShutdownCoherentMapWorkers();
+
   // MULTIDEVICE this function will need to check if the device is the one we
   // used for debugmanager/cmd pool etc, and only remove child queues and
   // resources (instead of doing full resource manager shutdown).
@@ -1492,7 +1510,12 @@ void WrappedVulkan::vkDestroyDevice(VkDevice device, const VkAllocationCallbacks
   // should be deleted by now.
   // If there were any leaks, we will leak them ourselves in vkDestroyInstance
   // rather than try to delete API objects after the device has gone
-  ObjDisp(m_Device)->DestroyDevice(Unwrap(m_Device), pAllocator);
+  // the dispatch table's key is read from the object, so the table has to be released while the
+  // object still exists, before the table's function is used to destroy it.
+  PFN_vkDestroyDevice destroyFunc = ObjDisp(m_Device)->DestroyDevice;
+  DestroyDeviceTable(Unwrap(m_Device));
+
+  destroyFunc(Unwrap(m_Device), pAllocator);
   GetResourceManager()->ReleaseWrappedResource(m_Device);
   m_Device = VK_NULL_HANDLE;
   m_PhysicalDevice = VK_NULL_HANDLE;
@@ -152,7 +152,7 @@ void WrappedVulkan::vkCmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCoun
     Serialise_vkCmdDraw(localSerialiser, commandBuffer, vertexCount, instanceCount, firstVertex,
                         firstInstance);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
   }
 }
 
@@ -251,7 +251,7 @@ void WrappedVulkan::vkCmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t ind
     Serialise_vkCmdDrawIndexed(localSerialiser, commandBuffer, indexCount, instanceCount,
                                firstIndex, vertexOffset, firstInstance);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
   }
 }
 
@@ -521,7 +521,7 @@ void WrappedVulkan::vkCmdDrawIndirect(VkCommandBuffer commandBuffer, VkBuffer bu
     SCOPED_SERIALISE_CONTEXT(DRAW_INDIRECT);
     Serialise_vkCmdDrawIndirect(localSerialiser, commandBuffer, buffer, offset, count, stride);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     record->MarkResourceFrameReferenced(GetResID(buffer), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(buffer)->baseResource, eFrameRef_Read);
@@ -818,7 +818,7 @@ void WrappedVulkan::vkCmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBu
     SCOPED_SERIALISE_CONTEXT(DRAW_INDEXED_INDIRECT);
     Serialise_vkCmdDrawIndexedIndirect(localSerialiser, commandBuffer, buffer, offset, count, stride);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     record->MarkResourceFrameReferenced(GetResID(buffer), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(buffer)->baseResource, eFrameRef_Read);
@@ -901,7 +901,7 @@ void WrappedVulkan::vkCmdDispatch(VkCommandBuffer commandBuffer, uint32_t x, uin
     SCOPED_SERIALISE_CONTEXT(DISPATCH);
     Serialise_vkCmdDispatch(localSerialiser, commandBuffer, x, y, z);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
   }
 }
 
@@ -999,7 +999,7 @@ void WrappedVulkan::vkCmdDispatchIndirect(VkCommandBuffer commandBuffer, VkBuffe
     SCOPED_SERIALISE_CONTEXT(DISPATCH_INDIRECT);
     Serialise_vkCmdDispatchIndirect(localSerialiser, commandBuffer, buffer, offset);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     record->MarkResourceFrameReferenced(GetResID(buffer), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(buffer)->baseResource, eFrameRef_Read);
@@ -1092,7 +1092,7 @@ bool WrappedVulkan::Serialise_vkCmdBlitImage(Serialiser *localSerialiser,
         drawNode.resourceUsage.push_back(std::make_pair(
             GetResID(srcImage), EventUsage(drawNode.draw.eventID, ResourceUsage::ResolveSrc)));
         drawNode.resourceUsage.push_back(std::make_pair(
-            GetResID(destImage), EventUsage(drawNode.draw.eventID, ResourceUsage::ResolveSrc)));
+            GetResID(destImage), EventUsage(drawNode.draw.eventID, ResourceUsage::ResolveDst)));
       }
     }
   }
@@ -1123,7 +1123,7 @@ void WrappedVulkan::vkCmdBlitImage(VkCommandBuffer commandBuffer, VkImage srcIma
     Serialise_vkCmdBlitImage(localSerialiser, commandBuffer, srcImage, srcImageLayout, destImage,
                              destImageLayout, regionCount, pRegions, filter);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
@@ -1250,7 +1250,7 @@ void WrappedVulkan::vkCmdResolveImage(VkCommandBuffer commandBuffer, VkImage src
     Serialise_vkCmdResolveImage(localSerialiser, commandBuffer, srcImage, srcImageLayout, destImage,
                                 destImageLayout, regionCount, pRegions);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
@@ -1377,7 +1377,7 @@ void WrappedVulkan::vkCmdCopyImage(VkCommandBuffer commandBuffer, VkImage srcIma
     Serialise_vkCmdCopyImage(localSerialiser, commandBuffer, srcImage, srcImageLayout, destImage,
                              destImageLayout, regionCount, pRegions);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetResID(destImage), eFrameRef_Write);
@@ -1495,7 +1495,7 @@ void WrappedVulkan::vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuff
     Serialise_vkCmdCopyBufferToImage(localSerialiser, commandBuffer, srcBuffer, destImage,
                                      destImageLayout, regionCount, pRegions);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     record->MarkResourceFrameReferenced(GetResID(srcBuffer), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(srcBuffer)->baseResource, eFrameRef_Read);
@@ -1613,7 +1613,7 @@ void WrappedVulkan::vkCmdCopyImageToBuffer(VkCommandBuffer commandBuffer, VkImag
     Serialise_vkCmdCopyImageToBuffer(localSerialiser, commandBuffer, srcImage, srcImageLayout,
                                      destBuffer, regionCount, pRegions);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     record->MarkResourceFrameReferenced(GetResID(srcImage), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
 
@@ -1739,7 +1739,7 @@ void WrappedVulkan::vkCmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcB
     Serialise_vkCmdCopyBuffer(localSerialiser, commandBuffer, srcBuffer, destBuffer, regionCount,
                               pRegions);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
     record->MarkResourceFrameReferenced(GetResID(srcBuffer), eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetRecord(srcBuffer)->baseResource, eFrameRef_Read);
 
@@ -1757,6 +1757,34 @@ void WrappedVulkan::vkCmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcB
   }
 }
 
+// returns true if one of the ranges covers every subresource and aspect of the image
+static bool ClearCoversImage(VkResourceRecord *record, uint32_t rangeCount,
+                             const VkImageSubresourceRange *pRanges)
+{
+  const VkResourceRecord::ViewRange &whole = record->viewRange;
+
+  for(uint32_t i = 0; i < rangeCount; i++)
+  {
+    const VkImageSubresourceRange &r = pRanges[i];
+
+    if(r.baseMipLevel != 0 || r.baseArrayLayer != 0)
+      continue;
+
+    if((r.aspectMask & whole.aspectMask) != whole.aspectMask)
+      continue;
+
+    if(r.levelCount != VK_REMAINING_MIP_LEVELS && r.levelCount < whole.levelCount)
+      continue;
+
+    if(r.layerCount != VK_REMAINING_ARRAY_LAYERS && r.layerCount < whole.layerCount)
+      continue;
+
+    return true;
+  }
+
+  return false;
+}
+
 bool WrappedVulkan::Serialise_vkCmdClearColorImage(Serialiser *localSerialiser,
                                                    VkCommandBuffer commandBuffer, VkImage image,
                                                    VkImageLayout imageLayout,
@@ -1855,8 +1883,11 @@ void WrappedVulkan::vkCmdClearColorImage(VkCommandBuffer commandBuffer, VkImage
     Serialise_vkCmdClearColorImage(localSerialiser, commandBuffer, image, imageLayout, pColor,
                                    rangeCount, pRanges);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_Write);
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
+    if(ClearCoversImage(GetRecord(image), rangeCount, pRanges))
+      record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_CompleteWrite);
+    else
+      record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_Write);
     record->MarkResourceFrameReferenced(GetRecord(image)->baseResource, eFrameRef_Read);
     if(GetRecord(image)->sparseInfo)
       record->cmdInfo->sparse.insert(GetRecord(image)->sparseInfo);
@@ -1961,8 +1992,11 @@ void WrappedVulkan::vkCmdClearDepthStencilImage(VkCommandBuffer commandBuffer, V
     Serialise_vkCmdClearDepthStencilImage(localSerialiser, commandBuffer, image, imageLayout,
                                           pDepthStencil, rangeCount, pRanges);
 
-    record->AddChunk(scope.Get());
-    record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_Write);
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
+    if(ClearCoversImage(GetRecord(image), rangeCount, pRanges))
+      record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_CompleteWrite);
+    else
+      record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_Write);
     record->MarkResourceFrameReferenced(GetRecord(image)->baseResource, eFrameRef_Read);
     if(GetRecord(image)->sparseInfo)
       record->cmdInfo->sparse.insert(GetRecord(image)->sparseInfo);
@@ -2089,7 +2123,7 @@ void WrappedVulkan::vkCmdClearAttachments(VkCommandBuffer commandBuffer, uint32_
     Serialise_vkCmdClearAttachments(localSerialiser, commandBuffer, attachmentCount, pAttachments,
                                     rectCount, pRects);
 
-    record->AddChunk(scope.Get());
+    record->AddChunk(scope.Get(record->cmdInfo->alloc));
 
     // image/attachments are referenced when the render pass is started and the framebuffer is
     // bound.
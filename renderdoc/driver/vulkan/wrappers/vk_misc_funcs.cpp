@@ -78,8 +78,6 @@ void WrappedVulkan::MakeSubpassLoadRP(VkRenderPassCreateInfo &info,
     ObjDisp(device)->func(Unwrap(device), unwrappedObj, pAllocator);                               \
   }
 
-DESTROY_IMPL(VkBuffer, DestroyBuffer)
-DESTROY_IMPL(VkBufferView, DestroyBufferView)
 DESTROY_IMPL(VkImageView, DestroyImageView)
 DESTROY_IMPL(VkShaderModule, DestroyShaderModule)
 DESTROY_IMPL(VkPipeline, DestroyPipeline)
@@ -133,13 +131,45 @@ void WrappedVulkan::vkDestroySwapchainKHR(VkDevice device, VkSwapchainKHR obj,
   ObjDisp(device)->DestroySwapchainKHR(Unwrap(device), unwrappedObj, pAllocator);
 }
 
-// needs to be separate so we don't erase from m_ImageLayouts in other destroy functions
+// buffers, buffer views and images need to be separate to remove their memory bindings
+void WrappedVulkan::vkDestroyBuffer(VkDevice device, VkBuffer obj,
+                                    const VkAllocationCallbacks *pAllocator)
+{
+  if(obj == VK_NULL_HANDLE)
+    return;
+
+  if(m_State >= WRITING)
+    RemoveMemoryBinding(GetRecord(obj));
+
+  VkBuffer unwrappedObj = Unwrap(obj);
+  GetResourceManager()->ReleaseWrappedResource(obj, true);
+  ObjDisp(device)->DestroyBuffer(Unwrap(device), unwrappedObj, pAllocator);
+}
+
+void WrappedVulkan::vkDestroyBufferView(VkDevice device, VkBufferView obj,
+                                        const VkAllocationCallbacks *pAllocator)
+{
+  if(obj == VK_NULL_HANDLE)
+    return;
+
+  if(m_State >= WRITING)
+    RemoveMemoryBinding(GetRecord(obj));
+
+  VkBufferView unwrappedObj = Unwrap(obj);
+  GetResourceManager()->ReleaseWrappedResource(obj, true);
+  ObjDisp(device)->DestroyBufferView(Unwrap(device), unwrappedObj, pAllocator);
+}
+
+// also needs to be separate so we don't erase from m_ImageLayouts in other destroy functions
 void WrappedVulkan::vkDestroyImage(VkDevice device, VkImage obj,
                                    const VkAllocationCallbacks *pAllocator)
 {
   if(obj == VK_NULL_HANDLE)
     return;
 
+  if(m_State >= WRITING)
+    RemoveMemoryBinding(GetRecord(obj));
+
   {
     SCOPED_LOCK(m_ImageLayoutsLock);
     m_ImageLayouts.erase(GetResID(obj));
@@ -561,6 +591,42 @@ VkResult WrappedVulkan::vkCreateFramebuffer(VkDevice device,
         record->imageAttachments[i].barrier.image =
             GetResourceManager()->GetCurrentHandle<VkImage>(attRecord->baseResource);
         record->imageAttachments[i].barrier.subresourceRange = attRecord->viewRange;
+
+        // the attachment can only be completely overwritten if the view covers the whole image
+        // and the framebuffer covers the whole view. Whether it is depends on the load ops of
+        // the render pass it's begun with, see vkCmdBeginRenderPass
+        {
+          VkResourceRecord *imRecord =
+              GetResourceManager()->GetResourceRecord(attRecord->baseResource);
+
+          VkExtent3D extent = {};
+          {
+            SCOPED_LOCK(m_ImageLayoutsLock);
+            auto it = m_ImageLayouts.find(attRecord->baseResource);
+            if(it != m_ImageLayouts.end())
+              extent = it->second.extent;
+          }
+
+          const VkResourceRecord::ViewRange &view = attRecord->viewRange;
+
+          // a 3D image has a single array layer, but its depth slices are bound as layers so
+          // every slice must be covered
+          uint32_t numLayers = 0;
+          if(imRecord)
+            numLayers = RDCMAX(imRecord->viewRange.layerCount, extent.depth);
+
+          if(imRecord && imRecord->viewRange.levelCount == 1 && view.baseArrayLayer == 0 &&
+             (view.layerCount == VkResourceRecord::ViewRange::SliceMaxValue ||
+              view.layerCount >= numLayers) &&
+             view.aspectMask == imRecord->viewRange.aspectMask &&
+             pCreateInfo->width >= extent.width && pCreateInfo->height >= extent.height &&
+             pCreateInfo->layers >= numLayers)
+          {
+            record->imageAttachments[i].coversWholeImage = true;
+            record->imageAttachments[i].wholeArea.width = extent.width;
+            record->imageAttachments[i].wholeArea.height = extent.height;
+          }
+        }
       }
     }
     else
@@ -729,7 +795,44 @@ VkResult WrappedVulkan::vkCreateRenderPass(VkDevice device, const VkRenderPassCr
         record->imageAttachments[i].barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         record->imageAttachments[i].barrier.oldLayout = pCreateInfo->pAttachments[i].initialLayout;
         record->imageAttachments[i].barrier.newLayout = pCreateInfo->pAttachments[i].finalLayout;
+
+        const VkAttachmentDescription &att = pCreateInfo->pAttachments[i];
+
+        bool discards = att.loadOp != VK_ATTACHMENT_LOAD_OP_LOAD;
+        if(IsStencilFormat(att.format) && att.stencilLoadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+          discards = false;
+
+        record->imageAttachments[i].discardsContents = discards;
       }
+
+      // load ops only happen for attachments that a subpass uses, anything else is preserved
+      bool used[VkResourceRecord::MaxImageAttachments] = {};
+
+      for(uint32_t s = 0; s < pCreateInfo->subpassCount; s++)
+      {
+        const VkSubpassDescription &sub = pCreateInfo->pSubpasses[s];
+
+        for(uint32_t a = 0; a < sub.inputAttachmentCount; a++)
+          if(sub.pInputAttachments[a].attachment < VkResourceRecord::MaxImageAttachments)
+            used[sub.pInputAttachments[a].attachment] = true;
+
+        for(uint32_t a = 0; a < sub.colorAttachmentCount; a++)
+        {
+          if(sub.pColorAttachments[a].attachment < VkResourceRecord::MaxImageAttachments)
+            used[sub.pColorAttachments[a].attachment] = true;
+          if(sub.pResolveAttachments &&
+             sub.pResolveAttachments[a].attachment < VkResourceRecord::MaxImageAttachments)
+            used[sub.pResolveAttachments[a].attachment] = true;
+        }
+
+        if(sub.pDepthStencilAttachment &&
+           sub.pDepthStencilAttachment->attachment < VkResourceRecord::MaxImageAttachments)
+          used[sub.pDepthStencilAttachment->attachment] = true;
+      }
+
+      for(uint32_t i = 0; i < pCreateInfo->attachmentCount; i++)
+        if(!used[i])
+          record->imageAttachments[i].discardsContents = false;
     }
     else
     {
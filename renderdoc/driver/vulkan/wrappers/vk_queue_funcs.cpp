@@ -24,6 +24,188 @@
 
 #include "../vk_core.h"
 
+struct CoherentMapDiff
+{
+  VkResourceRecord *record;
+  size_t diffStart, diffEnd;
+  bool found;
+};
+
+struct CoherentMapDiffJobs
+{
+  CoherentMapDiff *diffs;
+  // indices into diffs, largest mapping first so the biggest comparisons start earliest
+  vector<size_t> order;
+  volatile int32_t next;
+};
+
+static void DoCoherentMapDiffs(void *userData)
+{
+  CoherentMapDiffJobs *jobs = (CoherentMapDiffJobs *)userData;
+
+  for(;;)
+  {
+    int32_t idx = Atomic::Inc32(&jobs->next) - 1;
+    if(idx >= (int32_t)jobs->order.size())
+      break;
+
+    CoherentMapDiff &diff = jobs->diffs[jobs->order[idx]];
+    MemMapState &state = *diff.record->memMapState;
+
+    diff.found = FindDiffRange((byte *)state.mappedPtr, state.refData, (size_t)state.mapSize,
+                               diff.diffStart, diff.diffEnd);
+  }
+}
+
+// long-lived threads that help the submitting thread diff coherent maps. They park on a
+// semaphore between submits so a capture with large coherent maps doesn't pay for thread creation
+// on every vkQueueSubmit.
+class CoherentMapDiffWorkers
+{
+public:
+  CoherentMapDiffWorkers(uint32_t numWorkers)
+  {
+    m_Jobs = NULL;
+    m_Shutdown = 0;
+    m_Start = Threading::Semaphore::Create();
+    m_Done = Threading::Semaphore::Create();
+
+    for(uint32_t i = 0; i < numWorkers; i++)
+    {
+      Threading::ThreadHandle thread = Threading::CreateThread(&WorkerThread, this);
+      if(thread)
+        m_Threads.push_back(thread);
+    }
+  }
+
+  ~CoherentMapDiffWorkers()
+  {
+    Atomic::Inc32(&m_Shutdown);
+    m_Start->Wake((uint32_t)m_Threads.size());
+
+    for(size_t i = 0; i < m_Threads.size(); i++)
+    {
+      Threading::JoinThread(m_Threads[i]);
+      Threading::CloseThread(m_Threads[i]);
+    }
+
+    m_Start->Destroy();
+    m_Done->Destroy();
+  }
+
+  // runs the jobs across the workers and the calling thread. Returns false without doing anything
+  // if another queue is already using the workers, so the caller can diff on its own instead.
+  bool TryRun(CoherentMapDiffJobs &jobs);
+
+private:
+  static void WorkerThread(void *userData);
+
+  Threading::CriticalSection m_Lock;
+  Threading::Semaphore *m_Start;
+  Threading::Semaphore *m_Done;
+  CoherentMapDiffJobs *m_Jobs;
+  volatile int32_t m_Shutdown;
+  vector<Threading::ThreadHandle> m_Threads;
+};
+
+void CoherentMapDiffWorkers::WorkerThread(void *userData)
+{
+  CoherentMapDiffWorkers *workers = (CoherentMapDiffWorkers *)userData;
+
+  for(;;)
+  {
+    workers->m_Start->WaitForWake();
+
+    if(Atomic::CmpExch32(&workers->m_Shutdown, 0, 0) != 0)
+      break;
+
+    DoCoherentMapDiffs(workers->m_Jobs);
+
+    workers->m_Done->Wake(1);
+  }
+}
+
+bool CoherentMapDiffWorkers::TryRun(CoherentMapDiffJobs &jobs)
+{
+  Threading::TryScopedLock lock(m_Lock);
+
+  if(!lock.HasLock())
+    return false;
+
+  // no point waking more workers than there are jobs left after the calling thread takes one
+  uint32_t numWake = RDCMIN((uint32_t)m_Threads.size(), (uint32_t)jobs.order.size() - 1);
+
+  m_Jobs = &jobs;
+  m_Start->Wake(numWake);
+
+  DoCoherentMapDiffs(&jobs);
+
+  for(uint32_t i = 0; i < numWake; i++)
+    m_Done->WaitForWake();
+
+  m_Jobs = NULL;
+
+  return true;
+}
+
+void WrappedVulkan::ShutdownCoherentMapWorkers()
+{
+  SCOPED_LOCK(m_CoherentMapWorkersLock);
+  SAFE_DELETE(m_CoherentMapWorkers);
+}
+
+// compares each mapping that has reference data against it. Work is only handed to the device's
+// worker threads when there is more than one mapping and they total at least MinParallelBytes,
+// anything smaller is diffed on the calling thread.
+void WrappedVulkan::DiffCoherentMaps(vector<CoherentMapDiff> &diffs)
+{
+  // arbitrary cut-off to keep submits with little mapped memory off the workers entirely. It
+  // hasn't been tuned against multi-core timings.
+  static const VkDeviceSize MinParallelBytes = 4 * 1024 * 1024;
+
+  CoherentMapDiffJobs jobs;
+  jobs.diffs = diffs.empty() ? NULL : &diffs[0];
+  jobs.next = 0;
+
+  VkDeviceSize totalBytes = 0;
+
+  for(size_t i = 0; i < diffs.size(); i++)
+  {
+    if(diffs[i].record->memMapState->refData)
+    {
+      jobs.order.push_back(i);
+      totalBytes += diffs[i].record->memMapState->mapSize;
+    }
+  }
+
+  if(jobs.order.size() > 1 && totalBytes >= MinParallelBytes && Threading::NumberOfCores() > 1)
+  {
+    struct LargestFirst
+    {
+      CoherentMapDiff *diffs;
+      bool operator()(size_t a, size_t b) const
+      {
+        return diffs[a].record->memMapState->mapSize > diffs[b].record->memMapState->mapSize;
+      }
+    } largestFirst = {jobs.diffs};
+
+    std::sort(jobs.order.begin(), jobs.order.end(), largestFirst);
+
+    // the workers are created once, the first time a submit is worth splitting up, and live
+    // until the device is destroyed
+    {
+      SCOPED_LOCK(m_CoherentMapWorkersLock);
+      if(m_CoherentMapWorkers == NULL)
+        m_CoherentMapWorkers = new CoherentMapDiffWorkers(Threading::NumberOfCores() - 1);
+    }
+
+    if(m_CoherentMapWorkers->TryRun(jobs))
+      return;
+  }
+
+  DoCoherentMapDiffs(&jobs);
+}
+
 bool WrappedVulkan::Serialise_vkGetDeviceQueue(Serialiser *localSerialiser, VkDevice device,
                                                uint32_t queueFamilyIndex, uint32_t queueIndex,
                                                VkQueue *pQueue)
@@ -258,6 +440,8 @@ bool WrappedVulkan::Serialise_vkQueueSubmit(Serialiser *localSerialiser, VkQueue
     // account for the outer loop thinking we've added one event and incrementing,
     // since we've done all the handling ourselves this will be off by one.
     m_RootEventID--;
+
+    AddCheckpointCandidate(cmdIds);
   }
   else if(m_State == EXECUTING)
   {
@@ -652,15 +836,19 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
 
           VkResourceRecord *setrecord = GetRecord(*it);
 
-          for(auto refit = setrecord->descInfo->bindFrameRefs.begin();
-              refit != setrecord->descInfo->bindFrameRefs.end(); ++refit)
+          const vector<DescSetBindRefs::Ref> &refs = setrecord->descInfo->bindRefs.refs;
+
+          for(size_t r = 0; r < refs.size(); r++)
           {
-            refdIDs.insert(refit->first);
-            GetResourceManager()->MarkResourceFrameReferenced(refit->first, refit->second.second);
+            if(refs[r].count == 0)
+              continue;
 
-            if(refit->second.first & DescriptorSetData::SPARSE_REF_BIT)
+            refdIDs.insert(refs[r].id);
+            GetResourceManager()->MarkResourceFrameReferenced(refs[r].id, refs[r].ref);
+
+            if(refs[r].sparse)
             {
-              VkResourceRecord *sparserecord = GetResourceManager()->GetResourceRecord(refit->first);
+              VkResourceRecord *sparserecord = GetResourceManager()->GetResourceRecord(refs[r].id);
 
               GetResourceManager()->MarkSparseMapReferenced(sparserecord->sparseInfo);
             }
@@ -671,6 +859,34 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
             it != record->bakedCommands->cmdInfo->sparse.end(); ++it)
           GetResourceManager()->MarkSparseMapReferenced(*it);
 
+        vector<VkResourceRecord *> &subcmds = record->bakedCommands->cmdInfo->subcmds;
+
+        // the refs from the primary and its secondaries are added one after the other, which
+        // loses their relative order. A complete write in one doesn't mean another didn't read
+        // the previous contents first, so anything shared is conservatively a partial write
+        if(!subcmds.empty())
+        {
+          std::set<ResourceId> seen, shared, complete;
+
+          for(size_t sub = 0; sub <= subcmds.size(); sub++)
+          {
+            VkResourceRecord *baked =
+                sub == 0 ? record->bakedCommands : subcmds[sub - 1]->bakedCommands;
+
+            std::set<ResourceId> ids;
+            baked->AddReferencedIDs(ids);
+            baked->AddCompleteWriteIDs(complete);
+
+            for(auto it = ids.begin(); it != ids.end(); ++it)
+              if(!seen.insert(*it).second)
+                shared.insert(*it);
+          }
+
+          for(auto it = shared.begin(); it != shared.end(); ++it)
+            if(complete.find(*it) != complete.end())
+              GetResourceManager()->MarkResourceFrameReferenced(*it, eFrameRef_Write);
+        }
+
         // pull in frame refs from this baked command buffer
         record->bakedCommands->AddResourceReferences(GetResourceManager());
         record->bakedCommands->AddReferencedIDs(refdIDs);
@@ -716,6 +932,15 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
       maps = m_CoherentMaps;
     }
 
+    // maps that need to be compared against their reference data. The comparisons are
+    // independent so they can run in parallel, but the flushes are serialised afterwards in the
+    // same order as m_CoherentMaps so the capture is deterministic.
+    vector<CoherentMapDiff> diffs;
+
+    // MULTIDEVICE should find the device for this queue.
+    // MULTIDEVICE only want to flush maps associated with this queue
+    VkDevice dev = GetDev();
+
     for(auto it = maps.begin(); it != maps.end(); ++it)
     {
       VkResourceRecord *record = *it;
@@ -732,8 +957,48 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
           continue;
         }
 
-        size_t diffStart = 0, diffEnd = 0;
-        bool found = true;
+        // if we're tracking writes by page, we know precisely which pages were written since the
+        // last time we looked so we can flush only those without any comparison or shadow copy.
+        if(state.writeWatch)
+        {
+          vector<std::pair<size_t, size_t> > dirtyRanges;
+          WriteWatch::GetDirtyRanges(state.writeWatch, dirtyRanges);
+
+          if(dirtyRanges.empty())
+          {
+            RDCDEBUG("Persistent map flush not needed for %llu", record->GetResourceID());
+            continue;
+          }
+
+          vector<VkMappedMemoryRange> ranges;
+          ranges.reserve(dirtyRanges.size());
+
+          for(size_t r = 0; r < dirtyRanges.size(); r++)
+          {
+            VkMappedMemoryRange range = {
+                VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL,
+                (VkDeviceMemory)(uint64_t)record->Resource,
+                state.mapOffset + dirtyRanges[r].first, dirtyRanges[r].second,
+            };
+            ranges.push_back(range);
+          }
+
+          RDCLOG("Persistent map flush forced for %llu (%u dirty ranges)", record->GetResourceID(),
+                 (uint32_t)ranges.size());
+
+          state.needRefData = false;
+          vkFlushMappedMemoryRanges(dev, (uint32_t)ranges.size(), &ranges[0]);
+          state.mapFlushed = false;
+
+          GetResourceManager()->MarkPendingDirty(record->GetResourceID());
+          continue;
+        }
+
+        CoherentMapDiff diff;
+        diff.record = record;
+        diff.diffStart = 0;
+        diff.diffEnd = 0;
+        diff.found = true;
 
 // enabled as this is necessary for programs with very large coherent mappings
 // (> 1GB) as otherwise more than a couple of vkQueueSubmit calls leads to vast
@@ -758,37 +1023,41 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
         // shouldn't miss anything
         state.needRefData = true;
 
-        // if we have a previous set of data, compare.
+        // if we have a previous set of data, it's compared in DiffCoherentMaps below.
         // otherwise just serialise it all
-        if(state.refData)
-          found = FindDiffRange((byte *)state.mappedPtr, state.refData, (size_t)state.mapSize,
-                                diffStart, diffEnd);
-        else
+        if(!state.refData)
 #endif
-          diffEnd = (size_t)state.mapSize;
+          diff.diffEnd = (size_t)state.mapSize;
 
-        if(found)
-        {
-          // MULTIDEVICE should find the device for this queue.
-          // MULTIDEVICE only want to flush maps associated with this queue
-          VkDevice dev = GetDev();
+        diffs.push_back(diff);
+      }
+    }
 
-          {
-            RDCLOG("Persistent map flush forced for %llu (%llu -> %llu)", record->GetResourceID(),
-                   (uint64_t)diffStart, (uint64_t)diffEnd);
-            VkMappedMemoryRange range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL,
-                                         (VkDeviceMemory)(uint64_t)record->Resource,
-                                         state.mapOffset + diffStart, diffEnd - diffStart};
-            vkFlushMappedMemoryRanges(dev, 1, &range);
-            state.mapFlushed = false;
-          }
+    DiffCoherentMaps(diffs);
 
-          GetResourceManager()->MarkPendingDirty(record->GetResourceID());
-        }
-        else
+    for(size_t i = 0; i < diffs.size(); i++)
+    {
+      VkResourceRecord *record = diffs[i].record;
+      MemMapState &state = *record->memMapState;
+
+      if(diffs[i].found)
+      {
         {
-          RDCDEBUG("Persistent map flush not needed for %llu", record->GetResourceID());
+          RDCLOG("Persistent map flush forced for %llu (%llu -> %llu)", record->GetResourceID(),
+                 (uint64_t)diffs[i].diffStart, (uint64_t)diffs[i].diffEnd);
+          VkMappedMemoryRange range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL,
+                                       (VkDeviceMemory)(uint64_t)record->Resource,
+                                       state.mapOffset + diffs[i].diffStart,
+                                       diffs[i].diffEnd - diffs[i].diffStart};
+          vkFlushMappedMemoryRanges(dev, 1, &range);
+          state.mapFlushed = false;
         }
+
+        GetResourceManager()->MarkPendingDirty(record->GetResourceID());
+      }
+      else
+      {
+        RDCDEBUG("Persistent map flush not needed for %llu", record->GetResourceID());
       }
     }
 
@@ -920,18 +1189,27 @@ VkResult WrappedVulkan::vkQueueBindSparse(VkQueue queue, uint32_t bindInfoCount,
       {
         const VkSparseBufferMemoryBindInfo &bind = pBindInfo[i].pBufferBinds[buf];
         GetRecord(bind.buffer)->sparseInfo->Update(bind.bindCount, bind.pBinds);
+
+        for(uint32_t b = 0; b < bind.bindCount; b++)
+          MarkSparseBound(bind.pBinds[b].memory);
       }
 
       for(uint32_t op = 0; op < pBindInfo[i].imageOpaqueBindCount; op++)
       {
         const VkSparseImageOpaqueMemoryBindInfo &bind = pBindInfo[i].pImageOpaqueBinds[op];
         GetRecord(bind.image)->sparseInfo->Update(bind.bindCount, bind.pBinds);
+
+        for(uint32_t b = 0; b < bind.bindCount; b++)
+          MarkSparseBound(bind.pBinds[b].memory);
       }
 
       for(uint32_t op = 0; op < pBindInfo[i].imageBindCount; op++)
       {
         const VkSparseImageMemoryBindInfo &bind = pBindInfo[i].pImageBinds[op];
         GetRecord(bind.image)->sparseInfo->Update(bind.bindCount, bind.pBinds);
+
+        for(uint32_t b = 0; b < bind.bindCount; b++)
+          MarkSparseBound(bind.pBinds[b].memory);
       }
     }
   }
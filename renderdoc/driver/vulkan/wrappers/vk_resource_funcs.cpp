@@ -419,13 +419,10 @@ VkResult WrappedVulkan::vkAllocateMemory(VkDevice device, const VkMemoryAllocate
       uint32_t memProps =
           m_PhysicalDeviceData.fakeMemProps->memoryTypes[info.memoryTypeIndex].propertyFlags;
 
-      // if memory is not host visible, so not mappable, don't create map state at all
-      if((memProps & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0)
-      {
-        record->memMapState = new MemMapState();
-        record->memMapState->mapCoherent = (memProps & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
-        record->memMapState->refData = NULL;
-      }
+      // all memory gets map state to track its bindings, even if it's not host visible
+      record->memMapState = new MemMapState();
+      record->memMapState->mapCoherent = (memProps & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+      record->memMapState->refData = NULL;
     }
     else
     {
@@ -487,6 +484,12 @@ void WrappedVulkan::vkFreeMemory(VkDevice device, VkDeviceMemory memory,
     if(wrapped->record->memMapState && wrapped->record->memMapState->refData)
       Serialiser::FreeAlignedBuffer(wrapped->record->memMapState->refData);
 
+    if(wrapped->record->memMapState && wrapped->record->memMapState->writeWatch)
+    {
+      WriteWatch::End(wrapped->record->memMapState->writeWatch);
+      wrapped->record->memMapState->writeWatch = NULL;
+    }
+
     {
       SCOPED_LOCK(m_CoherentMapsLock);
 
@@ -536,6 +539,10 @@ VkResult WrappedVulkan::vkMapMemory(VkDevice device, VkDeviceMemory mem, VkDevic
 
       if(state.mapCoherent)
       {
+        if(RenderDoc::Inst().GetCaptureOptions().TrackMapWrites)
+          state.writeWatch = WriteWatch::Begin(
+              realData, size_t(size == VK_WHOLE_SIZE ? memrecord->Length - offset : size));
+
         SCOPED_LOCK(m_CoherentMapsLock);
         m_CoherentMaps.push_back(memrecord);
       }
@@ -572,6 +579,9 @@ bool WrappedVulkan::Serialise_vkUnmapMemory(Serialiser *localSerialiser, VkDevic
     device = GetResourceManager()->GetLiveHandle<VkDevice>(devId);
     mem = GetResourceManager()->GetLiveHandle<VkDeviceMemory>(id);
 
+    if(m_ReadingFrame)
+      m_FrameHostWrites[GetResID(mem)].push_back(std::make_pair(memOffset, memSize));
+
     void *mapPtr = NULL;
     VkResult ret =
         ObjDisp(device)->MapMemory(Unwrap(device), Unwrap(mem), memOffset, memSize, 0, &mapPtr);
@@ -653,6 +663,9 @@ void WrappedVulkan::vkUnmapMemory(VkDevice device, VkDeviceMemory mem)
 
     Serialiser::FreeAlignedBuffer(state.refData);
 
+    WriteWatch::End(state.writeWatch);
+    state.writeWatch = NULL;
+
     if(state.mapCoherent)
     {
       SCOPED_LOCK(m_CoherentMapsLock);
@@ -723,6 +736,9 @@ bool WrappedVulkan::Serialise_vkFlushMappedMemoryRanges(Serialiser *localSeriali
     device = GetResourceManager()->GetLiveHandle<VkDevice>(devId);
     VkDeviceMemory mem = GetResourceManager()->GetLiveHandle<VkDeviceMemory>(id);
 
+    if(m_ReadingFrame)
+      m_FrameHostWrites[GetResID(mem)].push_back(std::make_pair(memOffset, memSize));
+
     void *mapPtr = NULL;
     VkResult ret =
         ObjDisp(device)->MapMemory(Unwrap(device), Unwrap(mem), memOffset, memSize, 0, &mapPtr);
@@ -815,6 +831,82 @@ VkResult WrappedVulkan::vkInvalidateMappedMemoryRanges(VkDevice device, uint32_t
 
 // Generic API object functions
 
+void WrappedVulkan::AddMemoryBinding(VkResourceRecord *record, ResourceId mem,
+                                     VkDeviceSize offset, VkDeviceSize size)
+{
+  VkResourceRecord *memrecord = GetResourceManager()->GetResourceRecord(mem);
+
+  if(memrecord == NULL || memrecord->memMapState == NULL)
+    return;
+
+  MemoryBinding bind = {record->GetResourceID(), offset, size};
+
+  SCOPED_LOCK(m_MemBindingsLock);
+  memrecord->memMapState->bindings.push_back(bind);
+}
+
+void WrappedVulkan::AddMemoryBinding(VkResourceRecord *viewRecord, VkResourceRecord *bufferRecord)
+{
+  // buffer views reference their memory without referencing the buffer, so they get a binding
+  // of their own covering the whole buffer
+  VkResourceRecord *memrecord = GetResourceManager()->GetResourceRecord(bufferRecord->baseResource);
+
+  if(memrecord == NULL || memrecord->memMapState == NULL)
+    return;
+
+  SCOPED_LOCK(m_MemBindingsLock);
+
+  vector<MemoryBinding> &bindings = memrecord->memMapState->bindings;
+
+  for(size_t i = 0; i < bindings.size(); i++)
+  {
+    if(bindings[i].resource == bufferRecord->GetResourceID())
+    {
+      MemoryBinding bind = bindings[i];
+      bind.resource = viewRecord->GetResourceID();
+      bindings.push_back(bind);
+      return;
+    }
+  }
+}
+
+void WrappedVulkan::RemoveMemoryBinding(VkResourceRecord *record)
+{
+  if(record == NULL || record->baseResource == ResourceId())
+    return;
+
+  // if the memory has already been freed there's nothing to remove
+  VkResourceRecord *memrecord = GetResourceManager()->GetResourceRecord(record->baseResource);
+
+  if(memrecord == NULL || memrecord->memMapState == NULL)
+    return;
+
+  SCOPED_LOCK(m_MemBindingsLock);
+
+  vector<MemoryBinding> &bindings = memrecord->memMapState->bindings;
+
+  for(size_t i = 0; i < bindings.size(); i++)
+  {
+    if(bindings[i].resource == record->GetResourceID())
+    {
+      bindings[i] = bindings.back();
+      bindings.pop_back();
+      return;
+    }
+  }
+}
+
+void WrappedVulkan::MarkSparseBound(VkDeviceMemory mem)
+{
+  if(mem == VK_NULL_HANDLE)
+    return;
+
+  VkResourceRecord *memrecord = GetRecord(mem);
+
+  SCOPED_LOCK(m_MemBindingsLock);
+  memrecord->memMapState->sparseBound = true;
+}
+
 bool WrappedVulkan::Serialise_vkBindBufferMemory(Serialiser *localSerialiser, VkDevice device,
                                                  VkBuffer buffer, VkDeviceMemory mem,
                                                  VkDeviceSize memOffset)
@@ -830,6 +922,8 @@ bool WrappedVulkan::Serialise_vkBindBufferMemory(Serialiser *localSerialiser, Vk
     buffer = GetResourceManager()->GetLiveHandle<VkBuffer>(bufId);
     mem = GetResourceManager()->GetLiveHandle<VkDeviceMemory>(memId);
 
+    m_CreationInfo.m_Buffer[GetResID(buffer)].memory = GetResID(mem);
+
     ObjDisp(device)->BindBufferMemory(Unwrap(device), Unwrap(buffer), Unwrap(mem), offs);
   }
 
@@ -861,6 +955,11 @@ VkResult WrappedVulkan::vkBindBufferMemory(VkDevice device, VkBuffer buffer, VkD
 
     record->AddParent(GetRecord(mem));
     record->baseResource = GetResID(mem);
+
+    VkMemoryRequirements mrq = {0};
+    ObjDisp(device)->GetBufferMemoryRequirements(Unwrap(device), Unwrap(buffer), &mrq);
+
+    AddMemoryBinding(record, GetResID(mem), memOffset, mrq.size);
   }
 
   return ObjDisp(device)->BindBufferMemory(Unwrap(device), Unwrap(buffer), Unwrap(mem), memOffset);
@@ -881,6 +980,8 @@ bool WrappedVulkan::Serialise_vkBindImageMemory(Serialiser *localSerialiser, VkD
     image = GetResourceManager()->GetLiveHandle<VkImage>(imgId);
     mem = GetResourceManager()->GetLiveHandle<VkDeviceMemory>(memId);
 
+    m_CreationInfo.m_Image[GetResID(image)].memory = GetResID(mem);
+
     ObjDisp(device)->BindImageMemory(Unwrap(device), Unwrap(image), Unwrap(mem), offs);
   }
 
@@ -916,6 +1017,11 @@ VkResult WrappedVulkan::vkBindImageMemory(VkDevice device, VkImage image, VkDevi
     // Anything that looks up a baseResource for an image knows not to chase further
     // than the image.
     record->baseResource = GetResID(mem);
+
+    VkMemoryRequirements mrq = {0};
+    ObjDisp(device)->GetImageMemoryRequirements(Unwrap(device), Unwrap(image), &mrq);
+
+    AddMemoryBinding(record, GetResID(mem), memOffset, mrq.size);
   }
 
   return ObjDisp(device)->BindImageMemory(Unwrap(device), Unwrap(image), Unwrap(mem), memOffset);
@@ -1104,6 +1210,8 @@ VkResult WrappedVulkan::vkCreateBufferView(VkDevice device, const VkBufferViewCr
       // store the base resource
       record->baseResource = bufferRecord->baseResource;
       record->sparseInfo = bufferRecord->sparseInfo;
+
+      AddMemoryBinding(record, bufferRecord);
     }
     else
     {
@@ -1340,6 +1448,11 @@ VkResult WrappedVulkan::vkCreateImage(VkDevice device, const VkImageCreateInfo *
 
     layout->subresourceStates.push_back(
         ImageRegionState(range, UNKNOWN_PREV_IMG_LAYOUT, VK_IMAGE_LAYOUT_UNDEFINED));
+
+    // the whole image's range, used to resolve VK_REMAINING_* in barriers while recording and to
+    // spot writes that cover the whole image
+    if(m_State >= WRITING)
+      GetRecord(*pImage)->viewRange = range;
   }
 
   return ret;
@@ -532,6 +532,8 @@ void WrappedVulkan::WrapAndProcessCreatedSwapchain(VkDevice device,
         range.layerCount = pCreateInfo->imageArrayLayers;
         range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 
+        GetRecord(images[i])->viewRange = range;
+
         // fill out image info so we track resource state barriers
         {
           SCOPED_LOCK(m_ImageLayoutsLock);
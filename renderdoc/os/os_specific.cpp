@@ -25,6 +25,8 @@
 
 #include "os/os_specific.h"
 #include <stdarg.h>
+#include "common/threading.h"
+#include "core/core.h"
 #include "serialise/string_utils.h"
 
 using std::string;
@@ -192,3 +194,382 @@ string OSUtility::MakeMachineIdentString(uint64_t ident)
 
   return ret;
 }
+
+struct WriteWatch::Region
+{
+  byte *pageBase;
+  size_t numPages;
+  // offset of the watched base pointer from pageBase, and the watched size from there
+  size_t baseOffset;
+  size_t size;
+  // one flag per page, set from the fault handler
+  volatile int32_t *dirty;
+};
+
+namespace WriteWatch
+{
+// the fault handler walks these slots without locking, so regions are only ever published or
+// removed with a single pointer write and we never need to allocate from inside the handler.
+// Slots are allocated in blocks under regionLock when every existing slot is in use. A block is
+// filled in before numRegionBlocks is incremented to publish it, and blocks are never freed, so the
+// handler can read any block below the count it sees.
+static const int RegionsPerBlock = 512;
+static const int MaxRegionBlocks = 64;
+
+struct RegionBlock
+{
+  Region *volatile regions[RegionsPerBlock];
+};
+
+static RegionBlock *regionBlocks[MaxRegionBlocks] = {};
+static volatile int32_t numRegionBlocks = 0;
+static Threading::CriticalSection regionLock;
+static bool handlerInstalled = false;
+
+// number of fault handlers currently running. A handler increments this before it looks at the
+// regions array, so once a region is unpublished and this has been seen at 0, no handler can
+// still be using it.
+static volatile int32_t activeHandlers = 0;
+
+// regions that have been unpublished but might still be in use by a running handler. Only
+// accessed under regionLock
+static std::vector<Region *> retiredRegions;
+
+static void FreeRetiredRegions()
+{
+  if(retiredRegions.empty() || Atomic::CmpExch32(&activeHandlers, 0, 0) != 0)
+    return;
+
+  for(size_t i = 0; i < retiredRegions.size(); i++)
+  {
+    delete[] retiredRegions[i]->dirty;
+    delete retiredRegions[i];
+  }
+
+  retiredRegions.clear();
+}
+
+static bool RegionCoversPage(Region *region, byte *page)
+{
+  return region != NULL && page >= region->pageBase &&
+         page < region->pageBase + region->numPages * GetPageSize();
+}
+
+Region *Begin(void *base, size_t size)
+{
+  if(base == NULL || size == 0)
+    return NULL;
+
+  const size_t pageSize = GetPageSize();
+
+  Region *region = new Region;
+  region->pageBase = (byte *)AlignDownPtr(base, pageSize);
+  region->baseOffset = size_t((byte *)base - region->pageBase);
+  region->size = size;
+  region->numPages = (region->baseOffset + size + pageSize - 1) / pageSize;
+  region->dirty = new int32_t[region->numPages];
+
+  // until the first reset everything is considered dirty, we don't know what happened before
+  for(size_t p = 0; p < region->numPages; p++)
+    region->dirty[p] = 1;
+
+  SCOPED_LOCK(regionLock);
+
+  FreeRetiredRegions();
+
+  Region *volatile *slot = NULL;
+  for(int32_t b = 0; b < numRegionBlocks && slot == NULL; b++)
+  {
+    for(int i = 0; i < RegionsPerBlock; i++)
+    {
+      if(regionBlocks[b]->regions[i] == NULL)
+      {
+        slot = &regionBlocks[b]->regions[i];
+        break;
+      }
+    }
+  }
+
+  if(slot == NULL && numRegionBlocks < MaxRegionBlocks)
+  {
+    RegionBlock *block = new RegionBlock;
+    for(int i = 0; i < RegionsPerBlock; i++)
+      block->regions[i] = NULL;
+
+    regionBlocks[numRegionBlocks] = block;
+    Atomic::Inc32(&numRegionBlocks);
+
+    slot = &block->regions[0];
+  }
+
+  // the caller handles NULL by falling back to comparing against a shadow copy, so running out
+  // only costs performance.
+  if(slot == NULL)
+  {
+    RDCWARN("Too many write-watched regions, falling back");
+    delete[] region->dirty;
+    delete region;
+    return NULL;
+  }
+
+  if(!handlerInstalled)
+  {
+    InstallFaultHandler();
+    handlerInstalled = true;
+  }
+
+  // we don't protect the pages here - everything starts dirty so it's left writeable until the
+  // first GetDirtyRanges resets tracking.
+  *slot = region;
+
+  return region;
+}
+
+void End(Region *region)
+{
+  if(region == NULL)
+    return;
+
+  SCOPED_LOCK(regionLock);
+
+  for(int32_t b = 0; b < numRegionBlocks; b++)
+  {
+    for(int i = 0; i < RegionsPerBlock; i++)
+    {
+      if(regionBlocks[b]->regions[i] == region)
+      {
+        regionBlocks[b]->regions[i] = NULL;
+        break;
+      }
+    }
+  }
+
+  // restore access so nothing faults on this region's memory once it's unpublished. Only the
+  // first and last page can be shared with another region, and those must stay protected if
+  // another region still covers them or writes to that region would be missed. If one of them
+  // is left protected, a later write from the application is caught by the other region, which
+  // just sees a spurious dirty page.
+  const size_t pageSize = GetPageSize();
+
+  size_t firstPage = 0;
+  size_t lastPage = region->numPages;
+
+  for(int32_t b = 0; b < numRegionBlocks; b++)
+  {
+    for(int i = 0; i < RegionsPerBlock; i++)
+    {
+      Region *other = regionBlocks[b]->regions[i];
+
+      if(firstPage < lastPage && RegionCoversPage(other, region->pageBase + firstPage * pageSize))
+        firstPage++;
+      if(firstPage < lastPage &&
+         RegionCoversPage(other, region->pageBase + (lastPage - 1) * pageSize))
+        lastPage--;
+    }
+  }
+
+  if(firstPage < lastPage)
+  {
+    byte *base = region->pageBase + firstPage * pageSize;
+
+    if(!ProtectPages(base, (lastPage - firstPage) * pageSize, true))
+      RDCWARN("Couldn't restore write access to %p", base);
+  }
+
+  // a handler on another thread could have loaded the pointer before we cleared it, so the region
+  // can only be freed once no handlers are running.
+  retiredRegions.push_back(region);
+
+  FreeRetiredRegions();
+}
+
+void GetDirtyRanges(Region *region, std::vector<std::pair<size_t, size_t> > &ranges)
+{
+  ranges.clear();
+
+  if(region == NULL)
+    return;
+
+  const size_t pageSize = GetPageSize();
+
+  size_t p = 0;
+  while(p < region->numPages)
+  {
+    if(region->dirty[p] == 0)
+    {
+      p++;
+      continue;
+    }
+
+    // find the run of contiguous dirty pages
+    size_t first = p;
+    while(p < region->numPages && region->dirty[p] != 0)
+    {
+      region->dirty[p] = 0;
+      p++;
+    }
+
+    // clear the flags before protecting, so a write that races with us either lands before the
+    // protection (and the caller's read will see it) or faults and re-dirties the page.
+    // If protection fails we can't catch writes, so the pages stay permanently dirty.
+    if(!ProtectPages(region->pageBase + first * pageSize, (p - first) * pageSize, false))
+    {
+      RDCWARN("Couldn't write-protect %p, pages will always be treated as dirty",
+              region->pageBase + first * pageSize);
+
+      for(size_t d = first; d < p; d++)
+        region->dirty[d] = 1;
+    }
+
+    // convert to offsets relative to the watched base, and clamp to the watched size
+    size_t start = first * pageSize;
+    size_t end = p * pageSize;
+
+    start = start > region->baseOffset ? start - region->baseOffset : 0;
+    end = RDCMIN(end - region->baseOffset, region->size);
+
+    if(end > start)
+      ranges.push_back(std::make_pair(start, end - start));
+  }
+}
+
+bool HandleFault(void *addr)
+{
+  const size_t pageSize = GetPageSize();
+  byte *faultPage = (byte *)AlignDownPtr(addr, pageSize);
+
+  bool handled = false;
+
+  // this runs inside a signal handler on some platforms, so it must not lock, allocate or log.
+  Atomic::Inc32(&activeHandlers);
+
+  const int32_t blockCount = Atomic::CmpExch32(&numRegionBlocks, 0, 0);
+
+  // a page could in theory be shared between two watched regions if maps aren't page aligned, so
+  // mark all regions covering the page before making it writeable.
+  for(int32_t b = 0; b < blockCount; b++)
+  {
+    for(int i = 0; i < RegionsPerBlock; i++)
+    {
+      Region *region = regionBlocks[b]->regions[i];
+
+      if(!RegionCoversPage(region, faultPage))
+        continue;
+
+      region->dirty[(faultPage - region->pageBase) / pageSize] = 1;
+      handled = true;
+    }
+  }
+
+  if(handled)
+    ProtectPages(faultPage, pageSize, true);
+
+  Atomic::Dec32(&activeHandlers);
+
+  return handled;
+}
+
+static bool CheckDirtyRanges(Region *region,
+                             const std::vector<std::pair<size_t, size_t> > &expected)
+{
+  std::vector<std::pair<size_t, size_t> > ranges;
+  GetDirtyRanges(region, ranges);
+
+  if(ranges == expected)
+    return true;
+
+  RDCERR("Got %u dirty ranges, expected %u", (uint32_t)ranges.size(), (uint32_t)expected.size());
+  for(size_t i = 0; i < ranges.size(); i++)
+    RDCERR("  [%u]: %llu bytes at %llu", (uint32_t)i, (uint64_t)ranges[i].second,
+           (uint64_t)ranges[i].first);
+  return false;
+}
+
+static bool SelfTest()
+{
+  const size_t pageSize = GetPageSize();
+  const size_t numPages = 4;
+
+  // page-align the watched range inside the allocation so nothing else shares its pages
+  byte *alloc = new byte[(numPages + 1) * pageSize];
+  byte *buf = (byte *)AlignUpPtr(alloc, pageSize);
+
+  bool ret = true;
+
+  Region *region = Begin(buf, numPages * pageSize);
+
+  if(region == NULL)
+  {
+    RDCWARN("Write watching isn't supported, skipping test");
+    delete[] alloc;
+    return true;
+  }
+
+  std::vector<std::pair<size_t, size_t> > expected;
+
+  // everything starts dirty, then nothing is dirty until it's written again
+  expected.push_back(std::make_pair(size_t(0), numPages * pageSize));
+  ret &= CheckDirtyRanges(region, expected);
+
+  expected.clear();
+  ret &= CheckDirtyRanges(region, expected);
+
+  buf[pageSize + 10] = 1;
+  buf[3 * pageSize] = 2;
+  buf[3 * pageSize + 1] = 3;
+
+  expected.push_back(std::make_pair(pageSize, pageSize));
+  expected.push_back(std::make_pair(3 * pageSize, pageSize));
+  ret &= CheckDirtyRanges(region, expected);
+
+  // watch the same page many more times than fit in one block of slots, to check slots are added
+  // when they run out and that a fault on a shared page is seen by every region covering it.
+  std::vector<Region *> overlapping;
+  for(int i = 0; i < RegionsPerBlock * 2 + 1; i++)
+  {
+    Region *r = Begin(buf + 16, 32);
+    if(r == NULL)
+    {
+      RDCERR("Couldn't begin watching overlapping region %d", i);
+      ret = false;
+      break;
+    }
+    overlapping.push_back(r);
+  }
+
+  expected.clear();
+  expected.push_back(std::make_pair(size_t(0), size_t(32)));
+
+  for(size_t i = 0; i < overlapping.size(); i++)
+    ret &= CheckDirtyRanges(overlapping[i], expected);
+
+  buf[20] = 4;
+
+  for(size_t i = 0; i < overlapping.size(); i++)
+    ret &= CheckDirtyRanges(overlapping[i], expected);
+
+  expected.clear();
+  expected.push_back(std::make_pair(size_t(0), pageSize));
+  ret &= CheckDirtyRanges(region, expected);
+
+  for(size_t i = 0; i < overlapping.size(); i++)
+    End(overlapping[i]);
+
+  // the outer region still covers the page so it must still see writes after the others end
+  buf[40] = 5;
+
+  ret &= CheckDirtyRanges(region, expected);
+
+  End(region);
+
+  // once nothing watches the memory it must be writeable again without going through the handler
+  for(size_t p = 0; p < numPages; p++)
+    buf[p * pageSize] = 6;
+
+  delete[] alloc;
+
+  return ret;
+}
+
+static SelfTestRegistration WriteWatchTest("os.writewatch", &SelfTest);
+};    // namespace WriteWatch
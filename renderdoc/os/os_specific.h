@@ -115,6 +115,26 @@ void JoinThread(ThreadHandle handle);
 void CloseThread(ThreadHandle handle);
 void Sleep(uint32_t milliseconds);
 
+// counting semaphore, for parking long-lived worker threads until there is work for them
+class Semaphore
+{
+public:
+  static Semaphore *Create();
+  void Destroy();
+
+  // releases up to numToWake threads blocked in WaitForWake, or lets that many future waits
+  // return immediately
+  void Wake(uint32_t numToWake);
+  void WaitForWake();
+
+protected:
+  Semaphore() {}
+  ~Semaphore() {}
+};
+
+// number of logical processors available, always at least 1
+uint32_t NumberOfCores();
+
 // kind of windows specific, to handle this case:
 // http://blogs.msdn.com/b/oldnewthing/archive/2013/11/05/10463645.aspx
 void KeepModuleAlive();
@@ -185,6 +205,11 @@ int64_t Inc64(volatile int64_t *i);
 int64_t Dec64(volatile int64_t *i);
 int64_t ExchAdd64(volatile int64_t *i, int64_t a);
 int32_t CmpExch32(volatile int32_t *dest, int32_t oldVal, int32_t newVal);
+int64_t CmpExch64(volatile int64_t *dest, int64_t oldVal, int64_t newVal);
+
+// a load that no later read or write can be reordered before, to pair with a value published
+// by one of the functions above (which are all full barriers).
+int32_t LoadAcquire32(volatile int32_t *i);
 };
 
 namespace Callstack
@@ -380,6 +405,36 @@ uint64_t GetMachineIdent();
 string MakeMachineIdentString(uint64_t ident);
 };
 
+// tracks CPU writes to a range of memory at page granularity. Every page overlapping the range is
+// made read-only, and the first write to each page is caught by a fault handler, which marks the
+// page dirty and makes it writeable again so the application continues at full speed.
+namespace WriteWatch
+{
+struct Region;
+
+// begins watching [base, base+size). Returns NULL if the platform or the memory doesn't support
+// changing page protection, in which case the caller must fall back to another method.
+Region *Begin(void *base, size_t size);
+
+// stops watching and restores read/write access to the region's pages.
+void End(Region *region);
+
+// returns the dirty ranges as (offset, size) pairs relative to base, clamped to the watched size,
+// and resets tracking. The pages are write-protected again *before* this returns, so any write
+// made after the caller reads the memory is guaranteed to be caught next time.
+void GetDirtyRanges(Region *region, std::vector<std::pair<size_t, size_t> > &ranges);
+
+// implemented per-platform. ProtectPages is called from the fault handler so it must be
+// async-signal-safe, and doesn't log on failure - callers outside the handler do that.
+size_t GetPageSize();
+bool ProtectPages(void *pageBase, size_t size, bool writeable);
+void InstallFaultHandler();
+
+// called by the platform's fault handler. Returns true if the address was in a watched page, in
+// which case the page has been made writeable and execution can resume.
+bool HandleFault(void *addr);
+};
+
 namespace Bits
 {
 inline uint32_t CountLeadingZeroes(uint32_t value);
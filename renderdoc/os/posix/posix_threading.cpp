@@ -64,6 +64,16 @@ int32_t CmpExch32(volatile int32_t *dest, int32_t oldVal, int32_t newVal)
 {
   return __sync_val_compare_and_swap(dest, oldVal, newVal);
 }
+
+int64_t CmpExch64(volatile int64_t *dest, int64_t oldVal, int64_t newVal)
+{
+  return __sync_val_compare_and_swap(dest, oldVal, newVal);
+}
+
+int32_t LoadAcquire32(volatile int32_t *i)
+{
+  return __atomic_load_n(i, __ATOMIC_ACQUIRE);
+}
 };
 
 namespace Threading
@@ -153,6 +163,9 @@ void Shutdown()
   delete m_TLSList;
   delete m_TLSListLock;
 
+  m_TLSList = NULL;
+  m_TLSListLock = NULL;
+
   pthread_key_delete(OSTLSHandle);
 }
 
@@ -245,4 +258,57 @@ void Sleep(uint32_t milliseconds)
 {
   usleep(milliseconds * 1000);
 }
+
+struct PosixSemaphore : public Semaphore
+{
+  ~PosixSemaphore() {}
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  uint32_t count;
+};
+
+Semaphore *Semaphore::Create()
+{
+  PosixSemaphore *sem = new PosixSemaphore();
+  pthread_mutex_init(&sem->lock, NULL);
+  pthread_cond_init(&sem->cond, NULL);
+  sem->count = 0;
+  return sem;
+}
+
+void Semaphore::Destroy()
+{
+  PosixSemaphore *sem = (PosixSemaphore *)this;
+  pthread_cond_destroy(&sem->cond);
+  pthread_mutex_destroy(&sem->lock);
+  delete sem;
+}
+
+void Semaphore::Wake(uint32_t numToWake)
+{
+  PosixSemaphore *sem = (PosixSemaphore *)this;
+  pthread_mutex_lock(&sem->lock);
+  sem->count += numToWake;
+  if(numToWake == 1)
+    pthread_cond_signal(&sem->cond);
+  else if(numToWake > 1)
+    pthread_cond_broadcast(&sem->cond);
+  pthread_mutex_unlock(&sem->lock);
+}
+
+void Semaphore::WaitForWake()
+{
+  PosixSemaphore *sem = (PosixSemaphore *)this;
+  pthread_mutex_lock(&sem->lock);
+  while(sem->count == 0)
+    pthread_cond_wait(&sem->cond, &sem->lock);
+  sem->count--;
+  pthread_mutex_unlock(&sem->lock);
+}
+
+uint32_t NumberOfCores()
+{
+  long ret = sysconf(_SC_NPROCESSORS_ONLN);
+  return ret > 0 ? (uint32_t)ret : 1;
+}
 };
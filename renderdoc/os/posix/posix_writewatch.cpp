@@ -0,0 +1,81 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "os/os_specific.h"
+
+static struct sigaction prevSEGV, prevBUS;
+
+static void WriteWatchFaultHandler(int sig, siginfo_t *info, void *ctx)
+{
+  if(WriteWatch::HandleFault(info->si_addr))
+    return;
+
+  // not one of ours, pass it on to whoever was installed before us
+  struct sigaction &prev = (sig == SIGBUS) ? prevBUS : prevSEGV;
+
+  if(prev.sa_handler == SIG_DFL || prev.sa_handler == SIG_IGN)
+  {
+    // there's no function to call, so put the previous disposition back exactly as it was.
+    // Returning re-executes the faulting instruction and the fault is delivered the same way it
+    // would have been if we'd never installed a handler.
+    sigaction(sig, &prev, NULL);
+  }
+  else if(prev.sa_flags & SA_SIGINFO)
+  {
+    prev.sa_sigaction(sig, info, ctx);
+  }
+  else
+  {
+    prev.sa_handler(sig);
+  }
+}
+
+namespace WriteWatch
+{
+size_t GetPageSize()
+{
+  static size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+  return pageSize;
+}
+
+bool ProtectPages(void *pageBase, size_t size, bool writeable)
+{
+  return mprotect(pageBase, size, writeable ? (PROT_READ | PROT_WRITE) : PROT_READ) == 0;
+}
+
+void InstallFaultHandler()
+{
+  struct sigaction sa = {};
+  sa.sa_sigaction = &WriteWatchFaultHandler;
+  sa.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+
+  // writes to read-only pages raise SIGSEGV on linux/android, and SIGBUS on apple
+  sigaction(SIGSEGV, &sa, &prevSEGV);
+  sigaction(SIGBUS, &sa, &prevBUS);
+}
+};
@@ -77,6 +77,20 @@ int32_t CmpExch32(volatile int32_t *dest, int32_t oldVal, int32_t newVal)
 {
   return (int32_t)InterlockedCompareExchange((volatile LONG *)dest, newVal, oldVal);
 }
+
+int64_t CmpExch64(volatile int64_t *dest, int64_t oldVal, int64_t newVal)
+{
+  return (int64_t)InterlockedCompareExchange64((volatile LONG64 *)dest, newVal, oldVal);
+}
+
+int32_t LoadAcquire32(volatile int32_t *i)
+{
+  // volatile reads have acquire semantics on x86/x64, this stops the compiler moving later
+  // accesses before the read
+  int32_t ret = *i;
+  _ReadWriteBarrier();
+  return ret;
+}
 };
 
 namespace Threading
@@ -156,6 +170,9 @@ void Shutdown()
   delete m_TLSList;
   delete m_TLSListLock;
 
+  m_TLSList = NULL;
+  m_TLSListLock = NULL;
+
   TlsFree(OSTLSHandle);
 }
 
@@ -253,4 +270,44 @@ void Sleep(uint32_t milliseconds)
 {
   ::Sleep((DWORD)milliseconds);
 }
+
+struct Win32Semaphore : public Semaphore
+{
+  ~Win32Semaphore() {}
+  HANDLE handle;
+};
+
+Semaphore *Semaphore::Create()
+{
+  Win32Semaphore *sem = new Win32Semaphore();
+  sem->handle = CreateSemaphore(NULL, 0, 0x7fffffff, NULL);
+  return sem;
+}
+
+void Semaphore::Destroy()
+{
+  Win32Semaphore *sem = (Win32Semaphore *)this;
+  CloseHandle(sem->handle);
+  delete sem;
+}
+
+void Semaphore::Wake(uint32_t numToWake)
+{
+  Win32Semaphore *sem = (Win32Semaphore *)this;
+  if(numToWake > 0)
+    ReleaseSemaphore(sem->handle, (LONG)numToWake, NULL);
+}
+
+void Semaphore::WaitForWake()
+{
+  Win32Semaphore *sem = (Win32Semaphore *)this;
+  WaitForSingleObject(sem->handle, INFINITE);
+}
+
+uint32_t NumberOfCores()
+{
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors > 0 ? (uint32_t)info.dwNumberOfProcessors : 1;
+}
 };
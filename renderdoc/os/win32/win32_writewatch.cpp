@@ -0,0 +1,73 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "os/os_specific.h"
+
+static LONG CALLBACK WriteWatchExceptionHandler(PEXCEPTION_POINTERS info)
+{
+  EXCEPTION_RECORD *rec = info->ExceptionRecord;
+
+  // ExceptionInformation[0] is 1 for a write access, [1] is the faulting address
+  if(rec->ExceptionCode == EXCEPTION_ACCESS_VIOLATION && rec->NumberParameters >= 2 &&
+     rec->ExceptionInformation[0] == 1 &&
+     WriteWatch::HandleFault((void *)rec->ExceptionInformation[1]))
+    return EXCEPTION_CONTINUE_EXECUTION;
+
+  return EXCEPTION_CONTINUE_SEARCH;
+}
+
+namespace WriteWatch
+{
+size_t GetPageSize()
+{
+  static size_t pageSize = 0;
+
+  if(pageSize == 0)
+  {
+    SYSTEM_INFO info = {};
+    GetSystemInfo(&info);
+    pageSize = (size_t)info.dwPageSize;
+  }
+
+  return pageSize;
+}
+
+bool ProtectPages(void *pageBase, size_t size, bool writeable)
+{
+  // driver mappings are often write-combined or uncached, keep those modifiers intact
+  MEMORY_BASIC_INFORMATION mbi = {};
+  VirtualQuery(pageBase, &mbi, sizeof(mbi));
+
+  DWORD modifiers = mbi.Protect & (PAGE_NOCACHE | PAGE_WRITECOMBINE);
+
+  DWORD oldProtect = 0;
+  DWORD protect = (writeable ? PAGE_READWRITE : PAGE_READONLY) | modifiers;
+  return VirtualProtect(pageBase, size, protect, &oldProtect) == TRUE;
+}
+
+void InstallFaultHandler()
+{
+  AddVectoredExceptionHandler(1, &WriteWatchExceptionHandler);
+}
+};
@@ -326,6 +326,11 @@ extern "C" RENDERDOC_API void RENDERDOC_CC RENDERDOC_TriggerExceptionHandler(voi
   }
 }
 
+extern "C" RENDERDOC_API uint32_t RENDERDOC_CC RENDERDOC_RunSelfTests(const char *filter)
+{
+  return RenderDoc::Inst().RunSelfTests(filter);
+}
+
 extern "C" RENDERDOC_API ReplaySupport RENDERDOC_CC RENDERDOC_SupportLocalReplay(
     const char *logfile, rdctype::str *driver, rdctype::str *recordMachineIdent)
 {
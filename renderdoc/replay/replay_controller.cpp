@@ -24,6 +24,8 @@
  ******************************************************************************/
 
 #include "replay_controller.h"
+#include <algorithm>
+#include <math.h>
 #include <string.h>
 #include <time.h>
 #include "common/dds_readwrite.h"
@@ -151,6 +153,8 @@ ReplayController::ReplayController()
   m_pDevice = NULL;
 
   m_EventID = 100000;
+
+  RDCEraseEl(m_APIProps);
 }
 
 ReplayController::~ReplayController()
@@ -189,29 +193,47 @@ void ReplayController::SetFrameEvent(uint32_t eventID, bool force)
       m_Outputs[i]->SetFrameEvent(eventID);
 
     m_pDevice->ReplayLog(eventID, eReplay_OnlyDraw);
-
-    FetchPipelineState();
   }
 }
 
 D3D11Pipe::State ReplayController::GetD3D11PipelineState()
 {
-  return m_D3D11PipelineState;
+  if(m_APIProps.pipelineType != GraphicsAPI::D3D11)
+    return D3D11Pipe::State();
+
+  FetchPipelineState();
+
+  return m_PipelineStates[m_EventID].d3d11;
 }
 
 D3D12Pipe::State ReplayController::GetD3D12PipelineState()
 {
-  return m_D3D12PipelineState;
+  if(m_APIProps.pipelineType != GraphicsAPI::D3D12)
+    return D3D12Pipe::State();
+
+  FetchPipelineState();
+
+  return m_PipelineStates[m_EventID].d3d12;
 }
 
 GLPipe::State ReplayController::GetGLPipelineState()
 {
-  return m_GLPipelineState;
+  if(m_APIProps.pipelineType != GraphicsAPI::OpenGL)
+    return GLPipe::State();
+
+  FetchPipelineState();
+
+  return m_PipelineStates[m_EventID].gl;
 }
 
 VKPipe::State ReplayController::GetVulkanPipelineState()
 {
-  return m_VulkanPipelineState;
+  if(m_APIProps.pipelineType != GraphicsAPI::Vulkan)
+    return VKPipe::State();
+
+  FetchPipelineState();
+
+  return m_PipelineStates[m_EventID].vulkan;
 }
 
 FrameDescription ReplayController::GetFrameInfo()
@@ -242,6 +264,91 @@ rdctype::array<CounterResult> ReplayController::FetchCounters(const rdctype::arr
   return m_pDevice->FetchCounters(counterArray);
 }
 
+static double Median(vector<double> &values)
+{
+  std::sort(values.begin(), values.end());
+
+  size_t mid = values.size() / 2;
+
+  if(values.size() % 2 == 0)
+    return (values[mid - 1] + values[mid]) * 0.5;
+
+  return values[mid];
+}
+
+rdctype::array<EventDurationStats> ReplayController::BenchmarkEventDurations(uint32_t warmupPasses,
+                                                                            uint32_t passes,
+                                                                            uint32_t isolateEventID)
+{
+  vector<EventDurationStats> ret;
+
+  if(passes == 0)
+    return ret;
+
+  vector<GPUCounter> counters;
+  counters.push_back(GPUCounter::EventGPUDuration);
+
+  map<uint32_t, vector<double> > samples;
+
+  for(uint32_t pass = 0; pass < warmupPasses + passes; pass++)
+  {
+    bool measure = pass >= warmupPasses;
+
+    if(isolateEventID != 0)
+    {
+      double duration = m_pDevice->GetIsolatedDuration(isolateEventID);
+
+      if(duration < 0.0)
+      {
+        SetFrameEvent(m_EventID, true);
+        return ret;
+      }
+
+      if(measure)
+        samples[isolateEventID].push_back(duration);
+    }
+    else
+    {
+      vector<CounterResult> results = m_pDevice->FetchCounters(counters);
+
+      if(!measure)
+        continue;
+
+      for(size_t i = 0; i < results.size(); i++)
+      {
+        // negative durations are queries that failed
+        if(results[i].value.d >= 0.0)
+          samples[results[i].eventID].push_back(results[i].value.d);
+      }
+    }
+  }
+
+  for(auto it = samples.begin(); it != samples.end(); ++it)
+  {
+    vector<double> &values = it->second;
+
+    EventDurationStats stats;
+    stats.eventID = it->first;
+    stats.samples = (uint32_t)values.size();
+    stats.median = Median(values);
+    stats.minimum = values[0];
+
+    vector<double> deviations;
+    deviations.reserve(values.size());
+    for(size_t i = 0; i < values.size(); i++)
+      deviations.push_back(fabs(values[i] - stats.median));
+
+    stats.medianAbsDeviation = Median(deviations);
+
+    ret.push_back(stats);
+  }
+
+  // the passes leave the device replayed to the end of the frame, put it back
+  SetFrameEvent(m_EventID, true);
+
+  return ret;
+}
+
 rdctype::array<GPUCounter> ReplayController::EnumerateCounters()
 {
   return m_pDevice->EnumerateCounters();
@@ -313,9 +420,38 @@ rdctype::array<DebugMessage> ReplayController::GetDebugMessages()
   return m_pDevice->GetDebugMessages();
 }
 
+rdctype::array<ChunkProfile> ReplayController::GetChunkProfile()
+{
+  return m_pDevice->GetChunkProfile();
+}
+
+const ResourceUsageIndex &ReplayController::GetUsageIndex(ResourceId id)
+{
+  auto it = m_UsageIndex.find(id);
+
+  if(it == m_UsageIndex.end())
+  {
+    ResourceUsageIndex index(m_pDevice->GetUsage(m_pDevice->GetLiveID(id)));
+    it = m_UsageIndex.insert(std::make_pair(id, index)).first;
+  }
+
+  return it->second;
+}
+
 rdctype::array<EventUsage> ReplayController::GetUsage(ResourceId id)
 {
-  return m_pDevice->GetUsage(m_pDevice->GetLiveID(id));
+  return GetUsageIndex(id).GetUsage();
+}
+
+rdctype::array<EventUsage> ReplayController::GetUsageInRange(ResourceId id, uint32_t minEventID,
+                                                             uint32_t maxEventID, bool writesOnly)
+{
+  return GetUsageIndex(id).GetUsage(minEventID, maxEventID, writesOnly);
+}
+
+EventUsage ReplayController::GetLastWrite(ResourceId id, uint32_t eventID)
+{
+  return GetUsageIndex(id).GetLastWrite(eventID);
 }
 
 MeshFormat ReplayController::GetPostVSData(uint32_t instID, MeshDataStage stage)
@@ -1209,64 +1345,14 @@ rdctype::array<PixelModification> ReplayController::PixelHistory(ResourceId targ
     }
   }
 
-  auto usage = m_pDevice->GetUsage(m_pDevice->GetLiveID(target));
+  vector<EventUsage> usage = GetUsageIndex(target).GetUsage(0, m_EventID, false);
 
+  // pixel history has always included uses of unknown type, in case they touched the target
   vector<EventUsage> events;
 
   for(size_t i = 0; i < usage.size(); i++)
-  {
-    if(usage[i].eventID > m_EventID)
-      continue;
-
-    switch(usage[i].usage)
-    {
-      case ResourceUsage::VertexBuffer:
-      case ResourceUsage::IndexBuffer:
-      case ResourceUsage::VS_Constants:
-      case ResourceUsage::HS_Constants:
-      case ResourceUsage::DS_Constants:
-      case ResourceUsage::GS_Constants:
-      case ResourceUsage::PS_Constants:
-      case ResourceUsage::CS_Constants:
-      case ResourceUsage::All_Constants:
-      case ResourceUsage::VS_Resource:
-      case ResourceUsage::HS_Resource:
-      case ResourceUsage::DS_Resource:
-      case ResourceUsage::GS_Resource:
-      case ResourceUsage::PS_Resource:
-      case ResourceUsage::CS_Resource:
-      case ResourceUsage::All_Resource:
-      case ResourceUsage::InputTarget:
-      case ResourceUsage::CopySrc:
-      case ResourceUsage::ResolveSrc:
-      case ResourceUsage::Barrier:
-      case ResourceUsage::Indirect:
-        // read-only, not a valid pixel history event
-        continue;
-
-      case ResourceUsage::Unused:
-      case ResourceUsage::StreamOut:
-      case ResourceUsage::VS_RWResource:
-      case ResourceUsage::HS_RWResource:
-      case ResourceUsage::DS_RWResource:
-      case ResourceUsage::GS_RWResource:
-      case ResourceUsage::PS_RWResource:
-      case ResourceUsage::CS_RWResource:
-      case ResourceUsage::All_RWResource:
-      case ResourceUsage::ColorTarget:
-      case ResourceUsage::DepthStencilTarget:
-      case ResourceUsage::Clear:
-      case ResourceUsage::Copy:
-      case ResourceUsage::CopyDst:
-      case ResourceUsage::Resolve:
-      case ResourceUsage::ResolveDst:
-      case ResourceUsage::GenMips:
-        // writing - include in pixel history events
-        break;
-    }
-
-    events.push_back(usage[i]);
-  }
+    if(IsWriteUsage(usage[i].usage) || usage[i].usage == ResourceUsage::Unused)
+      events.push_back(usage[i]);
 
   if(events.empty())
   {
@@ -1436,6 +1522,9 @@ void ReplayController::ReplaceResource(ResourceId from, ResourceId to)
 {
   m_pDevice->ReplaceResource(from, to);
 
+  m_PipelineStates.clear();
+  m_ShaderReflections.clear();
+
   SetFrameEvent(m_EventID, true);
 
   for(size_t i = 0; i < m_Outputs.size(); i++)
@@ -1447,6 +1536,9 @@ void ReplayController::RemoveReplacement(ResourceId id)
 {
   m_pDevice->RemoveReplacement(id);
 
+  m_PipelineStates.clear();
+  m_ShaderReflections.clear();
+
   SetFrameEvent(m_EventID, true);
 
   for(size_t i = 0; i < m_Outputs.size(); i++)
@@ -1501,7 +1593,7 @@ ReplayStatus ReplayController::PostCreateInit(IReplayDriver *device)
 
   m_pDevice->ReadLogInitialisation();
 
-  FetchPipelineState();
+  m_APIProps = m_pDevice->GetAPIProperties();
 
   m_FrameRecord = m_pDevice->GetFrameRecord();
 
@@ -1531,58 +1623,93 @@ bool ReplayController::InitResolver()
   return m_pDevice->GetCallstackResolver() != NULL;
 }
 
+ShaderReflection *ReplayController::GetShaderReflection(ResourceId shader, const char *entryPoint)
+{
+  if(shader == ResourceId())
+    return NULL;
+
+  ShaderReflKey key(shader, entryPoint);
+
+  auto it = m_ShaderReflections.find(key);
+  if(it != m_ShaderReflections.end())
+    return it->second;
+
+  ShaderReflection *refl = m_pDevice->GetShader(m_pDevice->GetLiveID(shader), entryPoint);
+
+  m_ShaderReflections[key] = refl;
+
+  return refl;
+}
+
 void ReplayController::FetchPipelineState()
 {
+  if(m_PipelineStates.find(m_EventID) != m_PipelineStates.end())
+    return;
+
+  // only the events being flicked between need to stay cached
+  if(m_PipelineStates.size() >= 64)
+    m_PipelineStates.clear();
+
+  // counters, overlays, debugging and the like all replay the frame themselves and can leave the
+  // device anywhere, so replay back to the current event before saving its state.
+  m_pDevice->ReplayLog(m_EventID, eReplay_Full);
+
   m_pDevice->SavePipelineState();
 
-  m_D3D11PipelineState = m_pDevice->GetD3D11PipelineState();
-  m_D3D12PipelineState = m_pDevice->GetD3D12PipelineState();
-  m_GLPipelineState = m_pDevice->GetGLPipelineState();
-  m_VulkanPipelineState = m_pDevice->GetVulkanPipelineState();
+  PipelineStates &states = m_PipelineStates[m_EventID];
 
+  if(m_APIProps.pipelineType == GraphicsAPI::D3D11)
   {
+    D3D11Pipe::State &state = states.d3d11;
+
+    state = m_pDevice->GetD3D11PipelineState();
+
     D3D11Pipe::Shader *stages[] = {
-        &m_D3D11PipelineState.m_VS, &m_D3D11PipelineState.m_HS, &m_D3D11PipelineState.m_DS,
-        &m_D3D11PipelineState.m_GS, &m_D3D11PipelineState.m_PS, &m_D3D11PipelineState.m_CS,
+        &state.m_VS, &state.m_HS, &state.m_DS, &state.m_GS, &state.m_PS, &state.m_CS,
     };
 
     for(int i = 0; i < 6; i++)
-      if(stages[i]->Object != ResourceId())
-        stages[i]->ShaderDetails = m_pDevice->GetShader(m_pDevice->GetLiveID(stages[i]->Object), "");
+      stages[i]->ShaderDetails = GetShaderReflection(stages[i]->Object, "");
   }
-
+  else if(m_APIProps.pipelineType == GraphicsAPI::D3D12)
   {
+    D3D12Pipe::State &state = states.d3d12;
+
+    state = m_pDevice->GetD3D12PipelineState();
+
     D3D12Pipe::Shader *stages[] = {
-        &m_D3D12PipelineState.m_VS, &m_D3D12PipelineState.m_HS, &m_D3D12PipelineState.m_DS,
-        &m_D3D12PipelineState.m_GS, &m_D3D12PipelineState.m_PS, &m_D3D12PipelineState.m_CS,
+        &state.m_VS, &state.m_HS, &state.m_DS, &state.m_GS, &state.m_PS, &state.m_CS,
     };
 
     for(int i = 0; i < 6; i++)
-      if(stages[i]->Object != ResourceId())
-        stages[i]->ShaderDetails = m_pDevice->GetShader(m_pDevice->GetLiveID(stages[i]->Object), "");
+      stages[i]->ShaderDetails = GetShaderReflection(stages[i]->Object, "");
   }
-
+  else if(m_APIProps.pipelineType == GraphicsAPI::OpenGL)
   {
+    GLPipe::State &state = states.gl;
+
+    state = m_pDevice->GetGLPipelineState();
+
     GLPipe::Shader *stages[] = {
-        &m_GLPipelineState.m_VS, &m_GLPipelineState.m_TCS, &m_GLPipelineState.m_TES,
-        &m_GLPipelineState.m_GS, &m_GLPipelineState.m_FS,  &m_GLPipelineState.m_CS,
+        &state.m_VS, &state.m_TCS, &state.m_TES, &state.m_GS, &state.m_FS, &state.m_CS,
     };
 
     for(int i = 0; i < 6; i++)
-      if(stages[i]->Object != ResourceId())
-        stages[i]->ShaderDetails = m_pDevice->GetShader(m_pDevice->GetLiveID(stages[i]->Object), "");
+      stages[i]->ShaderDetails = GetShaderReflection(stages[i]->Object, "");
   }
-
+  else if(m_APIProps.pipelineType == GraphicsAPI::Vulkan)
   {
+    VKPipe::State &state = states.vulkan;
+
+    state = m_pDevice->GetVulkanPipelineState();
+
     VKPipe::Shader *stages[] = {
-        &m_VulkanPipelineState.m_VS, &m_VulkanPipelineState.m_TCS, &m_VulkanPipelineState.m_TES,
-        &m_VulkanPipelineState.m_GS, &m_VulkanPipelineState.m_FS,  &m_VulkanPipelineState.m_CS,
+        &state.m_VS, &state.m_TCS, &state.m_TES, &state.m_GS, &state.m_FS, &state.m_CS,
     };
 
     for(int i = 0; i < 6; i++)
-      if(stages[i]->Object != ResourceId())
-        stages[i]->ShaderDetails = m_pDevice->GetShader(m_pDevice->GetLiveID(stages[i]->Object),
-                                                        stages[i]->entryPoint.elems);
+      stages[i]->ShaderDetails =
+          GetShaderReflection(stages[i]->Object, stages[i]->entryPoint.elems);
   }
 }
 
@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include <map>
 #include <set>
 #include <vector>
 #include "api/replay/renderdoc_replay.h"
@@ -157,12 +158,15 @@ public:
   FrameDescription GetFrameInfo();
   rdctype::array<DrawcallDescription> GetDrawcalls();
   rdctype::array<CounterResult> FetchCounters(const rdctype::array<GPUCounter> &counters);
+  rdctype::array<EventDurationStats> BenchmarkEventDurations(uint32_t warmupPasses, uint32_t passes,
+                                                             uint32_t isolateEventID);
   rdctype::array<GPUCounter> EnumerateCounters();
   CounterDescription DescribeCounter(GPUCounter counterID);
   rdctype::array<TextureDescription> GetTextures();
   rdctype::array<BufferDescription> GetBuffers();
   rdctype::array<rdctype::str> GetResolve(const rdctype::array<uint64_t> &callstack);
   rdctype::array<DebugMessage> GetDebugMessages();
+  rdctype::array<ChunkProfile> GetChunkProfile();
 
   rdctype::array<PixelModification> PixelHistory(ResourceId target, uint32_t x, uint32_t y,
                                                  uint32_t slice, uint32_t mip, uint32_t sampleIdx,
@@ -176,6 +180,9 @@ public:
   MeshFormat GetPostVSData(uint32_t instID, MeshDataStage stage);
 
   rdctype::array<EventUsage> GetUsage(ResourceId id);
+  rdctype::array<EventUsage> GetUsageInRange(ResourceId id, uint32_t minEventID,
+                                             uint32_t maxEventID, bool writesOnly);
+  EventUsage GetLastWrite(ResourceId id, uint32_t eventID);
 
   rdctype::array<byte> GetBufferData(ResourceId buff, uint64_t offset, uint64_t len);
   rdctype::array<byte> GetTextureData(ResourceId buff, uint32_t arrayIdx, uint32_t mip);
@@ -204,16 +211,36 @@ private:
 
   uint32_t m_EventID;
 
-  D3D11Pipe::State m_D3D11PipelineState;
-  D3D12Pipe::State m_D3D12PipelineState;
-  GLPipe::State m_GLPipelineState;
-  VKPipe::State m_VulkanPipelineState;
+  APIProperties m_APIProps;
+
+  // pipeline states by event ID. Only the capture's API is filled out, and only once it's asked
+  // for. Cleared when resource replacements could change them
+  struct PipelineStates
+  {
+    D3D11Pipe::State d3d11;
+    D3D12Pipe::State d3d12;
+    GLPipe::State gl;
+    VKPipe::State vulkan;
+  };
+  std::map<uint32_t, PipelineStates> m_PipelineStates;
+
+  // reflection for each shader and entry point, fetched the first time a pipeline state binds it
+  // rather than again for every event that uses it
+  typedef std::pair<ResourceId, std::string> ShaderReflKey;
+  std::map<ShaderReflKey, ShaderReflection *> m_ShaderReflections;
+
+  ShaderReflection *GetShaderReflection(ResourceId shader, const char *entryPoint);
 
   std::vector<ReplayOutput *> m_Outputs;
 
   std::vector<BufferDescription> m_Buffers;
   std::vector<TextureDescription> m_Textures;
 
+  // uses don't change after load, so each resource's are fetched once (which may be over the
+  // replay proxy) and then queried locally
+  std::map<ResourceId, ResourceUsageIndex> m_UsageIndex;
+  const ResourceUsageIndex &GetUsageIndex(ResourceId id);
+
   IReplayDriver *m_pDevice;
 
   std::set<ResourceId> m_TargetResources;
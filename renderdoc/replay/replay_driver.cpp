@@ -23,7 +23,9 @@
  ******************************************************************************/
 
 #include "replay_driver.h"
+#include <algorithm>
 #include "maths/formatpacking.h"
+#include "serialise/serialiser.h"
 
 DrawcallDescription *SetupDrawcallPointers(vector<DrawcallDescription *> *drawcallTable,
                                            rdctype::array<DrawcallDescription> &draws,
@@ -80,6 +82,157 @@ DrawcallDescription *SetupDrawcallPointers(vector<DrawcallDescription *> *drawca
   return ret;
 }
 
+bool IsWriteUsage(ResourceUsage usage)
+{
+  switch(usage)
+  {
+    case ResourceUsage::Unused:
+    case ResourceUsage::VertexBuffer:
+    case ResourceUsage::IndexBuffer:
+    case ResourceUsage::VS_Constants:
+    case ResourceUsage::HS_Constants:
+    case ResourceUsage::DS_Constants:
+    case ResourceUsage::GS_Constants:
+    case ResourceUsage::PS_Constants:
+    case ResourceUsage::CS_Constants:
+    case ResourceUsage::All_Constants:
+    case ResourceUsage::VS_Resource:
+    case ResourceUsage::HS_Resource:
+    case ResourceUsage::DS_Resource:
+    case ResourceUsage::GS_Resource:
+    case ResourceUsage::PS_Resource:
+    case ResourceUsage::CS_Resource:
+    case ResourceUsage::All_Resource:
+    case ResourceUsage::InputTarget:
+    case ResourceUsage::CopySrc:
+    case ResourceUsage::ResolveSrc:
+    case ResourceUsage::Barrier:
+    case ResourceUsage::Indirect: return false;
+
+    case ResourceUsage::StreamOut:
+    case ResourceUsage::VS_RWResource:
+    case ResourceUsage::HS_RWResource:
+    case ResourceUsage::DS_RWResource:
+    case ResourceUsage::GS_RWResource:
+    case ResourceUsage::PS_RWResource:
+    case ResourceUsage::CS_RWResource:
+    case ResourceUsage::All_RWResource:
+    case ResourceUsage::ColorTarget:
+    case ResourceUsage::DepthStencilTarget:
+    case ResourceUsage::Clear:
+    case ResourceUsage::Copy:
+    case ResourceUsage::CopyDst:
+    case ResourceUsage::Resolve:
+    case ResourceUsage::ResolveDst:
+    case ResourceUsage::GenMips: return true;
+  }
+
+  return false;
+}
+
+// orders uses by EID only, so a bare EID can be searched for
+struct EventUsageEIDCompare
+{
+  bool operator()(const EventUsage &a, uint32_t eventID) const { return a.eventID < eventID; }
+  bool operator()(uint32_t eventID, const EventUsage &a) const { return eventID < a.eventID; }
+};
+
+ResourceUsageIndex::ResourceUsageIndex(const vector<EventUsage> &usage) : m_Uses(usage)
+{
+  // drivers generally already sort their uses, in which case this is cheap
+  std::sort(m_Uses.begin(), m_Uses.end());
+
+  for(size_t i = 0; i < m_Uses.size(); i++)
+    if(IsWriteUsage(m_Uses[i].usage))
+      m_Writes.push_back(m_Uses[i]);
+}
+
+vector<EventUsage> ResourceUsageIndex::GetUsage(uint32_t minEventID, uint32_t maxEventID,
+                                                bool writesOnly) const
+{
+  const vector<EventUsage> &uses = writesOnly ? m_Writes : m_Uses;
+
+  if(minEventID > maxEventID)
+    return vector<EventUsage>();
+
+  auto first = std::lower_bound(uses.begin(), uses.end(), minEventID, EventUsageEIDCompare());
+  auto last = std::upper_bound(first, uses.end(), maxEventID, EventUsageEIDCompare());
+
+  return vector<EventUsage>(first, last);
+}
+
+EventUsage ResourceUsageIndex::GetLastWrite(uint32_t eventID) const
+{
+  auto it = std::upper_bound(m_Writes.begin(), m_Writes.end(), eventID, EventUsageEIDCompare());
+
+  if(it == m_Writes.begin())
+    return EventUsage();
+
+  --it;
+  return *it;
+}
+
+void ChunkProfiler::Init(Serialiser *ser)
+{
+  m_Enabled = atoi(RenderDoc::Inst().GetConfigSetting("replay.chunkTimings").c_str()) != 0;
+
+  ser->SetDecodeTiming(m_Enabled);
+}
+
+void ChunkProfiler::BeginChunk(Serialiser *ser)
+{
+  if(!m_Enabled)
+    return;
+
+  m_ChunkStart = Timing::GetTick();
+  m_DecodeStart = ser->GetDecodeTicks();
+  m_OffsetStart = ser->GetOffset();
+}
+
+void ChunkProfiler::EndChunk(Serialiser *ser, uint32_t chunk, bool loading)
+{
+  if(!m_Enabled)
+    return;
+
+  Stats &s = m_Stats[std::make_pair(loading, chunk)];
+  s.count++;
+  s.bytes += ser->GetOffset() - m_OffsetStart;
+  s.decode += ser->GetDecodeTicks() - m_DecodeStart;
+  s.total += Timing::GetTick() - m_ChunkStart;
+}
+
+vector<ChunkProfile> ChunkProfiler::GetProfile(const char *(*getChunkName)(uint32_t idx))
+{
+  vector<ChunkProfile> ret;
+
+  double freq = Timing::GetTickFrequency();
+
+  for(auto it = m_Stats.begin(); it != m_Stats.end(); ++it)
+  {
+    ChunkProfile prof;
+    prof.name = getChunkName(it->first.second);
+    prof.chunkID = it->first.second;
+    prof.loading = it->first.first;
+    prof.count = it->second.count;
+    prof.totalBytes = it->second.bytes;
+    prof.decodeTime = double(it->second.decode) / freq;
+    prof.executeTime = double(it->second.total - it->second.decode) / freq;
+    ret.push_back(prof);
+  }
+
+  struct SortProfile
+  {
+    bool operator()(const ChunkProfile &a, const ChunkProfile &b)
+    {
+      return a.decodeTime + a.executeTime > b.decodeTime + b.executeTime;
+    }
+  };
+
+  std::sort(ret.begin(), ret.end(), SortProfile());
+
+  return ret;
+}
+
 FloatVector HighlightCache::InterpretVertex(byte *data, uint32_t vert, const MeshDisplay &cfg,
                                             byte *end, bool useidx, bool &valid)
 {
@@ -89,6 +89,7 @@ public:
   virtual TextureDescription GetTexture(ResourceId id) = 0;
 
   virtual vector<DebugMessage> GetDebugMessages() = 0;
+  virtual vector<ChunkProfile> GetChunkProfile() = 0;
 
   virtual ShaderReflection *GetShader(ResourceId shader, string entryPoint) = 0;
 
@@ -128,6 +129,9 @@ public:
   virtual vector<GPUCounter> EnumerateCounters() = 0;
   virtual void DescribeCounter(GPUCounter counterID, CounterDescription &desc) = 0;
   virtual vector<CounterResult> FetchCounters(const vector<GPUCounter> &counterID) = 0;
+  // replays up to eventID without executing it, then times only that event. Returns a negative
+  // duration if events can't be isolated
+  virtual double GetIsolatedDuration(uint32_t eventID) = 0;
 
   virtual void FillCBufferVariables(ResourceId shader, string entryPoint, uint32_t cbufSlot,
                                     vector<ShaderVariable> &outvars, const vector<byte> &data) = 0;
@@ -210,6 +214,63 @@ DrawcallDescription *SetupDrawcallPointers(std::vector<DrawcallDescription *> *d
                                            DrawcallDescription *parent,
                                            DrawcallDescription *previous);
 
+// optional per chunk-type accounting of where time goes while loading and replaying a capture.
+// Drivers bracket each chunk they process with BeginChunk/EndChunk, and the time spent inside
+// SERIALISE_ELEMENT decoding is separated from the time spent executing the chunk.
+class ChunkProfiler
+{
+public:
+  ChunkProfiler() : m_Enabled(false), m_ChunkStart(0), m_DecodeStart(0), m_OffsetStart(0) {}
+  // enabled by the replay.chunkTimings config setting
+  void Init(Serialiser *ser);
+  bool IsEnabled() { return m_Enabled; }
+  void BeginChunk(Serialiser *ser);
+  void EndChunk(Serialiser *ser, uint32_t chunk, bool loading);
+
+  // returns the accumulated statistics, most expensive chunk types first
+  vector<ChunkProfile> GetProfile(const char *(*getChunkName)(uint32_t idx));
+
+private:
+  struct Stats
+  {
+    Stats() : count(0), bytes(0), decode(0), total(0) {}
+    uint32_t count;
+    uint64_t bytes;
+    uint64_t decode;
+    uint64_t total;
+  };
+
+  bool m_Enabled;
+  uint64_t m_ChunkStart;
+  uint64_t m_DecodeStart;
+  uint64_t m_OffsetStart;
+
+  // keyed by whether the chunk was processed during load, then the chunk type
+  map<pair<bool, uint32_t>, Stats> m_Stats;
+};
+
+// returns true if the usage can modify the contents of the resource
+bool IsWriteUsage(ResourceUsage usage);
+
+// the uses of a single resource sorted by EID, with the writing uses kept separately so that
+// queries for a range of events can binary search instead of scanning every use.
+class ResourceUsageIndex
+{
+public:
+  ResourceUsageIndex() {}
+  ResourceUsageIndex(const vector<EventUsage> &usage);
+
+  const vector<EventUsage> &GetUsage() const { return m_Uses; }
+  // uses with an EID in [minEventID, maxEventID]
+  vector<EventUsage> GetUsage(uint32_t minEventID, uint32_t maxEventID, bool writesOnly) const;
+  // the last writing use at or before eventID, or an EventUsage with EID 0 if there isn't one
+  EventUsage GetLastWrite(uint32_t eventID) const;
+
+private:
+  vector<EventUsage> m_Uses;
+  vector<EventUsage> m_Writes;
+};
+
 // simple cache for when we need buffer data for highlighting
 // vertices, typical use will be lots of vertices in the same
 // mesh, not jumping back and forth much between meshes.
@@ -237,27 +237,126 @@ struct CompressedFileIO
   size_t m_CompressSize;
 };
 
-Chunk::Chunk(Serialiser *ser, uint32_t chunkType, bool temporary)
+byte *ChunkPagePool::AllocPage()
 {
-  m_Length = (uint32_t)ser->GetOffset();
+  {
+    SCOPED_LOCK(m_Lock);
+    if(!m_FreePages.empty())
+    {
+      byte *ret = m_FreePages.back();
+      m_FreePages.pop_back();
+      return ret;
+    }
+  }
 
-  RDCASSERT(ser->GetOffset() < 0xffffffff);
+  return Serialiser::AllocAlignedBuffer(PageSize);
+}
 
-  m_ChunkType = chunkType;
+void ChunkPagePool::FreePages(std::vector<byte *> &pages)
+{
+  SCOPED_LOCK(m_Lock);
+  m_FreePages.insert(m_FreePages.end(), pages.begin(), pages.end());
+  pages.clear();
+}
 
-  m_Temporary = temporary;
+void ChunkPagePool::Trim()
+{
+  std::vector<byte *> pages;
 
-  if(ser->HasAlignedData())
   {
-    m_Data = Serialiser::AllocAlignedBuffer(m_Length);
-    m_AlignedData = true;
+    SCOPED_LOCK(m_Lock);
+    pages.swap(m_FreePages);
   }
-  else
+
+  for(size_t i = 0; i < pages.size(); i++)
+    Serialiser::FreeAlignedBuffer(pages[i]);
+}
+
+ChunkPagePool::~ChunkPagePool()
+{
+  Trim();
+}
+
+void ChunkArena::SetPool(ChunkPagePool *pool)
+{
+  Reset();
+
+  if(pool)
+    pool->AddRef();
+  if(m_Pool)
+    m_Pool->Release();
+
+  m_Pool = pool;
+}
+
+byte *ChunkArena::Alloc(size_t size, size_t alignment)
+{
+  if(m_Pool == NULL)
+    return NULL;
+
+  // anything that won't comfortably fit in a page gets its own allocation
+  if(size + alignment > ChunkPagePool::PageSize / 4)
+  {
+    byte *ret = Serialiser::AllocAlignedBuffer(size);
+    m_LargeAllocs.push_back(ret);
+    return ret;
+  }
+
+  size_t offs = AlignUp(m_Offset, alignment);
+
+  if(m_Pages.empty() || offs + size > ChunkPagePool::PageSize)
   {
-    m_Data = new byte[m_Length];
-    m_AlignedData = false;
+    m_Pages.push_back(m_Pool->AllocPage());
+    offs = 0;
   }
 
+  m_Offset = offs + size;
+
+  return m_Pages.back() + offs;
+}
+
+void ChunkArena::Reset()
+{
+  if(m_Pool)
+    m_Pool->FreePages(m_Pages);
+
+  for(size_t i = 0; i < m_LargeAllocs.size(); i++)
+    Serialiser::FreeAlignedBuffer(m_LargeAllocs[i]);
+
+  m_LargeAllocs.clear();
+  m_Offset = 0;
+}
+
+void ChunkArena::Swap(ChunkArena &other)
+{
+  std::swap(m_Pool, other.m_Pool);
+  m_Pages.swap(other.m_Pages);
+  m_LargeAllocs.swap(other.m_LargeAllocs);
+  std::swap(m_Offset, other.m_Offset);
+}
+
+Chunk::Chunk(Serialiser *ser, uint32_t chunkType, bool temporary, ChunkArena *arena)
+{
+  m_Length = (uint32_t)ser->GetOffset();
+
+  RDCASSERT(ser->GetOffset() < 0xffffffff);
+
+  m_ChunkType = chunkType;
+
+  m_Temporary = temporary;
+
+  m_AlignedData = ser->HasAlignedData();
+
+  // aligned data matches the default alignment of AllocAlignedBuffer
+  m_Data = NULL;
+  if(arena)
+    m_Data = arena->Alloc(m_Length, m_AlignedData ? 64 : 16);
+
+  m_ArenaData = (m_Data != NULL);
+
+  if(m_Data == NULL)
+    m_Data = m_AlignedData ? Serialiser::AllocAlignedBuffer(m_Length) : new byte[m_Length];
+
   memcpy(m_Data, ser->GetRawPtr(0), m_Length);
 
   if(ser->GetDebugText())
@@ -287,6 +386,7 @@ Chunk *Chunk::Duplicate()
   ret->m_ChunkType = m_ChunkType;
   ret->m_Temporary = m_Temporary;
   ret->m_AlignedData = m_AlignedData;
+  ret->m_ArenaData = false;
 
   if(m_AlignedData)
     ret->m_Data = Serialiser::AllocAlignedBuffer(m_Length);
@@ -318,7 +418,12 @@ Chunk::~Chunk()
   Atomic::ExchAdd64(&m_TotalMem, -int64_t(m_Length));
 #endif
 
-  if(m_AlignedData)
+  if(m_ArenaData)
+  {
+    // owned by the arena
+    m_Data = NULL;
+  }
+  else if(m_AlignedData)
   {
     if(m_Data)
       Serialiser::FreeAlignedBuffer(m_Data);
@@ -957,6 +1062,11 @@ void Serialiser::Reset()
   m_DebugText = "";
   m_DebugTextWriting = false;
 
+  m_DecodeTiming = false;
+  m_DecodeTicks = 0;
+  m_DecodeStart = 0;
+  m_DecodeDepth = 0;
+
   RDCEraseEl(m_KnownSections);
 
   m_HasError = false;
@@ -1802,6 +1912,8 @@ void Serialiser::SerialiseString(const char *name, string &el)
   }
   else
   {
+    ScopedDecodeTimer decodeTimer(this);
+
     memcpy(&el[0], ReadBytes(len), len);
 
     if(m_DebugTextWriting)
@@ -1891,6 +2003,8 @@ void Serialiser::SerialiseBuffer(const char *name, byte *&buf, size_t &len)
   }
   else
   {
+    ScopedDecodeTimer decodeTimer(this);
+
     ReadInto(bufLen);
 
     // ensure byte alignment
@@ -89,6 +89,65 @@ class Serialiser;
 class ScopedContext;
 struct CompressedFileIO;
 
+// A shared set of fixed-size pages that ChunkArenas allocate from, e.g. one per command pool so
+// that command buffers recorded and reset over and over recycle the same memory. It's refcounted
+// as arenas (and the chunks in them) can outlive whatever created the pool.
+class ChunkPagePool
+{
+public:
+  static const size_t PageSize = 64 * 1024;
+
+  ChunkPagePool() : m_RefCount(1) {}
+  void AddRef() { Atomic::Inc32(&m_RefCount); }
+  void Release()
+  {
+    if(Atomic::Dec32(&m_RefCount) == 0)
+      delete this;
+  }
+
+  byte *AllocPage();
+  void FreePages(std::vector<byte *> &pages);
+
+  // return any unused pages to the system
+  void Trim();
+
+private:
+  ~ChunkPagePool();
+
+  volatile int32_t m_RefCount;
+
+  Threading::CriticalSection m_Lock;
+  std::vector<byte *> m_FreePages;
+};
+
+// Linear allocator for chunk data. Allocation is a pointer bump, and resetting hands the pages
+// back to the pool in one go. Any chunks allocated from the arena must be deleted before it's
+// reset or destroyed.
+class ChunkArena
+{
+public:
+  ChunkArena() : m_Pool(NULL), m_Offset(0) {}
+  ~ChunkArena() { SetPool(NULL); }
+  // resets the arena, then takes a reference on the new pool
+  void SetPool(ChunkPagePool *pool);
+
+  // returns NULL if no pool has been set
+  byte *Alloc(size_t size, size_t alignment);
+  void Reset();
+  void Swap(ChunkArena &other);
+
+private:
+  // no copy semantics
+  ChunkArena(const ChunkArena &);
+  ChunkArena &operator=(const ChunkArena &);
+
+  ChunkPagePool *m_Pool;
+
+  std::vector<byte *> m_Pages;
+  std::vector<byte *> m_LargeAllocs;
+  size_t m_Offset;
+};
+
 // holds the memory, length and type for a given chunk, so that it can be
 // passed around and moved between owners before being serialised out
 class Chunk
@@ -110,8 +169,9 @@ public:
   static uint64_t TotalMem() { return 0; }
 #endif
 
-  // grab current contents of the serialiser into this chunk
-  Chunk(Serialiser *ser, uint32_t chunkType, bool temp);
+  // grab current contents of the serialiser into this chunk. If an arena is given the data is
+  // allocated from it instead of the heap.
+  Chunk(Serialiser *ser, uint32_t chunkType, bool temp, ChunkArena *arena = NULL);
 
   Chunk *Duplicate();
 
@@ -124,6 +184,7 @@ private:
   friend class ScopedContext;
 
   bool m_AlignedData;
+  bool m_ArenaData;
   bool m_Temporary;
 
   uint32_t m_ChunkType;
@@ -137,6 +198,21 @@ private:
 #endif
 };
 
+class Serialiser;
+
+// accumulates time spent decoding into the serialiser while decode timing is enabled, for the
+// chunk profiler. Only the read paths of the Serialise* functions use it, so writing while
+// capturing doesn't pay for it. Timers nest so an array and its elements are only counted once.
+class ScopedDecodeTimer
+{
+public:
+  ScopedDecodeTimer(Serialiser *s);
+  ~ScopedDecodeTimer();
+
+private:
+  Serialiser *m_Ser;
+};
+
 // this class has a few functions. It can be used to serialise chunks - on writing it enforces
 // that we only ever write a single chunk, then pull out the data into a Chunk class and erase
 // the contents of the serialiser ready to serialise the next (see the RDCASSERT at the start
@@ -348,6 +424,8 @@ public:
     }
     else if(m_Mode == READING)
     {
+      ScopedDecodeTimer decodeTimer(this);
+
       ReadInto(numElems);
 
       if(numElems > 0)
@@ -403,6 +481,8 @@ public:
     }
     else if(m_Mode == READING)
     {
+      ScopedDecodeTimer decodeTimer(this);
+
       ReadInto(Num);
 
       if(Num > 0)
@@ -441,6 +521,7 @@ public:
     }
     else if(m_Mode == READING)
     {
+      ScopedDecodeTimer decodeTimer(this);
       ReadInto(el);
     }
 
@@ -578,6 +659,27 @@ public:
   void SetDebugText(bool enabled) { m_DebugTextWriting = enabled; }
   bool GetDebugText() { return m_DebugTextWriting; }
   string GetDebugStr() { return m_DebugText; }
+  // when enabled, the time spent reading inside the Serialise* functions is accumulated so that
+  // the chunk profiler can separate the cost of deserialising a chunk from executing it.
+  void SetDecodeTiming(bool enabled)
+  {
+    m_DecodeTiming = enabled;
+    m_DecodeTicks = 0;
+    m_DecodeDepth = 0;
+  }
+  bool IsDecodeTiming() { return m_DecodeTiming; }
+  uint64_t GetDecodeTicks() { return m_DecodeTicks; }
+  // only the outermost of nested calls reads the clock
+  void BeginDecode()
+  {
+    if(m_DecodeDepth++ == 0)
+      m_DecodeStart = Timing::GetTick();
+  }
+  void EndDecode()
+  {
+    if(--m_DecodeDepth == 0)
+      m_DecodeTicks += Timing::GetTick() - m_DecodeStart;
+  }
 private:
   //////////////////////////////////////////
   // Raw memory buffer read/write
@@ -707,6 +809,12 @@ private:
   bool m_DebugTextWriting;
   string m_DebugText;
   ChunkLookup m_ChunkLookup;
+
+  // decode timing
+  bool m_DecodeTiming;
+  uint64_t m_DecodeTicks;
+  uint64_t m_DecodeStart;
+  uint32_t m_DecodeDepth;
 };
 
 template <>
@@ -741,6 +849,12 @@ public:
     return new Chunk(m_Ser, m_Idx, temporary);
   }
 
+  Chunk *Get(ChunkArena &arena)
+  {
+    End();
+    return new Chunk(m_Ser, m_Idx, false, &arena);
+  }
+
 private:
   uint32_t m_Idx;
   Serialiser *m_Ser;
@@ -757,6 +871,18 @@ private:
   }
 };
 
+inline ScopedDecodeTimer::ScopedDecodeTimer(Serialiser *s) : m_Ser(s->IsDecodeTiming() ? s : NULL)
+{
+  if(m_Ser)
+    m_Ser->BeginDecode();
+}
+
+inline ScopedDecodeTimer::~ScopedDecodeTimer()
+{
+  if(m_Ser)
+    m_Ser->EndDecode();
+}
+
 template <class T>
 struct ScopedDeserialise
 {
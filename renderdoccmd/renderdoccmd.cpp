@@ -570,6 +570,192 @@ struct ReplayCommand : public Command
   }
 };
 
+struct ProfileCommand : public Command
+{
+  virtual void AddOptions(cmdline::parser &parser)
+  {
+    parser.set_footer("<capture.rdc>");
+    parser.add<uint32_t>("loops", 'l', "The number of times to replay the whole frame.", false, 1);
+  }
+  virtual const char *Description()
+  {
+    return "Load and replay the log file, and print where the time went per chunk type.";
+  }
+  virtual bool IsInternalOnly() { return false; }
+  virtual bool IsCaptureCommand() { return false; }
+  virtual int Execute(cmdline::parser &parser, const CaptureOptions &)
+  {
+    if(parser.rest().empty())
+    {
+      std::cerr << "Error: profile command requires a filename to load." << std::endl
+                << std::endl
+                << parser.usage();
+      return 0;
+    }
+
+    string filename = parser.rest()[0];
+
+    // must be enabled before the capture is loaded so that the load itself is profiled
+    RENDERDOC_SetConfigSetting("replay.chunkTimings", "1");
+
+    ICaptureFile *file = RENDERDOC_OpenCaptureFile(filename.c_str());
+
+    if(file->OpenStatus() != ReplayStatus::Succeeded)
+    {
+      std::cerr << "Couldn't load '" << filename << "'." << std::endl;
+      return 1;
+    }
+
+    IReplayController *renderer = NULL;
+    ReplayStatus status = ReplayStatus::InternalError;
+    std::tie(status, renderer) = file->OpenCapture(NULL);
+
+    file->Shutdown();
+
+    if(status != ReplayStatus::Succeeded)
+    {
+      std::cerr << "Couldn't load and replay '" << filename << "'." << std::endl;
+      return 1;
+    }
+
+    rdctype::array<DrawcallDescription> draws = renderer->GetDrawcalls();
+
+    uint32_t lastEID = draws.count > 0 ? draws[draws.count - 1].eventID : 0;
+
+    for(uint32_t i = 0; i < parser.get<uint32_t>("loops"); i++)
+      renderer->SetFrameEvent(lastEID, true);
+
+    rdctype::array<ChunkProfile> profile = renderer->GetChunkProfile();
+
+    renderer->Shutdown();
+
+    char line[512];
+
+    snprintf(line, sizeof(line), "%-6s %-40s %8s %12s %12s %12s", "Stage", "Chunk", "Count",
+             "Size (KB)", "Decode (ms)", "Execute (ms)");
+    std::cout << line << std::endl;
+
+    for(int32_t i = 0; i < profile.count; i++)
+    {
+      const ChunkProfile &p = profile[i];
+
+      snprintf(line, sizeof(line), "%-6s %-40s %8u %12.1f %12.3f %12.3f",
+               p.loading ? "load" : "replay", p.name.elems, p.count,
+               double(p.totalBytes) / 1024.0, p.decodeTime, p.executeTime);
+      std::cout << line << std::endl;
+    }
+
+    return 0;
+  }
+};
+
+struct BenchmarkCommand : public Command
+{
+  virtual void AddOptions(cmdline::parser &parser)
+  {
+    parser.set_footer("<capture.rdc>");
+    parser.add<uint32_t>("warmup", 'w', "The number of replays to discard before timing.", false,
+                         2);
+    parser.add<uint32_t>("passes", 'p', "The number of timed replays.", false, 10);
+    parser.add<uint32_t>("event", 'e', "Time only this event, isolated from the rest of the frame.",
+                         false, 0);
+  }
+  virtual const char *Description()
+  {
+    return "Replay the log file repeatedly and print stable GPU timings for each event.";
+  }
+  virtual bool IsInternalOnly() { return false; }
+  virtual bool IsCaptureCommand() { return false; }
+  virtual int Execute(cmdline::parser &parser, const CaptureOptions &)
+  {
+    if(parser.rest().empty())
+    {
+      std::cerr << "Error: benchmark command requires a filename to load." << std::endl
+                << std::endl
+                << parser.usage();
+      return 0;
+    }
+
+    string filename = parser.rest()[0];
+
+    ICaptureFile *file = RENDERDOC_OpenCaptureFile(filename.c_str());
+
+    if(file->OpenStatus() != ReplayStatus::Succeeded)
+    {
+      std::cerr << "Couldn't load '" << filename << "'." << std::endl;
+      return 1;
+    }
+
+    IReplayController *renderer = NULL;
+    ReplayStatus status = ReplayStatus::InternalError;
+    std::tie(status, renderer) = file->OpenCapture(NULL);
+
+    file->Shutdown();
+
+    if(status != ReplayStatus::Succeeded)
+    {
+      std::cerr << "Couldn't load and replay '" << filename << "'." << std::endl;
+      return 1;
+    }
+
+    uint32_t eventID = parser.get<uint32_t>("event");
+
+    rdctype::array<EventDurationStats> stats = renderer->BenchmarkEventDurations(
+        parser.get<uint32_t>("warmup"), parser.get<uint32_t>("passes"), eventID);
+
+    renderer->Shutdown();
+
+    if(stats.count == 0)
+    {
+      if(eventID != 0)
+        std::cerr << "Couldn't time event " << eventID << " in isolation." << std::endl;
+      else
+        std::cerr << "No GPU timings available for '" << filename << "'." << std::endl;
+      return 1;
+    }
+
+    char line[512];
+
+    snprintf(line, sizeof(line), "%8s %8s %12s %12s %12s", "EID", "Samples", "Median (ms)",
+             "Min (ms)", "MAD (ms)");
+    std::cout << line << std::endl;
+
+    for(int32_t i = 0; i < stats.count; i++)
+    {
+      const EventDurationStats &s = stats[i];
+
+      snprintf(line, sizeof(line), "%8u %8u %12.4f %12.4f %12.4f", s.eventID, s.samples,
+               s.median * 1000.0, s.minimum * 1000.0, s.medianAbsDeviation * 1000.0);
+      std::cout << line << std::endl;
+    }
+
+    return 0;
+  }
+};
+
+struct SelfTestCommand : public Command
+{
+  virtual void AddOptions(cmdline::parser &parser) { parser.set_footer("[filter]"); }
+  virtual const char *Description() { return "Internal use only!"; }
+  virtual bool IsInternalOnly() { return true; }
+  virtual bool IsCaptureCommand() { return false; }
+  virtual int Execute(cmdline::parser &parser, const CaptureOptions &)
+  {
+    std::string filter = parser.rest().empty() ? "" : parser.rest()[0];
+
+    uint32_t failures = RENDERDOC_RunSelfTests(filter.c_str());
+
+    if(failures > 0)
+    {
+      std::cerr << failures << " self-test(s) failed, see " << RENDERDOC_GetLogFile()
+                << " for details." << std::endl;
+      return 1;
+    }
+
+    return 0;
+  }
+};
+
 struct CapAltBitCommand : public Command
 {
   virtual void AddOptions(cmdline::parser &parser)
@@ -703,7 +889,10 @@ int renderdoccmd(std::vector<std::string> &argv)
     add_command("inject", new InjectCommand());
     add_command("remoteserver", new RemoteServerCommand());
     add_command("replay", new ReplayCommand());
+    add_command("profile", new ProfileCommand());
+    add_command("benchmark", new BenchmarkCommand());
     add_command("capaltbit", new CapAltBitCommand());
+    add_command("selftest", new SelfTestCommand());
 
     if(argv.size() <= 1)
     {
@@ -779,6 +968,8 @@ int renderdoccmd(std::vector<std::string> &argv)
               "Capturing Option: Save all initial resource contents at frame start.");
       cmd.add("opt-capture-all-cmd-lists", 0,
               "Capturing Option: In D3D11, record all command lists from application start.");
+      cmd.add("opt-track-map-writes", 0,
+              "Capturing Option: Track writes to persistently mapped memory by page.");
     }
 
     cmd.parse_check(argv, true);
@@ -810,6 +1001,8 @@ int renderdoccmd(std::vector<std::string> &argv)
         opts.SaveAllInitials = true;
       if(cmd.exist("opt-capture-all-cmd-lists"))
         opts.CaptureAllCmdLists = true;
+      if(cmd.exist("opt-track-map-writes"))
+        opts.TrackMapWrites = true;
 
       opts.DelayForDebugger = (uint32_t)cmd.get<int>("opt-delay-for-debugger");
     }
@@ -80,5 +80,6 @@ public class CaptureOptions
         public bool SaveAllInitials;
         public bool CaptureAllCmdLists;
         public bool DebugOutputMute;
+        public bool TrackMapWrites;
     };
 };